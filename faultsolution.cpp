@@ -35,8 +35,10 @@ using namespace Taquart;
 FaultSolution::FaultSolution(void) {
   // Empty constructor
   DLA = 0.0;
+  Column = 0;
   U_n = 0;
   UERR = 0.0;
+  ROUNDS = 0;
   T0 = 0.0; /*!< Rupture time in seconds. */
   M0 = 0.0; /*!< Scalar moment tensor value in Nm. */
   MT = 0.0; /*!< Total seismic moment tensor value in Nm. */
@@ -85,6 +87,12 @@ FaultSolution::FaultSolution(const FaultSolution &Source) {
   Assign(Source);
 }
 
+//---------------------------------------------------------------------------
+FaultSolution::FaultSolution(FaultSolution &&Source) {
+  AssignValues(Source);
+  Amplitudes = std::move(Source.Amplitudes);
+}
+
 //---------------------------------------------------------------------------
 /*
  XMLNode FaultSolution::xmlExport(XMLExporter &Exporter, String SectionName,
@@ -276,6 +284,12 @@ void FaultSolution::sincos(double a, double *s, double *c) {
 
 //---------------------------------------------------------------------------
 void FaultSolution::Assign(const FaultSolution &Source) {
+  AssignValues(Source);
+  Amplitudes = Source.Amplitudes;
+}
+
+//---------------------------------------------------------------------------
+void FaultSolution::AssignValues(const FaultSolution &Source) {
   for (int i = 1; i < 4; i++)
     for (int j = 1; j < 4; j++)
       M[i][j] = Source.M[i][j];
@@ -312,15 +326,10 @@ void FaultSolution::Assign(const FaultSolution &Source) {
   QI = Source.QI;
   MAGN = Source.MAGN;
   Type = Source.Type;
-  for (unsigned int i = 0; i < FOCIMT_MAXCHANNEL; i++) {
-    U_th[i] = Source.U_th[i];
-    U_measured[i] = Source.U_measured[i];
-    Station[i] = Source.Station[i];
-  }
+  Column = Source.Column;
   U_n = Source.U_n;
-  //U_th = Source.U_th;
-  //U_measured = Source.U_measured;
   UERR = Source.UERR;
+  ROUNDS = Source.ROUNDS;
   for (unsigned int i = 0; i < 3; i++)
     E[i] = Source.E[i];
 }
@@ -331,6 +340,43 @@ FaultSolution & FaultSolution::operator=(const FaultSolution &Source) {
   return *this;
 }
 
+//---------------------------------------------------------------------------
+FaultSolution & FaultSolution::operator=(FaultSolution &&Source) {
+  AssignValues(Source);
+  Amplitudes = std::move(Source.Amplitudes);
+  return *this;
+}
+
+//---------------------------------------------------------------------------
+double FaultSolution::U_th(int i) const {
+  return Amplitudes->Theoretical[Column][i];
+}
+
+//---------------------------------------------------------------------------
+double FaultSolution::U_measured(int i) const {
+  return Amplitudes->Measured[i];
+}
+
+//---------------------------------------------------------------------------
+Taquart::String FaultSolution::Station(int i) const {
+  return (*Amplitudes->Names)[Amplitudes->Station[i]];
+}
+
+//---------------------------------------------------------------------------
+bool FaultSolution::U_influence(void) const {
+  return Amplitudes && Amplitudes->Leverage[Column].size() > 0;
+}
+
+//---------------------------------------------------------------------------
+double FaultSolution::U_leverage(int i) const {
+  return Amplitudes->Leverage[Column][i];
+}
+
+//---------------------------------------------------------------------------
+double FaultSolution::U_cook(int i) const {
+  return Amplitudes->Cook[Column][i];
+}
+
 //---------------------------------------------------------------------------
 Taquart::String FaultSolution::SubString(Taquart::String Line, int Start,
     int End) {
@@ -30,9 +30,29 @@
 #ifndef faultsolutionH
 #define faultsolutionH
 //---------------------------------------------------------------------------
+#include <vector>
+#include <memory>
 #include "moment_tensor.h"
 
 namespace Taquart {
+  //! Measured and theoretical amplitudes of a single inversion.
+  /*! The full, trace-null and double-couple solutions of an inversion
+   *  share one instance, and station names are kept once per event in
+   *  Names, referenced by index.
+   *  \ingroup foci
+   */
+  class ChannelAmplitudes {
+    public:
+      //! Station names of the event.
+      std::shared_ptr<const std::vector<Taquart::String> > Names;
+      std::vector<int> Station; /*!< Index of each channel in Names. */
+      std::vector<double> Measured; /*!< Measured amplitudes. */
+      std::vector<double> Theoretical[3]; /*!< Full, trace-null and DC. */
+      //! Leverage (diagonal of the hat matrix), empty for the L1 norm.
+      std::vector<double> Leverage[3];
+      std::vector<double> Cook[3]; /*!< Cook's distance, as Leverage. */
+  };
+
   //! Seismic moment tensor solution data structure.
   /*! This class the output data from the usmt.exe application -
    *  one of the solution (full, trace-null or double-couple) from the
@@ -89,14 +109,13 @@ namespace Taquart {
       double MAGN; /*!< Moment magnitude, calculated by the standard relationships. */
       Taquart::String Type; /*!< Fault type: can be 'Normal fault', 'Reverse fault' or a 'Strike fault' fault. */
       double Covariance[7][7]; /*!< Covariance matrix.*/
-      //std::vector<double> U_th;
-      //std::vector<double> U_measured;
-      double U_th[FOCIMT_MAXCHANNEL];
-      double U_measured[FOCIMT_MAXCHANNEL];
-      Taquart::String Station[FOCIMT_MAXCHANNEL];
-      int U_n;
+      //! Channel amplitudes, null unless requested from the inversion.
+      std::shared_ptr<const Taquart::ChannelAmplitudes> Amplitudes;
+      int Column; /*!< Column of Amplitudes->Theoretical of this solution. */
+      int U_n; /*!< Number of channels in Amplitudes (0 if none). */
       double UERR;
       double E[3];
+      int ROUNDS; /*!< Number of grid-search rounds made by the L1 solver (0 for L2). */
 
       // Public functions
 
@@ -111,17 +130,46 @@ namespace Taquart {
        */
       FaultSolution(const FaultSolution &Source);
 
+      //! Move constructor, takes over the channel amplitudes of Source.
+      /*! \param Source Reference to the source FaultSolution structure.
+       */
+      FaultSolution(FaultSolution &&Source);
+
       //! Assignment operator.
       /*! \param Source Reference to the source FaultSolution structure to copy.
        * \return Reference to the current struture (*this).
        */
       FaultSolution &operator=(const FaultSolution &Source);
 
+      //! Move assignment operator.
+      /*! \param Source Reference to the source FaultSolution structure.
+       * \return Reference to the current struture (*this).
+       */
+      FaultSolution &operator=(FaultSolution &&Source);
+
       //! Assign values from another FaultSolution object.
       /*! \param Source Reference to the source FaultSolution structure to copy.
        */
       void Assign(const FaultSolution &Source);
 
+      //! Theoretical amplitude of channel i (0..U_n-1).
+      double U_th(int i) const;
+
+      //! Measured amplitude of channel i (0..U_n-1).
+      double U_measured(int i) const;
+
+      //! Station name of channel i (0..U_n-1).
+      Taquart::String Station(int i) const;
+
+      //! True if the leverage and Cook's distance of the channels are known.
+      bool U_influence(void) const;
+
+      //! Leverage of channel i (0..U_n-1), see U_influence().
+      double U_leverage(int i) const;
+
+      //! Cook's distance of channel i (0..U_n-1), see U_influence().
+      double U_cook(int i) const;
+
       //! Save seismic moment tensor solution data into INI file.
       /* \param File Pointer to a \a TMemIniFile object to write data to it.
        * \param SectionName Name of the INI file section to write data to it.
@@ -149,6 +197,7 @@ namespace Taquart {
       //  String Description="");
       //void FillCovarianceStringList(TStringList *Output);
     private:
+      void AssignValues(const FaultSolution &Source);
       void sincos(double a, double *s, double *c);
       Taquart::String SubString(Taquart::String Line, int Start, int End);
 
@@ -27,6 +27,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <unistd.h>
 #include "focimtaux.h"
 #include "usmtcore.h"
 //-----------------------------------------------------------------------------
@@ -47,6 +49,7 @@ Taquart::TCColor PShadingColor = Taquart::TCColor(0.99, 0.99, 0.99);
 Taquart::TCColor StationPlusColor = Taquart::TCColor(0.0, 0.0, 0.0, 1.0);
 Taquart::TCColor StationMinusColor = Taquart::TCColor(0.0, 0.0, 0.0, 0.0);
 Taquart::TCColor StationTextColor = Taquart::TCColor(0.0, 0.0, 0.0);
+double TessellationTolerance = 0.0; // 0.0 - derived from canvas type.
 
 //-----------------------------------------------------------------------------
 bool ColorSelection(Taquart::String Input, unsigned int i) {
@@ -92,27 +95,6 @@ bool ColorSelection(Taquart::String Input, unsigned int i) {
     return false; // wrong number of input parameters
 }
 
-//-----------------------------------------------------------------------------
-bool MTInversion(Taquart::NormType NormType, int QualityType,
-    Taquart::SMTInputData &InputData, int channel, char type,
-    std::vector<Taquart::FaultSolutions> &FSList) {
-  try {
-    USMTCore(NormType, QualityType, InputData);
-    Taquart::FaultSolutions fs;
-    fs.Type = type;
-    fs.Channel = channel;
-    fs.FullSolution = TransferSolution(Taquart::stFullSolution);
-    fs.TraceNullSolution = TransferSolution(Taquart::stTraceNullSolution);
-    fs.DoubleCoupleSolution = TransferSolution(Taquart::stDoubleCoupleSolution);
-    FSList.push_back(fs);
-    return true;
-  }
-  catch (...) {
-    std::cout << "Inversion error." << std::endl;
-    return false;
-  }
-}
-
 //-----------------------------------------------------------------------------
 void SetFaultSolution(Taquart::FaultSolution &fu, double M11, double M12,
     double M13, double M22, double M23, double M33, double strike, double dip,
@@ -196,6 +178,7 @@ void GenerateBallCairo(Taquart::TriCairo_Meca &Meca,
   Meca.DrawStations = DrawStations;
   Meca.DrawCross = DrawCross;
   Meca.DrawDC = DrawDC;
+  Meca.BTolerance = TessellationTolerance;
 
   // Draw seismic moment tensor solution.
   Meca.Projection = WulffProjection ? Taquart::prWulff : Taquart::prSchmidt;
@@ -319,6 +302,140 @@ void GenerateBallCairo(Taquart::TriCairo_Meca &Meca,
 
 }
 
+//-----------------------------------------------------------------------------
+void GenerateBallRaster(Taquart::RasterMeca &Meca,
+    std::vector<Taquart::FaultSolutions> &FSList, Taquart::String Type) {
+
+  if (FSList.size() == 0)
+    return;
+
+  Taquart::FaultSolution * s = &FSList[0].DoubleCoupleSolution;
+  if (Type == "deviatoric") {
+    s = &FSList[0].TraceNullSolution;
+  }
+  else if (Type == "full") {
+    s = &FSList[0].FullSolution;
+  }
+
+  // Setup basic colors
+  Meca.BPlusColor = TShadingColor; // T color shading
+  Meca.BMinusColor = PShadingColor; // P color shading
+
+  // Draw seismic moment tensor solution.
+  Meca.Projection = WulffProjection ? Taquart::prWulff : Taquart::prSchmidt;
+  Meca.Hemisphere = LowerHemisphere ? Taquart::heLower : Taquart::heUpper;
+  Meca.Tensor(s->M);
+}
+
+//-----------------------------------------------------------------------------
+Taquart::String RenderCacheFile(Taquart::String CacheDir,
+    std::vector<Taquart::FaultSolutions> &FSList,
+    Taquart::SMTInputData &InputData, Taquart::String Type,
+    Taquart::String Format, Taquart::String Extension, unsigned int Size) {
+  Taquart::FNVHash h;
+
+  // Renderer revision. Change it whenever the drawing routines change.
+  h.Add(Taquart::String("focimt-render-1"));
+  h.Add(Type);
+  h.Add(Format);
+  h.Add(int(Size));
+
+  // Beach ball content and projection (-P, -B options).
+  bool flags[6] = { DrawStations, DrawAxes, DrawCross, DrawDC,
+      WulffProjection, LowerHemisphere };
+  h.Add(flags, sizeof(flags));
+  h.Add(TessellationTolerance);
+
+  // Colors (-c options).
+  Taquart::TCColor *colors[] = { &NFColor, &SSColor, &TFColor, &DCColor,
+      &TShadingColor, &PShadingColor, &StationPlusColor, &StationMinusColor,
+      &StationTextColor };
+  for (unsigned int i = 0; i < sizeof(colors) / sizeof(colors[0]); i++) {
+    h.Add(colors[i]->R);
+    h.Add(colors[i]->G);
+    h.Add(colors[i]->B);
+    h.Add(colors[i]->A);
+  }
+
+  // Tensor of the main solution and nodal planes of all solutions drawn.
+  // Nodal planes of the main solution are recalculated from the tensor in
+  // GenerateBallCairo, hence they are not part of the key.
+  for (unsigned int i = 0; i < FSList.size(); i++) {
+    Taquart::FaultSolution *s = &FSList[i].DoubleCoupleSolution;
+    if (Type == "deviatoric")
+      s = &FSList[i].TraceNullSolution;
+    else if (Type == "full")
+      s = &FSList[i].FullSolution;
+    if (i == 0) {
+      for (int k = 1; k <= 3; k++)
+        for (int l = 1; l <= 3; l++)
+          h.Add(s->M[k][l]);
+      continue;
+    }
+    h.Add(s->FIA);
+    h.Add(s->DLA);
+    h.Add(s->FIB);
+    h.Add(s->DLB);
+    h.Add(s->Type);
+  }
+
+  // Stations drawn.
+  if (DrawStations) {
+    for (unsigned int i = 0; i < InputData.Count(); i++) {
+      Taquart::SMTInputLine il;
+      InputData.Get(i, il);
+      h.Add(il.Name);
+      h.Add(il.Azimuth);
+      h.Add(il.TakeOff);
+      h.Add(il.Displacement);
+    }
+  }
+
+  return CacheDir + Taquart::String("/") + h.Hex() + "." + Extension;
+}
+
+//-----------------------------------------------------------------------------
+bool RenderCacheFetch(Taquart::String CacheFile, Taquart::String OutName) {
+  if (access(CacheFile.c_str(), R_OK) != 0)
+    return false;
+
+  // The cached image is copied (not linked), so that later writes to the
+  // output file cannot modify the cache, to a temporary file renamed over
+  // the output at the end.
+  char suffix[32];
+  sprintf(suffix, ".%d.tmp", int(getpid()));
+  Taquart::String TempFile = OutName + Taquart::String(suffix);
+  std::ifstream in(CacheFile.c_str(), std::ios::in | std::ios::binary);
+  std::ofstream out(TempFile.c_str(), std::ios::out | std::ios::binary);
+  if (!in || !out)
+    return false;
+  out << in.rdbuf();
+  out.close();
+  if (!out || rename(TempFile.c_str(), OutName.c_str()) != 0) {
+    remove(TempFile.c_str());
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void RenderCacheStore(Taquart::String CacheFile, Taquart::String OutName) {
+  // The image is copied (not linked), so that subsequent writes to the output
+  // file cannot modify the cache. The temporary file is renamed at the end to
+  // let concurrent runs share the cache directory.
+  char suffix[32];
+  sprintf(suffix, ".%d.tmp", int(getpid()));
+  Taquart::String TempFile = CacheFile + Taquart::String(suffix);
+  std::ifstream in(OutName.c_str(), std::ios::in | std::ios::binary);
+  std::ofstream out(TempFile.c_str(), std::ios::out | std::ios::binary);
+  if (!in || !out)
+    return;
+  out << in.rdbuf();
+  out.close();
+  if (!out || rename(TempFile.c_str(), CacheFile.c_str()) != 0)
+    remove(TempFile.c_str());
+}
+
 //-----------------------------------------------------------------------------
 void DispatchStations(Taquart::String &StationString,
     Taquart::SMTInputData &InputData) {
@@ -552,33 +669,6 @@ void DrawFault(Taquart::String FaultString, Taquart::String FilenameOut,
   Meca.Save(OutName);
 }
 
-//-----------------------------------------------------------------------------
-double rand_normal(double mean, double stddev) { //Box muller method
-  static double n2 = 0.0;
-  static int n2_cached = 0;
-  if (!n2_cached) {
-    double x, y, r;
-    do {
-      x = 2.0 * rand() / RAND_MAX - 1;
-      y = 2.0 * rand() / RAND_MAX - 1;
-
-      r = x * x + y * y;
-    } while (r == 0.0 || r > 1.0);
-    {
-      double d = sqrt(-2.0 * log(r) / r);
-      double n1 = x * d;
-      n2 = y * d;
-      double result = n1 * stddev + mean;
-      n2_cached = 1;
-      return result;
-    }
-  }
-  else {
-    n2_cached = 0;
-    return n2 * stddev + mean;
-  }
-}
-
 //-----------------------------------------------------------------------------
 void PrepareHelp(Options &listOpts) {
 // 0
@@ -601,9 +691,11 @@ void PrepareHelp(Options &listOpts) {
 // 3
   listOpts.addOption("t", "type",
       "Output file type.                                    \n\n"
-          "    Arguments: [NONE][PNG][SVG][PS][PDF] for different output file types.      \n"
-          "    Produce graphical representation of the moment tensor solution in a form of\n"
-          "    the beach ball. More than one output file format can be specified. The     \n"
+          "    Arguments: [NONE][PNG][SVG][PS][PDF][RASTER] for different output file     \n"
+          "    types. Produce graphical representation of the moment tensor solution in a \n"
+          "    form of the beach ball. More than one output file format can be specified. \n"
+          "    RASTER produces PNG file (*.raster.png) with a fast renderer that draws    \n"
+          "    the radiation pattern only (no nodal lines, axes and stations). The        \n"
           "    default value is '-t PNG'.                                                 \n",
       true);
 // 4
@@ -633,7 +725,7 @@ void PrepareHelp(Options &listOpts) {
 // 7
   listOpts.addOption("d", "dump",
       "Output data format and order.                        \n\n"
-          "    Arguments: [M][C][F][D][A][W][Q][T][U][*].                                 \n"
+          "    Arguments: [M][C][S][F][D][A][W][Q][T][U][*].                              \n"
           "    [M]: Moment tensor components in Aki's convention: M11,M12,M13,M22,M23,M33.\n"
           "         The moment tensor components are in [Nm]                              \n"
           "    [C]: Moment tensor components in CMT conventions: M33,M11,M22,M13,-M23,-M12\n"
@@ -641,6 +733,9 @@ void PrepareHelp(Options &listOpts) {
           "    [G]: Eigenvalues of the seismic moment tensor E1, E2, E3                   \n"
           "    [V]: Diagonal elements of the moment tensor covariance matrix in the       \n"
           "         following order: C11, C22, C33, C44, C55, C66                         \n"
+          "    [S]: Standard deviations propagated from the covariance matrix (L2 norm,   \n"
+          "         first-order): STRIKEA/DIPA/RAKEA/STRIKEB/DIPB/RAKEB, PTREND/PPLUNGE/  \n"
+          "         TTREND/TPLUNGE/BTREND/BPLUNGE [deg], ISO/CLVD/DBCP [%], M0 [Nm], MW.  \n"
           "    [D]: Decomposition of the moment tensor into Isotropic, Compensated linear \n"
           "         vector dipole and double-couple in format: ISO/CLVD/DBCP. The numbers \n"
           "         are provided in percents and calculated according to Jost and Herrmann\n"
@@ -662,8 +757,13 @@ void PrepareHelp(Options &listOpts) {
           "         strike-slip, normal or thrust faulting, respectively.                 \n"
           "    [U]: Vector of synthetic displacements calculated (the number of exported  \n"
           "         numbers correspond to the number of amplitudes in the input file.     \n"
+          "         For the L2 norm each channel is followed by its leverage (diagonal of \n"
+          "         the hat matrix) and Cook's distance, the influence of the channel on  \n"
+          "         the solution otherwise estimated by the jacknife test (-j).           \n"
           "    [E]: Scaled RMS Error calculated between theoretical and measured seismic  \n"
           "         moments.                                                              \n"
+          "    [R]: Number of grid search rounds made by the L1 solver (see -gt, -gc),    \n"
+          "         0 for the L2 norm.                                                    \n"
           "    [*]: Export new line character                                             \n"
           "                                                                               \n"
           "    NOTE #1:                                                                   \n"
@@ -802,4 +902,174 @@ void PrepareHelp(Options &listOpts) {
       true); // 27
   // 28
   listOpts.addOption("v", "version", "Display version information");
+  // 30
+  listOpts.addOption("tl", "tolerance",
+      "Beach ball outline tolerance                         \n\n"
+          "    Maximum deviation of the tessellated tensor outline from the true curve,   \n"
+          "    in pixels (PNG) or points (PDF/PS/SVG). Small values produce smooth        \n"
+          "    outlines for large figures, large values speed up drawing of thumbnails.   \n"
+          "    Default is 0.1 for PNG and 0.025 for vector formats.                       \n",
+      true);
+  // 31
+  listOpts.addOption("bc", "rendercache",
+      "Beach ball render cache directory                    \n\n"
+          "    Images are stored in the (existing) directory under a key computed from   \n"
+          "    the moment tensor, stations, projection, content, colors, size and format.\n"
+          "    Identical beach balls produced in subsequent runs are copied from the      \n"
+          "    cache instead of being drawn again.                                        \n",
+      true);
+  // 32
+  listOpts.addOption("ic", "inversioncache",
+      "Inversion result cache directory                     \n\n"
+          "    Solutions of each event are stored in the (existing) directory under a key \n"
+          "    computed from the station data and all options affecting the inversion    \n"
+          "    (-n, -j, -a, -rt, -rp, -rr, -ra, -rs, -gt, -gc, -ws, -ad, -qm, -gd and U   \n"
+          "    in -d). Events found in the cache are not inverted again. Results of -a    \n"
+          "    and -r* tests are cached only if the random seed is given (-rs).           \n",
+      true);
+  // 33
+  listOpts.addOption("rs", "seed",
+      "Random seed                                          \n\n"
+          "    Seed of the random number generator used by -a and -r* options. If given, \n"
+          "    the random sequence of each event depends only on the seed and the event  \n"
+          "    data, so the results are reproducible. By default the current time is     \n"
+          "    used.                                                                      \n",
+      true);
+  // 34
+  listOpts.addOption("gt", "gridtolerance",
+      "L1 grid search tolerances                            \n\n"
+          "    Arguments: tolx/tolf. The L1 solver stops refining the grid when the box   \n"
+          "    becomes smaller than tolx times the largest tensor component, or when the  \n"
+          "    misfit improves by less than tolf (relative) in three rounds in a row.     \n"
+          "    The default 0/0 always makes 50 rounds (e.g. -gt 1e-8/1e-6).               \n",
+      true);
+  // 35
+  listOpts.addOption("gc", "gridcoarse",
+      "L1 grid search coarse rounds                         \n\n"
+          "    Number of initial rounds of the L1 solver made on a 5-point grid instead of\n"
+          "    a 7-point grid in each dimension. The default is 0.                        \n",
+      true);
+  // 36
+  listOpts.addOption("ws", "warmstart",
+      "L1 warm start of resampled inversions                \n\n"
+          "    Inversions of -j, -a and -r* tests start the L1 grid searches of the full  \n"
+          "    and deviatoric solutions in a box around the reference solution, with the \n"
+          "    radius given in units of its error (ERR), e.g. -ws 10. The searches make  \n"
+          "    fewer rounds but cannot move far from the box. The default 0 switches the \n"
+          "    warm start off.                                                            \n",
+      true);
+  // 37
+  listOpts.addOption("dm", "daemon",
+      "Daemon mode                                          \n\n"
+          "    Serves inversions of events in the input file format read from the given \n"
+          "    Unix socket (e.g. -dm /tmp/focimt.sock) or from the standard input (-dm -)\n"
+          "    and writes one tab-separated line per solution, followed by a line       \n"
+          "    'fileid END count latency_us'. All inversion options apply to all events.\n",
+      true);
+  // 38
+  listOpts.addOption("dw", "workers",
+      "Daemon worker processes                              \n\n"
+          "    Number of worker processes serving socket connections in the daemon mode.\n"
+          "    The default is 1.                                                        \n",
+      true);
+  // 39
+  listOpts.addOption("sr", "ring",
+      "Shared-memory solution ring                          \n\n"
+          "    Publishes every finished inversion (event id, type, channel and the three\n"
+          "    solutions) into a ring in POSIX shared memory read by local consumers   \n"
+          "    through solutionring.h, e.g. -sr /focimt or -sr /focimt,1024 to keep the \n"
+          "    given number of records (default 4096).                                 \n",
+      true);
+  // 40
+  listOpts.addOption("st", "stats",
+      "Streaming statistics of -j, -a and -r* tests         \n\n"
+          "    Test solutions are not kept or written; their statistics are collected \n"
+          "    on the fly in constant memory and written to <name>-<type>-stat.asc:    \n"
+          "    mean and covariance of the six moment tensor components, circular mean  \n"
+          "    and deviation of strike, dip, rake and P/T axes, and 2.5/16/50/84/97.5% \n"
+          "    quantiles of M0, magnitude, EXPL, CLVD, DBCP and of the rotation angle  \n"
+          "    to the reference double couple. Disables the result cache (-ic).        \n");
+  // 41
+  listOpts.addOption("ad", "adaptive",
+      "Adaptive number of resampling samples                \n\n"
+          "    Arguments: tol[/batch]. Resampling (-r*) runs in batches of the given size \n"
+          "    (default 50) and stops when, for two batches in a row, none of: the 84%  \n"
+          "    rotation angle of the DC to the reference [deg], the 16-84% interval of  \n"
+          "    DC% and of M0 (relative to the median, in %) changed by more than tol,   \n"
+          "    e.g. -ad 0.5/50. The number of samples of -r* is the upper limit.       \n",
+      true);
+  // 42
+  listOpts.addOption("qm", "sampling",
+      "Sampling of test perturbations                       \n\n"
+          "    RANDOM (default) draws independent pseudo-random perturbations in -a and \n"
+          "    -r* tests. SOBOL uses a scrambled Sobol sequence mapped through the     \n"
+          "    inverse normal CDF for amplitudes and takeoff angles and stratified     \n"
+          "    polarity reversal and rejection patterns, which gives stable test       \n"
+          "    statistics with fewer samples (best with 2^k samples, e.g. -rr 256/0.1).\n",
+      true);
+  // 43
+  listOpts.addOption("lk", "leaveout",
+      "Leave-k-out station test                             \n\n"
+          "    Arguments: k[/threads]. L2 solutions of every subset with k stations  \n"
+          "    removed, solved from incrementally updated normal equations on the given\n"
+          "    number of threads (default: all processors), e.g. -lk 2 or -lk 3/8.   \n"
+          "    Written to <name>-subsets.asc: removed stations, DC rotation to the    \n"
+          "    reference [deg], M0, EXPL, CLVD, DBCP, trace-null M0, strike, dip and   \n"
+          "    rake, followed by the worst-case rotation, M0 and DBCP changes.        \n",
+      true);
+  // 44
+  listOpts.addOption("ls", "sectors",
+      "Azimuth sector station test                          \n\n"
+          "    As -lk, with every azimuth sector of the given width [deg] removed, one\n"
+          "    sector starting at each station azimuth, e.g. -ls 60.                 \n",
+      true);
+  // 45
+  listOpts.addOption("zs", "depthscan",
+      "Depth scan of the solution (with -m)                 \n\n"
+          "    Arguments: start/step/end[/workers] [m]. The event is also inverted for \n"
+          "    every source depth of the range (without tests), in parallel worker   \n"
+          "    processes (default: one per processor). Rays are traced once for each  \n"
+          "    station elevation, depth and distance. Written to <name>-<type>-scan.asc:\n"
+          "    northing and easting shift, depth, UERR, M0, MW, EXPL, CLVD, DBCP and   \n"
+          "    both nodal planes for every node, followed by the node of least UERR.  \n",
+      true);
+  // 46
+  listOpts.addOption("zh", "gridscan",
+      "Horizontal grid of the depth scan                    \n\n"
+          "    Arguments: step/n [m]. Extends -zs to a 3D grid of (2n+1)x(2n+1) epicentre\n"
+          "    shifts of the given step around the hypocentre, e.g. -zs 1000/100/3000  \n"
+          "    -zh 200/2.                                                            \n",
+      true);
+  // 47
+  listOpts.addOption("me", "models",
+      "Velocity model ensemble (with -m)                    \n\n"
+          "    Arguments: listfile[,workers]. The list holds one velocity model file \n"
+          "    per line (format of -m). Each model is read and its rays cached once for\n"
+          "    all events; every event is inverted for all models (without tests) in \n"
+          "    parallel worker processes. Written to <name>-<type>-models.asc: model, \n"
+          "    UERR, M0, MW, EXPL, CLVD, DBCP, both nodal planes and the DC rotation  \n"
+          "    to the -m solution [deg], followed by the spread of the solutions (as \n"
+          "    in -st) around the -m solution.                                       \n",
+      true);
+  // 48
+  listOpts.addOption("jm", "joint",
+      "Joint inversion with station corrections             \n\n"
+          "    Arguments: F|T[/damping[/threads]]. After all events are processed,   \n"
+          "    they are inverted together for full (F) or trace-null (T) moment      \n"
+          "    tensors and a log amplitude correction of every station recorded in  \n"
+          "    two or more events, damped with the given weight (default 0.01). L2  \n"
+          "    Gauss-Newton steps are solved by sparse LSQR on the given number of  \n"
+          "    threads (default: all processors), e.g. -jm T/0.05/8. Written to      \n"
+          "    <name>-joint.asc: moment tensor, M0, MW, EXPL, CLVD, DBCP, nodal plane\n"
+          "    and misfit without and with corrections per event, and the amplitude  \n"
+          "    factor of each station.                                               \n",
+      true);
+  // 49
+  listOpts.addOption("gd", "dcsearch",
+      "L1 double-couple search in strike, dip and rake      \n\n"
+          "    The L1 double-couple solution is searched on a strike/dip/rake grid    \n"
+          "    whose best nodes are refined by linearised L1 fits, instead of the    \n"
+          "    grid search of the moment tensor elements. Usually faster and with a  \n"
+          "    misfit equal to or lower than that of the default search; like the    \n"
+          "    default search, it does not guarantee the global minimum.             \n");
 }
@@ -31,9 +31,13 @@
 #define FOCIMTAUX_H_
 //-----------------------------------------------------------------------------
 #include "moment_tensor.h"
+#include "tricairo.h"
 #include "faultsolution.h"
 #include "inputdata.h"
 #include "getopts.h"
+#include "rastermeca.h"
+#include "solutioncache.h"
+#include "focimtlib.h"
 
 extern bool DrawStations;
 extern bool DrawAxes;
@@ -50,13 +54,10 @@ extern Taquart::TCColor PShadingColor;
 extern Taquart::TCColor StationPlusColor;
 extern Taquart::TCColor StationMinusColor;
 extern Taquart::TCColor StationTextColor;
+extern double TessellationTolerance;
 
 //-----------------------------------------------------------------------------
 bool ColorSelection(Taquart::String Input, unsigned int i);
-bool MTInversion(Taquart::NormType ANormType, int QualityType,
-    Taquart::SMTInputData &InputData, int channel, char type,
-    std::vector<Taquart::FaultSolutions> &FSList);
-double rand_normal(double mean, double stddev);
 void Dispatch2(Taquart::String &Input, double &v1, double &v2);
 void SetFaultSolution(Taquart::FaultSolution &fu, double M11, double M12,
     double M13, double M22, double M23, double M33, double strike, double dip,
@@ -67,6 +68,14 @@ void String2MT(Taquart::String &FaultString, double &M11, double &M12,
 void GenerateBallCairo(Taquart::TriCairo_Meca &Meca,
     std::vector<Taquart::FaultSolutions> &FSList,
     Taquart::SMTInputData &InputData, Taquart::String Type);
+Taquart::String RenderCacheFile(Taquart::String CacheDir,
+    std::vector<Taquart::FaultSolutions> &FSList,
+    Taquart::SMTInputData &InputData, Taquart::String Type,
+    Taquart::String Format, Taquart::String Extension, unsigned int Size);
+bool RenderCacheFetch(Taquart::String CacheFile, Taquart::String OutName);
+void RenderCacheStore(Taquart::String CacheFile, Taquart::String OutName);
+void GenerateBallRaster(Taquart::RasterMeca &Meca,
+    std::vector<Taquart::FaultSolutions> &FSList, Taquart::String Type);
 void String2SDR(Taquart::String &Input, double &strike, double &dip,
     double &rake);
 bool Dispatch(Taquart::String &Input, Taquart::String &Chunk,
@@ -0,0 +1,480 @@
+//-----------------------------------------------------------------------------
+// Source: focimtlib.cpp
+// Module: focimt
+// In-memory moment tensor inversion API (libfocimt).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "focimtlib.h"
+#include "focimtlib_c.h"
+#include "usmtcore.h"
+#include "resamplingstats.h"
+#include "qmc.h"
+
+//-----------------------------------------------------------------------------
+Taquart::InversionOptions::InversionOptions(void) {
+  Norm = Taquart::ntL2;
+  QualityType = 1;
+  JacknifeTest = false;
+  NoiseSamples = 0;
+  NoiseFactor = 1.0;
+  BootstrapSamples = 0;
+  BootstrapPercentReverse = 0.0;
+  BootstrapPercentReject = 0.0;
+  BootstrapAmplitudeModifier = 0.0;
+  BootstrapTakeoffModifier = 0.0;
+  SeedSet = false;
+  Seed = 0;
+  GridTolX = 0.0;
+  GridTolF = 0.0;
+  GridCoarse = 0;
+  DCSearch = false;
+  WarmStart = 0.0;
+  Residuals = false;
+  AdaptiveTolerance = 0.0;
+  AdaptiveBatch = 0;
+  Sampling = Taquart::smRandom;
+}
+
+//-----------------------------------------------------------------------------
+//! Passes the last test solution to the sink and drops it from the list.
+static void Forward(Taquart::SolutionSink * Sink,
+    std::vector<Taquart::FaultSolutions> &FSList, size_t First) {
+  if (Sink && FSList.size() > First + 1) {
+    Sink->Add(FSList.back());
+    FSList.pop_back();
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::Invert(const Taquart::SMTInputData &InputData,
+    const Taquart::InversionOptions &Options,
+    std::vector<Taquart::FaultSolutions> &FSList,
+    Taquart::SolutionSink * Sink) {
+  Taquart::UsmtCore::GSTOLX = Options.GridTolX;
+  Taquart::UsmtCore::GSTOLF = Options.GridTolF;
+  Taquart::UsmtCore::GSCOARSE = Options.GridCoarse;
+  Taquart::UsmtCore::DCSDR = Options.DCSearch;
+  Taquart::UsmtCore::WSRADIUS = Options.WarmStart;
+  Taquart::UsmtCore::RESIDUALS = Options.Residuals;
+  if (Options.SeedSet)
+    rand_seed(Options.Seed);
+
+  const Taquart::NormType InversionNormType = Options.Norm;
+  const int QualityType = Options.QualityType;
+
+  // Perform regular moment tensor inversion using all stations.
+  Taquart::SMTInputData fd = InputData;
+
+  // Station names are stored once for all inversions of the event: the
+  // lines are keyed by their position, which resampled data sets keep.
+  if (Options.Residuals) {
+    std::shared_ptr<std::vector<Taquart::String> > Names = std::make_shared<
+        std::vector<Taquart::String> >(fd.Count());
+    for (unsigned int j = 0; j < fd.Count(); j++) {
+      Taquart::SMTInputLine InputLine;
+      fd.Get(j, InputLine);
+      InputLine.Key = j;
+      fd.Set(j, InputLine);
+      (*Names)[j] = InputLine.Name;
+    }
+    Taquart::UsmtCore::NAMES = Names;
+  }
+  const size_t First = FSList.size();
+  const bool Result = MTInversion(InversionNormType, QualityType, fd, 0, 'N',
+      FSList);
+
+  // Reference solution for the warm start of resampled inversions (-ws).
+  // A copy, since FSList grows.
+  Taquart::FaultSolutions Reference;
+  const Taquart::FaultSolutions * Start = NULL;
+  if (FSList.size() > First) {
+    Reference = FSList[First];
+    Start = &Reference;
+    if (Sink)
+      Sink->Start(Reference);
+  }
+
+  // Perform additional moment tensor inversions.
+  if (Options.NoiseSamples > 0) {
+    const bool Sobol = Options.Sampling == Taquart::smSobol;
+    Taquart::SobolSequence Sequence(Sobol ? fd.Count() : 0);
+    for (unsigned int i = 0; i < Options.NoiseSamples; i++) {
+      Taquart::SMTInputData td = fd;
+      Taquart::SMTInputLine InputLine;
+
+      int sample;
+      double u1, u2, z;
+      for (unsigned int j = 0; j < td.Count(); j++) {
+        td.Get(j, InputLine);
+        if (Sobol)
+          z = Sequence.Normal(j);
+        else {
+          sample = rand();
+          u1 = (sample + 1) / (double(RAND_MAX) + 1);
+          sample = rand();
+          u2 = (sample + 1) / (double(RAND_MAX) + 1);
+          z = sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2);
+        }
+        InputLine.Displacement = InputLine.Displacement
+            + z / 3.0 * InputLine.Displacement * Options.NoiseFactor;
+        td.Set(j, InputLine);
+      }
+      if (Sobol)
+        Sequence.Next();
+
+      // Run MT inversion for biased dataset.
+      MTInversion(InversionNormType, QualityType, td, 0, 'A', FSList, Start);
+      Forward(Sink, FSList, First);
+    }
+  }
+  else if (Options.JacknifeTest) {
+    const unsigned int Count = fd.Count();
+
+    // Remove one channel, calculate the jacknife solution (option -j)
+    for (unsigned int i = 0; i < Count; i++) {
+      Taquart::SMTInputData td = fd;
+      Taquart::SMTInputLine InputLine;
+      td.Get(i, InputLine);
+      int channel = InputLine.Id;
+      td.Remove(i);
+
+      // Run MT inversion for jacknife dataset
+      MTInversion(InversionNormType, QualityType, td, channel, 'J', FSList,
+          Start);
+      Forward(Sink, FSList, First);
+    }
+  }
+  // Perform additional inversions using resampled datasets
+  // Options -rr/-rp/-ra/-rt
+  else if (Options.BootstrapSamples > 0) {
+    Taquart::SMTInputData BootstrapData;
+    Taquart::SMTInputLine InputLine;
+
+    // Adaptive mode (option -ad) needs the reference solution.
+    const bool Adaptive = Options.AdaptiveBatch > 0 && Start != NULL;
+    Taquart::ConvergenceMonitor Monitor(Options.AdaptiveTolerance);
+    if (Adaptive)
+      Monitor.Start(Reference);
+
+    const bool Sobol = Options.Sampling == Taquart::smSobol;
+    Taquart::SobolSequence Sequence(Sobol ? 4 * fd.Count() : 0);
+
+    for (unsigned int i = 0; i < Options.BootstrapSamples; i++) {
+
+      // Get original input data.
+      BootstrapData = fd;
+
+      if (Sobol) {
+        // Quasi-random pattern (option -qm): four dimensions per line of
+        // the full data set, lines are rejected from the end.
+        for (unsigned int j = BootstrapData.Count(); j-- > 0;) {
+          BootstrapData.Get(j, InputLine);
+          if (Options.BootstrapTakeoffModifier > 0.0)
+            InputLine.TakeOff = InputLine.TakeOff
+                + Options.BootstrapTakeoffModifier * Sequence.Normal(4 * j)
+                    / 3.0;
+          if (Options.BootstrapPercentReverse > 0.0
+              && Sequence.Uniform(4 * j + 1)
+                  < Options.BootstrapPercentReverse)
+            InputLine.Displacement = InputLine.Displacement * -1.0;
+          if (Options.BootstrapAmplitudeModifier > 0.0)
+            InputLine.Displacement = InputLine.Displacement
+                + Options.BootstrapAmplitudeModifier
+                    * Sequence.Normal(4 * j + 2) * InputLine.Displacement
+                    / 3.0;
+          BootstrapData.Set(j, InputLine);
+          if (Options.BootstrapPercentReject > 0.0
+              && Sequence.Uniform(4 * j + 3) < Options.BootstrapPercentReject)
+            BootstrapData.Remove(j);
+        }
+        Sequence.Next();
+      }
+      else {
+        // Proceed through phase data for single event.
+        double v;
+        for (unsigned int j = 0; j < BootstrapData.Count(); j++) {
+
+          // Randomly modify station takeoff angle (option -rt)
+          if (Options.BootstrapTakeoffModifier > 0.0) {
+            v = rand_normal(0.0, Options.BootstrapTakeoffModifier);
+            BootstrapData.Get(j, InputLine);
+            InputLine.TakeOff = InputLine.TakeOff + v / 3.0;
+            BootstrapData.Set(j, InputLine);
+          }
+
+          // Randomly reverse station polarity (option -rp)
+          if (Options.BootstrapPercentReverse > 0.0
+              && rand() % 10000 < Options.BootstrapPercentReverse * 10000.0) {
+            BootstrapData.Get(j, InputLine);
+            InputLine.Displacement = InputLine.Displacement * -1.0;
+            BootstrapData.Set(j, InputLine);
+          }
+
+          // Randomly modify station amplitude (option -ra)
+          if (Options.BootstrapAmplitudeModifier > 0.0) {
+            v = rand_normal(0.0, Options.BootstrapAmplitudeModifier);
+            BootstrapData.Get(j, InputLine);
+            InputLine.Displacement = InputLine.Displacement
+                + v * InputLine.Displacement / 3.0;
+            BootstrapData.Set(j, InputLine);
+          }
+
+          // Randomly reject stations (option -rr)
+          if (Options.BootstrapPercentReject > 0.0
+              && rand() % 10000 < Options.BootstrapPercentReject * 10000.0) {
+            BootstrapData.Remove(j);
+          }
+        }
+      }
+
+      int channel = i + 1;
+
+      // Run MT inversion for resampled dataset.
+      MTInversion(InversionNormType, QualityType, BootstrapData, channel, 'B',
+          FSList, Start);
+      if (Adaptive && FSList.size() > First + 1)
+        Monitor.Add(FSList.back());
+      Forward(Sink, FSList, First);
+
+      if (Adaptive && (i + 1) % Options.AdaptiveBatch == 0 && Monitor.Check())
+        break;
+    }
+  }
+
+  Taquart::UsmtCore::NAMES.reset();
+  return Result;
+}
+
+//-----------------------------------------------------------------------------
+Taquart::SMTInputLine Taquart::StationLine(Taquart::String Name,
+    unsigned int Id, Taquart::String Component, Taquart::String Phase,
+    double Moment, double Azimuth, double Incidence, double TakeOff,
+    double Velocity, double Distance, double Density) {
+  Taquart::SMTInputLine il;
+  il.Name = Name;
+  il.Id = Id;
+  il.Component = Component;
+  il.MarkerType = Phase;
+  il.Start = 0.0;
+  il.End = 0.0;
+  il.Duration = 0.0;
+  il.Displacement = Moment / cos(Incidence * M_PI / 180.0); // Vertical sensor.
+  il.Incidence = Incidence;
+  il.Azimuth = Azimuth;
+  il.TakeOff = TakeOff;
+  il.Distance = Distance;
+  il.Density = Density;
+  il.Velocity = Velocity;
+  il.PickActive = true;
+  il.ChannelActive = true;
+  return il;
+}
+
+//-----------------------------------------------------------------------------
+bool MTInversion(Taquart::NormType NormType, int QualityType,
+    Taquart::SMTInputData &InputData, int channel, char type,
+    std::vector<Taquart::FaultSolutions> &FSList,
+    const Taquart::FaultSolutions * Start) {
+  try {
+    USMTCore(NormType, QualityType, InputData, Start);
+    Taquart::FaultSolutions fs;
+    fs.Type = type;
+    fs.Channel = channel;
+    fs.FullSolution = TransferSolution(Taquart::stFullSolution);
+    fs.TraceNullSolution = TransferSolution(Taquart::stTraceNullSolution);
+    fs.DoubleCoupleSolution = TransferSolution(Taquart::stDoubleCoupleSolution);
+    FSList.push_back(std::move(fs));
+    return true;
+  }
+  catch (...) {
+    // Reported by the return value only: the daemon writes its responses to
+    // standard output.
+    return false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+static double n2 = 0.0;
+static int n2_cached = 0;
+
+//-----------------------------------------------------------------------------
+void rand_seed(unsigned int seed) {
+  // Reseed the generator and drop the cached Box-Muller deviate, so that the
+  // sequence depends on the seed only.
+  srand(seed);
+  n2_cached = 0;
+}
+
+//-----------------------------------------------------------------------------
+double rand_normal(double mean, double stddev) { //Box muller method
+  if (!n2_cached) {
+    double x, y, r;
+    do {
+      x = 2.0 * rand() / RAND_MAX - 1;
+      y = 2.0 * rand() / RAND_MAX - 1;
+
+      r = x * x + y * y;
+    } while (r == 0.0 || r > 1.0);
+    {
+      double d = sqrt(-2.0 * log(r) / r);
+      double n1 = x * d;
+      n2 = y * d;
+      double result = n1 * stddev + mean;
+      n2_cached = 1;
+      return result;
+    }
+  }
+  else {
+    n2_cached = 0;
+    return n2 * stddev + mean;
+  }
+}
+
+//-----------------------------------------------------------------------------
+namespace {
+  void CopySolution(const Taquart::FaultSolution &s, focimt_solution &o) {
+    const int m[6] = { 1, 1, 1, 2, 2, 3 };
+    const int n[6] = { 1, 2, 3, 2, 3, 3 };
+    for (int i = 0; i < 6; i++)
+      o.m[i] = s.M[m[i]][n[i]];
+    o.m0 = s.M0;
+    o.mt = s.MT;
+    o.err = s.ERR;
+    o.uerr = s.UERR;
+    o.expl = s.EXPL;
+    o.clvd = s.CLVD;
+    o.dbcp = s.DBCP;
+    o.strike[0] = s.FIA;
+    o.dip[0] = s.DLA;
+    o.rake[0] = s.RAKEA;
+    o.strike[1] = s.FIB;
+    o.dip[1] = s.DLB;
+    o.rake[1] = s.RAKEB;
+    o.p_trend = s.PXTR;
+    o.p_plunge = s.PXPL;
+    o.t_trend = s.TXTR;
+    o.t_plunge = s.TXPL;
+    o.b_trend = s.BXTR;
+    o.b_plunge = s.BXPL;
+    o.magnitude = s.MAGN;
+    o.t0 = s.T0;
+    o.rounds = s.ROUNDS;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ExportSolutions(const Taquart::FaultSolutions &fs,
+    focimt_result &r) {
+  r.type = fs.Type;
+  r.channel = fs.Channel;
+  CopySolution(fs.FullSolution, r.full);
+  CopySolution(fs.TraceNullSolution, r.tracenull);
+  CopySolution(fs.DoubleCoupleSolution, r.dc);
+}
+
+//-----------------------------------------------------------------------------
+void focimt_default_options(focimt_options * options) {
+  if (!options)
+    return;
+  Taquart::InversionOptions d;
+  options->norm = d.Norm == Taquart::ntL1 ? 1 : 2;
+  options->quality_type = d.QualityType;
+  options->jacknife = d.JacknifeTest ? 1 : 0;
+  options->noise_samples = d.NoiseSamples;
+  options->noise_factor = d.NoiseFactor;
+  options->bootstrap_samples = d.BootstrapSamples;
+  options->bootstrap_reverse = d.BootstrapPercentReverse;
+  options->bootstrap_reject = d.BootstrapPercentReject;
+  options->bootstrap_amplitude = d.BootstrapAmplitudeModifier;
+  options->bootstrap_takeoff = d.BootstrapTakeoffModifier;
+  options->seed_set = d.SeedSet ? 1 : 0;
+  options->seed = d.Seed;
+  options->grid_tolx = d.GridTolX;
+  options->grid_tolf = d.GridTolF;
+  options->grid_coarse = d.GridCoarse;
+  options->warm_start = d.WarmStart;
+  options->adaptive_tolerance = d.AdaptiveTolerance;
+  options->adaptive_batch = d.AdaptiveBatch;
+  options->sampling = d.Sampling == Taquart::smSobol ? 1 : 0;
+  options->dc_search = d.DCSearch ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+int focimt_invert(const focimt_station * stations, int nstations,
+    const focimt_options * options, focimt_result * results, int capacity) {
+  if (!stations || nstations <= 0)
+    return -1;
+  try {
+    Taquart::InversionOptions o;
+    if (options) {
+      o.Norm = options->norm == 1 ? Taquart::ntL1 : Taquart::ntL2;
+      o.QualityType = options->quality_type;
+      o.JacknifeTest = options->jacknife != 0;
+      o.NoiseSamples = options->noise_samples;
+      o.NoiseFactor = options->noise_factor;
+      o.BootstrapSamples = options->bootstrap_samples;
+      o.BootstrapPercentReverse = options->bootstrap_reverse;
+      o.BootstrapPercentReject = options->bootstrap_reject;
+      o.BootstrapAmplitudeModifier = options->bootstrap_amplitude;
+      o.BootstrapTakeoffModifier = options->bootstrap_takeoff;
+      o.SeedSet = options->seed_set != 0;
+      o.Seed = options->seed;
+      o.GridTolX = options->grid_tolx;
+      o.GridTolF = options->grid_tolf;
+      o.GridCoarse = options->grid_coarse;
+      o.WarmStart = options->warm_start;
+      o.AdaptiveTolerance = options->adaptive_tolerance;
+      o.AdaptiveBatch = options->adaptive_batch;
+      o.Sampling =
+          options->sampling == 1 ? Taquart::smSobol : Taquart::smRandom;
+      o.DCSearch = options->dc_search != 0;
+    }
+
+    Taquart::SMTInputData InputData;
+    for (int i = 0; i < nstations; i++) {
+      const focimt_station &s = stations[i];
+      Taquart::SMTInputLine il = Taquart::StationLine(
+          Taquart::String(s.name ? s.name : ""), i + 1,
+          Taquart::String(s.component ? s.component : ""),
+          Taquart::String(s.phase ? s.phase : ""), s.moment, s.azimuth,
+          s.incidence, s.takeoff, s.velocity, s.distance, s.density);
+      InputData.Add(il);
+    }
+
+    std::vector<Taquart::FaultSolutions> FSList;
+    if (!Taquart::Invert(InputData, o, FSList))
+      return -1;
+
+    for (size_t i = 0; i < FSList.size() && int(i) < capacity && results;
+        i++)
+      Taquart::ExportSolutions(FSList[i], results[i]);
+    return int(FSList.size());
+  }
+  catch (...) {
+    return -1;
+  }
+}
@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+// Source: focimtlib.h
+// Module: focimt
+// In-memory moment tensor inversion API (libfocimt).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef FOCIMTLIB_H_
+#define FOCIMTLIB_H_
+//-----------------------------------------------------------------------------
+#include "moment_tensor.h"
+#include "faultsolution.h"
+#include "inputdata.h"
+#include "focimtlib_c.h"
+
+//! \defgroup libfocimt In-memory inversion API.
+/*! The core of focimt (usmtcore, input data and fault solutions) built as
+ *  a library, without file parsing, option parsing and drawing. The headers
+ *  do not need Cairo (its part of trinity_library is declared in tricairo.h
+ *  and left out of the library by FOCIMT_NO_CAIRO, see make lib). The
+ *  inversion keeps its state in the UsmtCore namespace, so calls must not
+ *  be made from several threads at once. A C interface is declared in
+ *  focimtlib_c.h.
+ */
+
+namespace Taquart {
+
+  //! Sampling of the perturbations of noise and resampling tests.
+  /*! \ingroup libfocimt
+   */
+  enum SamplingType {
+    smRandom, /*!< Independent pseudo-random draws (rand()). */
+    smSobol /*!< Scrambled Sobol sequence (qmc.h). */
+  };
+
+  //! Options of the moment tensor inversion (command line equivalents).
+  /*! \ingroup libfocimt
+   */
+  class InversionOptions {
+    public:
+      Taquart::NormType Norm; /*!< Norm (-n). */
+      int QualityType; /*!< Quality index type. */
+      bool JacknifeTest; /*!< Jackknife test (-j). */
+      unsigned int NoiseSamples; /*!< Noise test samples, 0 - off (-a). */
+      double NoiseFactor; /*!< Noise test amplitude factor (-a). */
+      unsigned int BootstrapSamples; /*!< Resampling tests, 0 - off (-r*). */
+      double BootstrapPercentReverse; /*!< Polarity reversals (-rp). */
+      double BootstrapPercentReject; /*!< Station rejections (-rr). */
+      double BootstrapAmplitudeModifier; /*!< Amplitude noise (-ra). */
+      double BootstrapTakeoffModifier; /*!< Takeoff angle noise (-rt). */
+      bool SeedSet; /*!< Reseed the random generator with Seed. */
+      unsigned int Seed; /*!< Random seed (-rs). */
+      double GridTolX; /*!< L1 grid search box tolerance (-gt). */
+      double GridTolF; /*!< L1 grid search misfit tolerance (-gt). */
+      int GridCoarse; /*!< L1 grid search coarse rounds (-gc). */
+      bool DCSearch; /*!< L1 DC searched in strike, dip, rake (-gd). */
+      double WarmStart; /*!< L1 warm start radius of resamples (-ws). */
+      bool Residuals; /*!< Keep channel amplitudes in solutions (-d U). */
+      double AdaptiveTolerance; /*!< Adaptive resampling tolerance (-ad). */
+      unsigned int AdaptiveBatch; /*!< Adaptive resampling batch, 0 - off. */
+      Taquart::SamplingType Sampling; /*!< Perturbation sampling (-qm). */
+
+      //! Default constructor, options as in focimt without switches.
+      InversionOptions(void);
+  };
+
+  //! Receiver of the test solutions of Invert().
+  /*! \ingroup libfocimt
+   */
+  class SolutionSink {
+    public:
+      virtual ~SolutionSink(void) {
+      }
+
+      //! Called with the reference solution, before any test solution.
+      virtual void Start(const Taquart::FaultSolutions &Reference) {
+      }
+
+      //! Called with the solutions of each test inversion.
+      virtual void Add(const Taquart::FaultSolutions &fs) = 0;
+  };
+
+  //! Inverts the input data of a single event.
+  /*! The reference solution (type 'N') is followed by the solutions of
+   *  the noise ('A'), jackknife ('J') or resampling ('B') test selected
+   *  in Options, in this order of precedence. With AdaptiveBatch set, the
+   *  resampling test stops before BootstrapSamples once its uncertainty
+   *  measures converge (see ConvergenceMonitor); the channel number of the
+   *  last 'B' solution is the number of samples used.
+   *  \param InputData Station data.
+   *  \param Options Inversion options.
+   *  \param FSList Solutions are appended to this list.
+   *  \param Sink If given, test solutions are passed to it instead of
+   *    being appended to FSList.
+   *  \return \p false if the reference inversion failed.
+   */
+  bool Invert(const Taquart::SMTInputData &InputData,
+      const Taquart::InversionOptions &Options,
+      std::vector<Taquart::FaultSolutions> &FSList,
+      Taquart::SolutionSink * Sink = NULL);
+
+  //! Station data line as read from a focimt input file.
+  /*! \param Name Station name.
+   *  \param Id Station id number.
+   *  \param Component Component.
+   *  \param Phase Phase (marker type).
+   *  \param Moment Area below the first P-wave displacement pulse.
+   *  \param Azimuth Azimuth [deg].
+   *  \param Incidence Angle of incidence [deg].
+   *  \param TakeOff Takeoff angle [deg].
+   *  \param Velocity Velocity in the source [m/s].
+   *  \param Distance Source-station distance [m].
+   *  \param Density Density in the source [kg/m**3].
+   */
+  Taquart::SMTInputLine StationLine(Taquart::String Name, unsigned int Id,
+      Taquart::String Component, Taquart::String Phase, double Moment,
+      double Azimuth, double Incidence, double TakeOff, double Velocity,
+      double Distance, double Density);
+
+  //! Converts solutions to the plain structure of the C interface.
+  /*! \param fs Solutions of a single inversion.
+   *  \param r Output structure.
+   */
+  void ExportSolutions(const Taquart::FaultSolutions &fs, focimt_result &r);
+}
+
+//-----------------------------------------------------------------------------
+bool MTInversion(Taquart::NormType ANormType, int QualityType,
+    Taquart::SMTInputData &InputData, int channel, char type,
+    std::vector<Taquart::FaultSolutions> &FSList,
+    const Taquart::FaultSolutions * Start = NULL);
+double rand_normal(double mean, double stddev);
+void rand_seed(unsigned int seed);
+
+//-----------------------------------------------------------------------------
+#endif /* FOCIMTLIB_H_ */
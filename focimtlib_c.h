@@ -0,0 +1,113 @@
+//-----------------------------------------------------------------------------
+// Source: focimtlib_c.h
+// Module: focimt
+// C interface of libfocimt.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef FOCIMTLIB_C_H_
+#define FOCIMTLIB_C_H_
+/*---------------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Station data, as in a line of the focimt input file. */
+typedef struct focimt_station {
+  const char * name; /*!< Station name. */
+  const char * component; /*!< Component. */
+  const char * phase; /*!< Phase (marker type). */
+  double moment; /*!< Area below the first P-wave displacement pulse. */
+  double azimuth; /*!< Azimuth [deg]. */
+  double incidence; /*!< Angle of incidence [deg]. */
+  double takeoff; /*!< Takeoff angle [deg]. */
+  double velocity; /*!< Velocity in the source [m/s]. */
+  double distance; /*!< Source-station distance [m]. */
+  double density; /*!< Density in the source [kg/m**3]. */
+} focimt_station;
+
+/*! Inversion options, see Taquart::InversionOptions. */
+typedef struct focimt_options {
+  int norm; /*!< 1 - L1, 2 - L2. */
+  int quality_type;
+  int jacknife;
+  unsigned int noise_samples;
+  double noise_factor;
+  unsigned int bootstrap_samples;
+  double bootstrap_reverse;
+  double bootstrap_reject;
+  double bootstrap_amplitude;
+  double bootstrap_takeoff;
+  int seed_set;
+  unsigned int seed;
+  double grid_tolx;
+  double grid_tolf;
+  int grid_coarse;
+  double warm_start;
+  double adaptive_tolerance;
+  unsigned int adaptive_batch; /*!< 0 - fixed number of resamples. */
+  int sampling; /*!< 0 - pseudo-random, 1 - scrambled Sobol. */
+  int dc_search; /*!< 1 - L1 double-couple in strike, dip and rake. */
+} focimt_options;
+
+/*! A single solution (full, trace-null or double-couple). */
+typedef struct focimt_solution {
+  double m[6]; /*!< M11, M12, M13, M22, M23, M33 [Nm]. */
+  double m0; /*!< Scalar seismic moment [Nm]. */
+  double mt; /*!< Total seismic moment [Nm]. */
+  double err; /*!< Error of the solution [Nm]. */
+  double uerr; /*!< Relative RMS of the displacement residuals. */
+  double expl, clvd, dbcp; /*!< Decomposition [%]. */
+  double strike[2], dip[2], rake[2]; /*!< Nodal planes [deg]. */
+  double p_trend, p_plunge, t_trend, t_plunge, b_trend, b_plunge;
+  double magnitude; /*!< Moment magnitude. */
+  double t0; /*!< Rupture time [s]. */
+  int rounds; /*!< L1 grid search rounds. */
+} focimt_solution;
+
+/*! Solutions of a single inversion. */
+typedef struct focimt_result {
+  char type; /*!< 'N' - reference, 'A', 'J', 'B' - test inversions. */
+  int channel; /*!< Removed channel (J) or sample number (B). */
+  focimt_solution full;
+  focimt_solution tracenull;
+  focimt_solution dc;
+} focimt_result;
+
+/*! Fills options with the focimt defaults. */
+void focimt_default_options(focimt_options * options);
+
+/*! Inverts nstations stations of a single event. Up to capacity results
+ *  are stored in results (the reference solution first). Returns the total
+ *  number of results, which may exceed capacity, or -1 on error. */
+int focimt_invert(const focimt_station * stations, int nstations,
+    const focimt_options * options, focimt_result * results, int capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+#endif /* FOCIMTLIB_C_H_ */
@@ -0,0 +1,214 @@
+//-----------------------------------------------------------------------------
+// Source: gridsearch.h
+// Module: focimt
+// Refine-a-grid search engine of the L1 moment tensor solvers.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef GRIDSEARCH_H_
+#define GRIDSEARCH_H_
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <algorithm>
+#include "usmtcore.h"
+
+namespace Taquart {
+  namespace UsmtCore {
+
+    //! Grid search with box refinement used by GSOL, GSOL5 and GSOLA.
+    /*! Each round evaluates a DENSITY^DIM regular grid over the current
+     *  box, then shrinks the box around the best node (two steps to each
+     *  side). The nested loops are generated at compile time.
+     *
+     *  At most ROUNDS rounds are made. The search stops earlier when the
+     *  box becomes narrower than GSTOLX times the largest element of the
+     *  solution, or when the misfit improves by no more than GSTOLF
+     *  (relative) in three rounds in a row. The first GSCOARSE rounds use
+     *  a COARSE^DIM grid and keep one step to each side of the best node.
+     *  All three are off (zero) by default.
+     *
+     *  A warm start replaces the initial box by Center +/- Radius and drops
+     *  the rounds the cold search would have needed to shrink its box to
+     *  that size, so both searches end with the same resolution.
+     *
+     *  The misfit functor MISFIT provides:
+     *   - double xtry[] - the trial vector, filled by the engine,
+     *   - int Index[DIM + 1] - element of xtry set by each loop level,
+     *   - int Prefix - number of leading levels whose partial sums of A*x
+     *     (see PREFIX) are kept by the engine,
+     *   - static const int NX - number of elements of xtry copied to the
+     *     solution,
+     *   - static const bool ABORT - give up when a round finds no candidate,
+     *   - void Round(void) - called before each round,
+     *   - template<class E> void Point(E &Engine, const double G[]) -
+     *     evaluates the innermost node, G holds the partial sum of the
+     *     Prefix levels (null if Prefix is 0); every candidate is passed to
+     *     Engine.Offer().
+     */
+    template<int DIM, int DENSITY, int ROUNDS, class MISFIT, int COARSE = 5>
+    class GridSearch {
+      public:
+        GridSearch(MISFIT &AMisfit) :
+            F(AMisfit), x(0), VAL(1.0e+30), NROUNDS(0), G(GSPREFIX) {
+        }
+
+        //! Runs the search.
+        /*! \param ax Solution, ax[1..MISFIT::NX].
+         *  \param IEXP Initial box is +/-10^IEXP in all dimensions.
+         *  \param Progress Offset passed to PROGRESS.
+         *  \param Center Warm start box center, indexed as MISFIT::xtry
+         *  (optional).
+         *  \param Radius Warm start box half-widths, indexed as Center.
+         *  \return False if the search was abandoned (MISFIT::ABORT).
+         */
+        bool Run(double ax[], int IEXP, int Progress,
+            const double Center[] = 0, const double Radius[] = 0) {
+          x = ax;
+          VAL = 1.0e+30;
+          NROUNDS = 0;
+          int rounds = ROUNDS;
+          if (Center && Radius) {
+            double r = 0.0;
+            for (int i = 1; i <= DIM; i++) {
+              xlo[i] = Center[F.Index[i]] - Radius[F.Index[i]];
+              xhi[i] = Center[F.Index[i]] + Radius[F.Index[i]];
+              ix[i] = 0;
+              r = std::max(r, Radius[F.Index[i]]);
+            }
+            const double shrink = double(DENSITY - 1)
+                / double(2 * ((DENSITY - 1) / 3));
+            if (r > 0.0 && r < pow(10.0, IEXP))
+              rounds -= int(log(pow(10.0, IEXP) / r) / log(shrink));
+            rounds = std::max(rounds, 1);
+          }
+          else
+            for (int i = 1; i <= DIM; i++) {
+              xlo[i] = -1.0 * pow(10.0, IEXP);
+              xhi[i] = pow(10.0, IEXP);
+              ix[i] = 0;
+            }
+          int stall = 0;
+          for (int l = 1; l <= rounds; l++) {
+            PROGRESS(l + Progress, 350);
+            const bool coarse = l <= GSCOARSE;
+            const int density = coarse ? COARSE : DENSITY;
+            const int half = (density - 1) / 3;
+            for (int i = 1; i <= DIM; i++)
+              xstep[i] = (xhi[i] - xlo[i]) / double(density - 1);
+            F.Round();
+            const double prev = VAL;
+            if (coarse)
+              Loop<COARSE, 1>::Run(*this);
+            else
+              Loop<DENSITY, 1>::Run(*this);
+            NROUNDS = l;
+            if (MISFIT::ABORT && VAL == 1.0e+30)
+              return false;
+            for (int i = 1; i <= DIM; i++) {
+              xhi[i] = xlo[i] + double(ix[i] + half - 1) * xstep[i];
+              xlo[i] = xlo[i] + double(ix[i] - half - 1) * xstep[i];
+            }
+            if (GSTOLX > 0.0) {
+              double width = 0.0, scale = 0.0;
+              for (int i = 1; i <= DIM; i++)
+                width = std::max(width, xhi[i] - xlo[i]);
+              for (int i = 1; i <= MISFIT::NX; i++)
+                scale = std::max(scale, fabs(x[i]));
+              if (width <= GSTOLX * scale)
+                break;
+            }
+            if (GSTOLF > 0.0 && prev < 1.0e+30) {
+              stall = prev - VAL <= GSTOLF * VAL ? stall + 1 : 0;
+              if (stall >= 3)
+                break;
+            }
+          }
+          return true;
+        }
+
+        //! Candidate with misfit TRY at the current node (F.xtry).
+        /*! Ties go to the latest candidate, as in the original code.
+         */
+        void Offer(double TRY) {
+          if (TRY > VAL)
+            return;
+          VAL = TRY;
+          for (int i = 1; i <= DIM; i++)
+            ix[i] = j[i];
+          for (int i = 1; i <= MISFIT::NX; i++)
+            x[i] = F.xtry[i];
+        }
+
+        //! Best misfit found.
+        double Value(void) {
+          return VAL;
+        }
+
+        //! Number of rounds made by the last Run().
+        int Rounds(void) {
+          return NROUNDS;
+        }
+
+      private:
+        MISFIT &F;
+        double * x;
+        double VAL;
+        int NROUNDS;
+        double xlo[DIM + 1], xhi[DIM + 1], xstep[DIM + 1];
+        int ix[DIM + 1], j[DIM + 1];
+        double * const * G; // Prefix sums, rows of the channel workspace.
+
+        template<int D, int LEVEL, bool LAST = (LEVEL > DIM)>
+        struct Loop;
+
+        template<int D, int LEVEL>
+        struct Loop<D, LEVEL, false> {
+            static void Run(GridSearch &S) {
+              for (int jj = 1; jj <= D; jj++) {
+                S.j[LEVEL] = jj;
+                const double xt = S.xlo[LEVEL]
+                    + double(jj - 1) * S.xstep[LEVEL];
+                S.F.xtry[S.F.Index[LEVEL]] = xt;
+                if (LEVEL <= S.F.Prefix)
+                  PREFIX(S.G[LEVEL], LEVEL > 1 ? S.G[LEVEL - 1] : 0,
+                      S.F.Index[LEVEL], xt);
+                Loop<D, LEVEL + 1>::Run(S);
+              }
+            }
+        };
+
+        template<int D, int LEVEL>
+        struct Loop<D, LEVEL, true> {
+            static void Run(GridSearch &S) {
+              S.F.Point(S, S.F.Prefix ? S.G[S.F.Prefix] : 0);
+            }
+        };
+    };
+
+  }
+}
+
+//-----------------------------------------------------------------------------
+#endif /* GRIDSEARCH_H_ */
@@ -167,7 +167,7 @@ unsigned int Taquart::SMTInputData::Add(Taquart::SMTInputLine &InputLine) {
 
 //---------------------------------------------------------------------------
 void Taquart::SMTInputData::Get(unsigned int Index,
-    Taquart::SMTInputLine &InputLine) throw (Taquart::TriEOutOfRange) {
+    Taquart::SMTInputLine &InputLine) {
   if (Index >= InputData.size())
     throw Taquart::TriEOutOfRange("Index out of range for "
         "Foci::SMTInputData class member: std::vector<SMTInputLine> InputData");
@@ -177,7 +177,7 @@ void Taquart::SMTInputData::Get(unsigned int Index,
 
 //---------------------------------------------------------------------------
 void Taquart::SMTInputData::Set(unsigned int Index,
-    Taquart::SMTInputLine &InputLine) throw (Taquart::TriEOutOfRange) {
+    Taquart::SMTInputLine &InputLine) {
   if (Index >= InputData.size())
     throw Taquart::TriEOutOfRange("Index out of range for "
         "Foci::SMTInputData class member: std::vector<SMTInputLine> InputData");
@@ -186,8 +186,7 @@ void Taquart::SMTInputData::Set(unsigned int Index,
 }
 
 //---------------------------------------------------------------------------
-double Taquart::SMTInputData::GetDisplacement(const unsigned int &Index)
-    throw (Taquart::TriEOutOfRange) {
+double Taquart::SMTInputData::GetDisplacement(const unsigned int &Index) {
   if (Index >= InputData.size())
     throw Taquart::TriEOutOfRange("Index out of range for "
         "Foci::SMTInputData class member: std::vector<SMTInputLine> InputData");
@@ -220,8 +219,7 @@ bool Taquart::SMTInputData::Find(int Key, unsigned int &Index) {
 
 //---------------------------------------------------------------------------
 
-void Taquart::SMTInputData::Remove(unsigned int Index)
-    throw (Taquart::TriEOutOfRange) {
+void Taquart::SMTInputData::Remove(unsigned int Index) {
   if (Index >= InputData.size())
     throw Taquart::TriEOutOfRange("Index out of range for "
         "Foci::SMTInputData class member: std::vector<SMTInputLine> InputData");
@@ -129,21 +129,27 @@ namespace Taquart {
       //! Get input data structure.
       /*! \param Index Index of line to get data from.
        *  \param InputLine Reference to input data structure.
+       *  \exception Taquart::TriEOutOfRange Index out of range.
        */
-      void Get(unsigned int Index, Taquart::SMTInputLine &InputLine) throw (Taquart::TriEOutOfRange);
+      void Get(unsigned int Index, Taquart::SMTInputLine &InputLine);
 
-      void Set(unsigned int Index, Taquart::SMTInputLine &InputLine) throw (Taquart::TriEOutOfRange);
+      //! Set input data structure.
+      /*! \exception Taquart::TriEOutOfRange Index out of range.
+       */
+      void Set(unsigned int Index, Taquart::SMTInputLine &InputLine);
 
       //! Get displacement (~seismic moment) value.
       /*! \param Index Index of line to get data from it.
        *  \return Displacement value.
+       *  \exception Taquart::TriEOutOfRange Index out of range.
        */
-      double GetDisplacement(const unsigned int &Index) throw (Taquart::TriEOutOfRange);
+      double GetDisplacement(const unsigned int &Index);
 
       //! Remove input data line.
       /*! \param Index Index of line to remove.
+       *  \exception Taquart::TriEOutOfRange Index out of range.
        */
-      void Remove(unsigned int Index) throw (Taquart::TriEOutOfRange);
+      void Remove(unsigned int Index);
 
       //! Return number of lines in input data table.
       /*! \return Number of lines of input tablel.
@@ -0,0 +1,624 @@
+//-----------------------------------------------------------------------------
+// Source: joint.cpp
+// Module: focimt
+// Joint inversion of clustered events with station corrections.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "joint.h"
+#include "usmtcore.h"
+#include "symsolve.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  //! Weight of the zero-sum constraint of the corrections, per event.
+  const double CONSTRAINT = 1.0;
+
+  //! Trend and plunge [deg] of an axis (x north, y east, z down).
+  Taquart::AXIS Axis(const double v[3]) {
+    double s = v[2] < 0.0 ? -1.0 : 1.0;
+    Taquart::AXIS a;
+    a.str = Taquart::zero_360(atan2(s * v[1], s * v[0]) * 180.0 / M_PI);
+    a.dip = asin(std::min(1.0, fabs(v[2]))) * 180.0 / M_PI;
+    return a;
+  }
+
+  //! Threads kept for a whole solve, so that the products of every LSQR
+  //! iteration do not start threads of their own.
+  class WorkerPool {
+    public:
+      typedef std::function<void(size_t, size_t, int)> Job;
+
+      WorkerPool(int AThreads) :
+          Threads(std::max(AThreads, 1)), Work(NULL), Count(0),
+          Generation(0), Pending(0), Quit(false) {
+        for (int t = 1; t < Threads; t++)
+          Pool.push_back(std::thread(&WorkerPool::Loop, this, t));
+      }
+
+      ~WorkerPool(void) {
+        {
+          std::lock_guard<std::mutex> Guard(Lock);
+          Quit = true;
+        }
+        Start.notify_all();
+        for (size_t t = 0; t < Pool.size(); t++)
+          Pool[t].join();
+      }
+
+      int Size(void) const {
+        return Threads;
+      }
+
+      //! Runs AWork(first, last, thread) on Threads contiguous parts of
+      //! 0..ACount-1 (the first part in the calling thread).
+      void Run(size_t ACount, const Job &AWork) {
+        if (Threads == 1) {
+          AWork(0, ACount, 0);
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> Guard(Lock);
+          Work = &AWork;
+          Count = ACount;
+          Pending = Threads - 1;
+          Generation++;
+        }
+        Start.notify_all();
+        AWork(0, ACount / Threads, 0);
+        std::unique_lock<std::mutex> Guard(Lock);
+        Done.wait(Guard, [this] {return Pending == 0;});
+      }
+
+    private:
+      const int Threads;
+      std::vector<std::thread> Pool;
+      std::mutex Lock;
+      std::condition_variable Start, Done;
+      const Job * Work;
+      size_t Count;
+      unsigned long long Generation;
+      int Pending;
+      bool Quit;
+
+      void Loop(int t) {
+        unsigned long long Seen = 0;
+        std::unique_lock<std::mutex> Guard(Lock);
+        for (;;) {
+          Start.wait(Guard, [&] {return Quit || Generation != Seen;});
+          if (Quit)
+            return;
+          Seen = Generation;
+          const Job * w = Work;
+          const size_t n = Count;
+          Guard.unlock();
+          (*w)(n * t / Threads, n * (t + 1) / Threads, t);
+          Guard.lock();
+          if (--Pending == 0)
+            Done.notify_one();
+        }
+      }
+  };
+
+  double Dot(const std::vector<double> &a, const std::vector<double> &b) {
+    double s = 0.0;
+    for (size_t i = 0; i < a.size(); i++)
+      s += a[i] * b[i];
+    return s;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---- Step: linearised problem at the current solution.
+//-----------------------------------------------------------------------------
+class Taquart::JointInversion::Step {
+  public:
+    //! Linearises the problem; without Corrections only the moment tensors
+    //! are unknown.
+    /*! LSQR solves for z in the preconditioned unknowns: the moment tensor
+     *  step of event i is R_i^-1 z_i, where R_i is the Cholesky factor of
+     *  the normal matrix of its block (so the blocks are orthonormal), and
+     *  the correction steps are scaled by the inverse norms of their
+     *  columns.
+     */
+    Step(Taquart::JointInversion &AOwner, bool ACorrections,
+        WorkerPool &APool) :
+        Owner(AOwner), Corrections(ACorrections), Pool(APool) {
+      const int P = Owner.P;
+      NC = 0;
+      for (size_t s = 0; s < Owner.Column.size(); s++)
+        NC = std::max(NC, Owner.Column[s] + 1);
+      NM = Owner.Events.size() * P;
+      Unknowns = NM + (Corrections ? NC : 0);
+      Equations = Owner.Rows.size() + (Corrections ? NC + 1 : 0);
+      Wc = CONSTRAINT * sqrt(double(Owner.Events.size()));
+      Wd = Owner.Damping;
+
+      Factor.resize(Owner.Stations.size());
+      for (size_t s = 0; s < Factor.size(); s++)
+        Factor[s] = exp(Owner.K[s]);
+      Predicted.resize(Owner.Rows.size());
+      R.assign(Owner.Events.size() * 36, 0.0);
+      Scale.assign(Corrections ? NC : 0, Wc * Wc + Wd * Wd);
+      for (size_t i = 0; i < Owner.Events.size(); i++) {
+        const Event &e = Owner.Events[i];
+        double N[6][6] = { { 0.0 } };
+        for (size_t r = e.First; r < e.First + e.Count; r++) {
+          const Row &w = Owner.Rows[r];
+          double p = 0.0;
+          for (int j = 0; j < P; j++)
+            p += w.a[j] * e.m[j];
+          Predicted[r] = p;
+          const double f = e.Weight * Factor[w.Station];
+          for (int j = 0; j < P; j++)
+            for (int k = 0; k <= j; k++)
+              N[j][k] += f * f * w.a[j] * w.a[k];
+          if (Corrections && Owner.Column[w.Station] >= 0)
+            Scale[Owner.Column[w.Station]] += f * f * p * p;
+        }
+        Cholesky(N, &R[36 * i]);
+      }
+      for (size_t c = 0; c < Scale.size(); c++)
+        Scale[c] = Scale[c] > 0.0 ? 1.0 / sqrt(Scale[c]) : 0.0;
+    }
+
+    //! Residuals of all equations at the current solution.
+    void Residual(std::vector<double> &b) const {
+      b.assign(Equations, 0.0);
+      for (size_t r = 0; r < Owner.Rows.size(); r++) {
+        const Row &w = Owner.Rows[r];
+        b[r] = Owner.Events[w.Event].Weight
+            * (w.u - Factor[w.Station] * Predicted[r]);
+      }
+      if (!Corrections)
+        return;
+      const size_t R = Owner.Rows.size();
+      for (size_t s = 0; s < Owner.Stations.size(); s++)
+        if (Owner.Column[s] >= 0) {
+          b[R] -= Wc * Owner.K[s];
+          b[R + 1 + Owner.Column[s]] = -Wd * Owner.K[s];
+        }
+    }
+
+    //! Solves the preconditioned problem min |J D z - b| by LSQR.
+    void Solve(const std::vector<double> &b, std::vector<double> &z) const {
+      const double Tol = 1e-8;
+      const size_t MaxIter = std::min<size_t>(4 * Unknowns + 100, 20000);
+      z.assign(Unknowns, 0.0);
+      std::vector<double> u = b, v(Unknowns), w, t;
+      double beta = sqrt(Dot(u, u));
+      const double bnorm = beta;
+      if (beta == 0.0)
+        return;
+      for (size_t i = 0; i < u.size(); i++)
+        u[i] /= beta;
+      MultiplyT(u, v);
+      double alpha = sqrt(Dot(v, v));
+      if (alpha == 0.0)
+        return;
+      for (size_t i = 0; i < v.size(); i++)
+        v[i] /= alpha;
+      w = v;
+      double phibar = beta, rhobar = alpha, anorm = 0.0;
+      for (size_t it = 0; it < MaxIter; it++) {
+        Multiply(v, t);
+        for (size_t i = 0; i < u.size(); i++)
+          u[i] = t[i] - alpha * u[i];
+        beta = sqrt(Dot(u, u));
+        anorm = sqrt(anorm * anorm + alpha * alpha + beta * beta);
+        if (beta > 0.0) {
+          for (size_t i = 0; i < u.size(); i++)
+            u[i] /= beta;
+          MultiplyT(u, t);
+          for (size_t i = 0; i < v.size(); i++)
+            v[i] = t[i] - beta * v[i];
+          alpha = sqrt(Dot(v, v));
+          if (alpha > 0.0)
+            for (size_t i = 0; i < v.size(); i++)
+              v[i] /= alpha;
+        }
+        else
+          alpha = 0.0;
+
+        const double rho = sqrt(rhobar * rhobar + beta * beta);
+        const double c = rhobar / rho, s = beta / rho;
+        const double theta = s * alpha;
+        const double phi = c * phibar;
+        rhobar = -c * alpha;
+        phibar = s * phibar;
+        for (size_t i = 0; i < z.size(); i++) {
+          z[i] += (phi / rho) * w[i];
+          w[i] = v[i] - (theta / rho) * w[i];
+        }
+        if (phibar <= Tol * bnorm
+            || phibar * alpha * fabs(c) <= Tol * anorm * phibar)
+          break;
+      }
+    }
+
+    //! Moves the solution by Length times the step of z.
+    void Apply(const std::vector<double> &z, double Length) {
+      const int P = Owner.P;
+      double d[6];
+      for (size_t i = 0; i < Owner.Events.size(); i++) {
+        Back(&R[36 * i], &z[i * P], d);
+        for (int j = 0; j < P; j++)
+          Owner.Events[i].m[j] += Length * d[j];
+      }
+      if (Corrections)
+        for (size_t s = 0; s < Owner.Stations.size(); s++)
+          if (Owner.Column[s] >= 0)
+            Owner.K[s] += Length * Scale[Owner.Column[s]]
+                * z[NM + Owner.Column[s]];
+    }
+
+  private:
+    Taquart::JointInversion &Owner;
+    bool Corrections;
+    WorkerPool &Pool;
+    int NC;
+    size_t NM, Unknowns, Equations;
+    double Wc, Wd;
+    std::vector<double> Factor; /*!< Amplitude factor of each station. */
+    std::vector<double> Predicted; /*!< a . m of each row. */
+    std::vector<double> R; /*!< Upper Cholesky factors of the blocks. */
+    std::vector<double> Scale; /*!< Inverse norms of correction columns. */
+
+    //! Upper triangular U (6x6 by rows) with U'U = N (lower triangle of N
+    //! used). Singular blocks get the square root of their diagonal.
+    void Cholesky(const double N[6][6], double U[36]) const {
+      const int P = Owner.P;
+      double Max = 0.0;
+      for (int j = 0; j < P; j++)
+        Max = std::max(Max, N[j][j]);
+      bool ok = Max > 0.0;
+      for (int j = 0; ok && j < P; j++) {
+        double d = N[j][j];
+        for (int k = 0; k < j; k++)
+          d -= U[6 * k + j] * U[6 * k + j];
+        if (d <= 1e-12 * Max) {
+          ok = false;
+          break;
+        }
+        U[6 * j + j] = sqrt(d);
+        for (int i = j + 1; i < P; i++) {
+          double s = N[i][j];
+          for (int k = 0; k < j; k++)
+            s -= U[6 * k + i] * U[6 * k + j];
+          U[6 * j + i] = s / U[6 * j + j];
+        }
+      }
+      if (ok)
+        return;
+      for (int j = 0; j < 36; j++)
+        U[j] = 0.0;
+      for (int j = 0; j < P; j++)
+        U[6 * j + j] = N[j][j] > 0.0 ? sqrt(N[j][j]) : 1.0;
+    }
+
+    //! Solves U d = z.
+    void Back(const double U[36], const double z[], double d[6]) const {
+      for (int i = Owner.P - 1; i >= 0; i--) {
+        double s = z[i];
+        for (int k = i + 1; k < Owner.P; k++)
+          s -= U[6 * i + k] * d[k];
+        d[i] = s / U[6 * i + i];
+      }
+    }
+
+    //! Solves U' z = g.
+    void Forward(const double U[36], const double g[6], double z[]) const {
+      for (int i = 0; i < Owner.P; i++) {
+        double s = g[i];
+        for (int k = 0; k < i; k++)
+          s -= U[6 * k + i] * z[k];
+        z[i] = s / U[6 * i + i];
+      }
+    }
+
+    //! y = J D z.
+    void Multiply(const std::vector<double> &z, std::vector<double> &y) const {
+      y.assign(Equations, 0.0);
+      Pool.Run(Owner.Events.size(), [&](size_t First, size_t Last, int) {
+        const int P = Owner.P;
+        double d[6];
+        for (size_t i = First; i < Last; i++) {
+          const Event &e = Owner.Events[i];
+          Back(&R[36 * i], &z[i * P], d);
+          for (size_t r = e.First; r < e.First + e.Count; r++) {
+            const Row &w = Owner.Rows[r];
+            double s = 0.0;
+            for (int j = 0; j < P; j++)
+              s += w.a[j] * d[j];
+            const int c = Owner.Column[w.Station];
+            if (Corrections && c >= 0)
+              s += Predicted[r] * Scale[c] * z[NM + c];
+            y[r] = e.Weight * Factor[w.Station] * s;
+          }
+        }
+      });
+      if (!Corrections)
+        return;
+      const size_t R = Owner.Rows.size();
+      for (int c = 0; c < NC; c++) {
+        y[R] += Wc * Scale[c] * z[NM + c];
+        y[R + 1 + c] = Wd * Scale[c] * z[NM + c];
+      }
+    }
+
+    //! z = D' J' y.
+    void MultiplyT(const std::vector<double> &y, std::vector<double> &z) const {
+      z.assign(Unknowns, 0.0);
+      const int T = Pool.Size();
+      std::vector<std::vector<double> > Local(T,
+          std::vector<double>(Corrections ? NC : 0, 0.0));
+      Pool.Run(Owner.Events.size(),
+          [&](size_t First, size_t Last, int t) {
+            const int P = Owner.P;
+            for (size_t i = First; i < Last; i++) {
+              const Event &e = Owner.Events[i];
+              double g[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+              for (size_t r = e.First; r < e.First + e.Count; r++) {
+                const Row &w = Owner.Rows[r];
+                const double fy = e.Weight * Factor[w.Station] * y[r];
+                for (int j = 0; j < P; j++)
+                  g[j] += w.a[j] * fy;
+                const int c = Owner.Column[w.Station];
+                if (Corrections && c >= 0)
+                  Local[t][c] += Predicted[r] * fy;
+              }
+              Forward(&R[36 * i], g, &z[i * P]);
+            }
+          });
+      if (!Corrections)
+        return;
+      const size_t R = Owner.Rows.size();
+      for (int c = 0; c < NC; c++) {
+        double s = Wc * y[R] + Wd * y[R + 1 + c];
+        for (int t = 0; t < T; t++)
+          s += Local[t][c];
+        z[NM + c] = Scale[c] * s;
+      }
+    }
+};
+
+//-----------------------------------------------------------------------------
+//---- JointInversion class.
+//-----------------------------------------------------------------------------
+Taquart::JointInversion::JointInversion(bool ADeviatoric, double ADamping) :
+    P(ADeviatoric ? 5 : 6), Damping(ADamping), Iterations(0) {
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::JointInversion::Add(Taquart::String Id,
+    Taquart::SMTInputData &InputData) {
+  using namespace Taquart::UsmtCore;
+  RDINP(InputData);
+  const int NS = ANGGA() ? Taquart::UsmtCore::N : 0;
+  if (NS == 0)
+    return false;
+  KERNEL();
+
+  Event e;
+  e.Id = Id;
+  e.First = Rows.size();
+  e.Count = NS;
+  e.Rms0 = e.Rms = 0.0;
+  for (int j = 0; j < 6; j++)
+    e.m[j] = 0.0;
+  double Norm = 0.0;
+  std::vector<int> Seen;
+  for (int i = 1; i <= NS; i++) {
+    Row w;
+    w.Event = Events.size();
+    const double * a = A[i];
+    if (P == 6)
+      for (int j = 0; j < 6; j++)
+        w.a[j] = a[j + 1];
+    else {
+      w.a[0] = a[1] - a[6];
+      w.a[1] = a[2];
+      w.a[2] = a[3];
+      w.a[3] = a[4] - a[6];
+      w.a[4] = a[5];
+      w.a[5] = 0.0;
+    }
+    w.u = U[i] * USMT_UPSCALE;
+    Norm += w.u * w.u;
+
+    Taquart::SMTInputLine Line;
+    InputData.Get(i - 1, Line);
+    std::string Name = Line.Name.c_str();
+    std::map<std::string, int>::iterator it = StationIndex.find(Name);
+    if (it == StationIndex.end()) {
+      it = StationIndex.insert(std::make_pair(Name, int(Stations.size()))).first;
+      Stations.push_back(Line.Name);
+      StationEvents.push_back(0);
+    }
+    w.Station = it->second;
+    if (std::find(Seen.begin(), Seen.end(), w.Station) == Seen.end()) {
+      Seen.push_back(w.Station);
+      StationEvents[w.Station]++;
+    }
+    Rows.push_back(w);
+  }
+  if (Norm == 0.0) {
+    for (size_t j = 0; j < Seen.size(); j++)
+      StationEvents[Seen[j]]--;
+    Rows.resize(e.First);
+    return false;
+  }
+  e.Weight = 1.0 / sqrt(Norm);
+  Events.push_back(e);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::JointInversion::Solve(int Threads, int MaxIterations) {
+  if (Events.empty())
+    return false;
+  if (Threads <= 0)
+    Threads = std::thread::hardware_concurrency();
+  Threads = std::max(1, std::min(Threads, int(Events.size())));
+  WorkerPool Pool(Threads);
+
+  K.assign(Stations.size(), 0.0);
+  Column.assign(Stations.size(), -1);
+  int NC = 0;
+  for (size_t s = 0; s < Stations.size(); s++)
+    if (StationEvents[s] >= 2)
+      Column[s] = NC++;
+  for (size_t i = 0; i < Events.size(); i++)
+    for (int j = 0; j < 6; j++)
+      Events[i].m[j] = 0.0;
+
+  // Relative misfit of each event at the current solution.
+  auto Misfit = [&](bool Joint) {
+    for (size_t i = 0; i < Events.size(); i++) {
+      Event &e = Events[i];
+      double s = 0.0;
+      for (size_t r = e.First; r < e.First + e.Count; r++) {
+        double p = 0.0;
+        for (int j = 0; j < P; j++)
+          p += Rows[r].a[j] * e.m[j];
+        const double d = e.Weight * (Rows[r].u - exp(K[Rows[r].Station]) * p);
+        s += d * d;
+      }
+      (Joint ? e.Rms : e.Rms0) = sqrt(s);
+    }
+  };
+
+  // Independent solutions (the problem is linear without corrections).
+  std::vector<double> b, x;
+  {
+    Step s(*this, false, Pool);
+    s.Residual(b);
+    s.Solve(b, x);
+    s.Apply(x, 1.0);
+  }
+  Misfit(false);
+
+  // Gauss-Newton steps, halved while they do not reduce the misfit.
+  Iterations = 0;
+  std::vector<double> m0(Events.size() * 6), K0;
+  while (NC > 0 && Iterations < MaxIterations) {
+    Step s(*this, true, Pool);
+    s.Residual(b);
+    const double Cost = Dot(b, b);
+    s.Solve(b, x);
+    for (size_t i = 0; i < Events.size(); i++)
+      std::copy(Events[i].m, Events[i].m + 6, &m0[6 * i]);
+    K0 = K;
+
+    double NewCost = Cost;
+    for (double Length = 1.0; Length > 1e-3; Length *= 0.5) {
+      s.Apply(x, Length);
+      Step t(*this, true, Pool);
+      t.Residual(b);
+      NewCost = Dot(b, b);
+      if (NewCost < Cost)
+        break;
+      for (size_t i = 0; i < Events.size(); i++)
+        std::copy(&m0[6 * i], &m0[6 * i] + 6, Events[i].m);
+      K = K0;
+    }
+    Iterations++;
+    if (NewCost >= Cost || Cost - NewCost <= 1e-6 * Cost)
+      break;
+  }
+  Misfit(true);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::JointInversion::Write(std::ostream &Out) {
+  using namespace Taquart::UsmtCore;
+  double Sum0 = 0.0, Sum = 0.0;
+  int NC = 0;
+  for (size_t i = 0; i < Events.size(); i++) {
+    Sum0 += Events[i].Rms0 * Events[i].Rms0;
+    Sum += Events[i].Rms * Events[i].Rms;
+  }
+  for (size_t s = 0; s < Column.size(); s++)
+    if (Column[s] >= 0)
+      NC++;
+  const double n = std::max<size_t>(Events.size(), 1);
+  Out << "JOINT" << FOCIMT_SEP << (P == 6 ? "F" : "T") << FOCIMT_SEP
+      << Events.size() << FOCIMT_SEP << NC << FOCIMT_SEP << Iterations
+      << FOCIMT_SEP << sqrt(Sum0 / n) << FOCIMT_SEP << sqrt(Sum / n)
+      << std::endl;
+
+  char txt[512];
+  for (size_t i = 0; i < Events.size(); i++) {
+    Event &e = Events[i];
+    double x[6 + 1], E[3 + 1], M0, MT, EXPL, CLVD, DBCP, Dum;
+    for (int j = 0; j < 6; j++)
+      x[j + 1] = e.m[j];
+    if (P == 5)
+      x[6] = -x[1] - x[4];
+    EIG3(x, 0, E);
+    SCALARMOMENT(E, M0, MT);
+    EIGGEN(E[1], E[2], E[3], EXPL, CLVD, DBCP, Dum, Dum, Dum);
+
+    double M[3][3] = { { x[1], x[2], x[3] }, { x[2], x[4], x[5] }, { x[3],
+        x[5], x[6] } };
+    double V[3][3], L[3], T[3], Pa[3];
+    SymmetricEigen3(M, L, V);
+    int t = 0, p = 0;
+    for (int j = 1; j < 3; j++) {
+      if (L[j] > L[t])
+        t = j;
+      if (L[j] < L[p])
+        p = j;
+    }
+    for (int j = 0; j < 3; j++) {
+      T[j] = V[j][t];
+      Pa[j] = V[j][p];
+    }
+    Taquart::nodal_plane NP1, NP2;
+    Taquart::axe2dc(Axis(T), Axis(Pa), &NP1, &NP2);
+
+    sprintf(txt, "%s%d%s%.4e%s%.4e%s%.4e%s%.4e%s%.4e%s%.4e%s%.4e%s%.2f"
+        "%s%.2f%s%.2f%s%.2f%s%.1f%s%.1f%s%.1f%s%.6f%s%.6f", FOCIMT_SEP,
+        int(e.Count), FOCIMT_SEP, x[1], FOCIMT_SEP, x[2],
+        FOCIMT_SEP, x[3], FOCIMT_SEP, x[4], FOCIMT_SEP, x[5], FOCIMT_SEP,
+        x[6], FOCIMT_SEP, M0, FOCIMT_SEP, mw(M0), FOCIMT_SEP, EXPL,
+        FOCIMT_SEP, CLVD, FOCIMT_SEP, DBCP, FOCIMT_SEP, NP1.str, FOCIMT_SEP,
+        NP1.dip, FOCIMT_SEP, NP1.rake, FOCIMT_SEP, e.Rms0, FOCIMT_SEP, e.Rms);
+    Out << e.Id.c_str() << txt << std::endl;
+  }
+
+  for (size_t s = 0; s < Stations.size(); s++)
+    Out << "STATION" << FOCIMT_SEP << Stations[s].c_str() << FOCIMT_SEP
+        << StationEvents[s] << FOCIMT_SEP
+        << (s < K.size() ? exp(K[s]) : 1.0) << std::endl;
+}
@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+// Source: joint.h
+// Module: focimt
+// Joint inversion of clustered events with station corrections.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef JOINT_H_
+#define JOINT_H_
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include <vector>
+#include <map>
+#include "inputdata.h"
+
+namespace Taquart {
+
+  //! L2 inversion of many events sharing stations, with station corrections.
+  /*! The amplitude of a channel of event i at station s is modelled as
+   *  exp(k_s) (a . m_i), where a is the kernel row of the channel, m_i the
+   *  moment tensor of the event (6 components, or 5 if trace-null) and k_s
+   *  the log amplitude correction of the station, common to all events.
+   *  Corrections are solved for stations recorded in at least two events;
+   *  their sum is constrained to zero and they are damped. Channels
+   *  of each event are weighted by the inverse norm of its amplitudes, so
+   *  that all events count equally.
+   *
+   *  The bilinear problem is solved by Gauss-Newton steps (the first one
+   *  with zero corrections, which gives the independent solutions). Each
+   *  step is a sparse least-squares problem with 7 (or 6) non-zeros per
+   *  row, solved by LSQR (Paige and Saunders, 1982) with column scaling.
+   *  The matrix is never formed: the products with it and its transpose
+   *  are split by events between threads.
+   *
+   *  Output (tab-separated): a header 'JOINT type events stations
+   *  iterations rms0 rms', a line per event with its id, number of
+   *  channels, M11 M12 M13 M22 M23 M33, M0, MW, EXPL, CLVD, DBCP, strike,
+   *  dip and rake of the first nodal plane and the relative rms misfit of
+   *  the independent (rms0) and joint (rms) solutions, and a STATION line
+   *  per station with its number of events and amplitude factor exp(k_s)
+   *  (1 if not corrected).
+   */
+  class JointInversion {
+    public:
+      //! Constructor.
+      /*! \param ADeviatoric Trace-null moment tensors if true, full if false.
+       *  \param ADamping Weight of the corrections k_s in the misfit, relative
+       *    to the normalised amplitudes of an event.
+       */
+      JointInversion(bool ADeviatoric, double ADamping = 0.01);
+
+      //! Adds the kernel rows of an event.
+      /*! Uses the UsmtCore state (not reentrant).
+       *  \return \p false if the event has no usable channels.
+       */
+      bool Add(Taquart::String Id, Taquart::SMTInputData &InputData);
+
+      //! Number of events added.
+      int Count(void) const {
+        return Events.size();
+      }
+
+      //! Solves the joint problem.
+      /*! \param Threads Number of threads (0 - one per processor).
+       *  \param MaxIterations Largest number of Gauss-Newton steps.
+       *  \return \p false if there are no events.
+       */
+      bool Solve(int Threads, int MaxIterations = 30);
+
+      //! Writes the solutions and station corrections.
+      void Write(std::ostream &Out);
+
+    private:
+      //! Channel of an event.
+      class Row {
+        public:
+          int Event, Station;
+          double a[6]; /*!< Kernel row (first P elements used). */
+          double u; /*!< Amplitude. */
+      };
+
+      //! Event and its current solution.
+      class Event {
+        public:
+          Taquart::String Id;
+          size_t First, Count; /*!< Its rows. */
+          double Weight; /*!< Inverse norm of its amplitudes. */
+          double m[6]; /*!< Moment tensor (first P elements). */
+          double Rms0, Rms; /*!< Relative misfit, independent and joint. */
+      };
+
+      //! Linearisation of the problem at the current solution.
+      class Step;
+
+      int P; /*!< Unknowns per event. */
+      double Damping;
+      int Iterations;
+      std::vector<Row> Rows;
+      std::vector<Event> Events;
+      std::vector<Taquart::String> Stations;
+      std::map<std::string, int> StationIndex;
+      std::vector<int> StationEvents; /*!< Events of each station. */
+      std::vector<int> Column; /*!< Correction column, -1 if fixed. */
+      std::vector<double> K; /*!< Log corrections. */
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* JOINT_H_ */
@@ -27,12 +27,21 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
+#include <string.h>
 #include "moment_tensor.h"
 #include "faultsolution.h"
 #include "inputdata.h"
 #include "usmtcore.h"
 #include "focimtaux.h"
 #include "traveltime.h"
+#include "server.h"
+#include "solutionring.h"
+#include "resamplingstats.h"
+#include "subsets.h"
+#include "uncertainty.h"
+#include "raygeometry.h"
+#include "variants.h"
+#include "joint.h"
 //-----------------------------------------------------------------------------
 
 using namespace std;
@@ -58,6 +67,10 @@ int main(int argc, char* argv[]) {
     Taquart::String DumpOrder = "";
     Taquart::String OutputFileType = "PNG";
     unsigned int Size = 500;
+    Taquart::String RenderCacheDir = "";
+    Taquart::String ResultCacheDir = "";
+    bool SeedSet = false;
+    unsigned int Seed = 0;
     bool JacknifeTest = false;
     bool BootstrapTest = false;
     unsigned int BootstrapSamples = 0;
@@ -74,6 +87,31 @@ int main(int argc, char* argv[]) {
     Taquart::String TakeoffString;
     double AmpFactor = 1.0f;
     unsigned int AmplitudeN = 100;
+    double GridTolX = 0.0;
+    double GridTolF = 0.0;
+    int GridCoarse = 0;
+    bool DCSearch = false;
+    double WarmStart = 0.0;
+    Taquart::String DaemonPath = "";
+    int DaemonWorkers = 1;
+    Taquart::String RingName = "";
+    unsigned int RingSlots = 4096;
+    bool StreamStats = false;
+    double AdaptiveTolerance = 0.0;
+    unsigned int AdaptiveBatch = 0;
+    Taquart::String Sampling = "RANDOM";
+    int LeaveOutK = 0;
+    int LeaveOutThreads = 0;
+    double SectorWidth = 0.0;
+    double ScanStart = 0.0, ScanStep = 0.0, ScanEnd = 0.0;
+    int ScanWorkers = 0;
+    double GridStep = 0.0;
+    int GridN = 0;
+    Taquart::String FilenameEnsemble = "";
+    int EnsembleWorkers = 0;
+    Taquart::String JointType = "";
+    double JointDamping = 0.01;
+    int JointThreads = 0;
     unsigned int i1;
     double v1, v2;
     Taquart::String Temp;
@@ -218,12 +256,139 @@ int main(int argc, char* argv[]) {
                 "(c) 2013-2017 Grzegorz Kwiatek and Patricia Martinez-Garzon"
                 << std::endl;
             break;
+          case 30: // Option -tl (beach ball outline tolerance)
+            TessellationTolerance = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToDouble();
+            break;
+          case 31: // Option -bc (beach ball render cache directory)
+            RenderCacheDir =
+                Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            break;
+          case 32: // Option -ic (inversion result cache directory)
+            ResultCacheDir =
+                Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            break;
+          case 33: // Option -rs (random seed)
+            SeedSet = true;
+            Seed = (unsigned int) Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToInt();
+            rand_seed(Seed);
+            break;
+          case 34: // Option -gt (L1 grid search tolerances)
+            Temp = Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            Dispatch2(Temp, v1, v2);
+            GridTolX = v1;
+            GridTolF = v2;
+            break;
+          case 35: // Option -gc (L1 grid search coarse rounds)
+            GridCoarse = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToInt();
+            break;
+          case 36: // Option -ws (L1 warm start of resampled inversions)
+            WarmStart = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToDouble();
+            break;
+          case 37: // Option -dm (daemon mode)
+            DaemonPath =
+                Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            break;
+          case 38: // Option -dw (daemon worker processes)
+            DaemonWorkers = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToInt();
+            break;
+          case 39: // Option -sr (shared-memory solution ring)
+            RingName =
+                Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            if (RingName.Pos(",") > 0) {
+              RingSlots = (unsigned int) RingName.SubString(
+                  RingName.Pos(",") + 1, RingName.Length()).ToInt();
+              RingName = RingName.SubString(1, RingName.Pos(",") - 1);
+            }
+            break;
+          case 40: // Option -st (streaming statistics of tests)
+            StreamStats = true;
+            break;
+          case 41: // Option -ad (adaptive number of resamples)
+            Temp = Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            AdaptiveBatch = 50;
+            if (Temp.Pos("/") > 0) {
+              AdaptiveBatch = (unsigned int) Temp.SubString(Temp.Pos("/") + 1,
+                  Temp.Length()).ToInt();
+              Temp = Temp.SubString(1, Temp.Pos("/") - 1);
+            }
+            AdaptiveTolerance = Temp.ToDouble();
+            break;
+          case 42: // Option -qm (sampling of test perturbations)
+            Sampling = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().UpperCase();
+            break;
+          case 43: // Option -lk (leave-k-out station test)
+            Temp = Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            if (Temp.Pos("/") > 0) {
+              LeaveOutThreads = Temp.SubString(Temp.Pos("/") + 1,
+                  Temp.Length()).ToInt();
+              Temp = Temp.SubString(1, Temp.Pos("/") - 1);
+            }
+            LeaveOutK = Temp.ToInt();
+            break;
+          case 44: // Option -ls (azimuth sector station test)
+            SectorWidth = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().ToDouble();
+            break;
+          case 45: // Option -zs (depth scan)
+            Temp = Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            if (sscanf(Temp.c_str(), "%lf/%lf/%lf/%d", &ScanStart, &ScanStep,
+                &ScanEnd, &ScanWorkers) < 3 || ScanStep <= 0.0
+                || ScanEnd < ScanStart) {
+              std::cout << "Invalid depth scan range." << std::endl;
+              ScanStep = 0.0;
+            }
+            break;
+          case 46: // Option -zh (horizontal grid of the depth scan)
+            Temp = Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            if (sscanf(Temp.c_str(), "%lf/%d", &GridStep, &GridN) != 2
+                || GridStep <= 0.0 || GridN < 0)
+              GridN = 0;
+            break;
+          case 47: // Option -me (velocity model ensemble)
+            FilenameEnsemble =
+                Taquart::String(listOpts.getArgs(switchInt).c_str()).Trim();
+            if (FilenameEnsemble.Pos(",") > 0) {
+              EnsembleWorkers = FilenameEnsemble.SubString(
+                  FilenameEnsemble.Pos(",") + 1,
+                  FilenameEnsemble.Length()).ToInt();
+              FilenameEnsemble = FilenameEnsemble.SubString(1,
+                  FilenameEnsemble.Pos(",") - 1);
+            }
+            break;
+          case 48: // Option -jm (joint inversion with station corrections)
+            JointType = Taquart::String(
+                listOpts.getArgs(switchInt).c_str()).Trim().UpperCase();
+            if (JointType.Pos("/") > 0) {
+              Temp = JointType.SubString(JointType.Pos("/") + 1,
+                  JointType.Length());
+              JointType = JointType.SubString(1, JointType.Pos("/") - 1);
+              if (Temp.Pos("/") > 0) {
+                JointThreads = Temp.SubString(Temp.Pos("/") + 1,
+                    Temp.Length()).ToInt();
+                Temp = Temp.SubString(1, Temp.Pos("/") - 1);
+              }
+              JointDamping = Temp.ToDouble();
+            }
+            if (!(JointType == "F" || JointType == "T")) {
+              std::cout << "Invalid joint inversion type." << std::endl;
+              JointType = "";
+            }
+            break;
+          case 49: // Option -gd (L1 double-couple searched in strike/dip/rake)
+            DCSearch = true;
+            break;
         }
       }
 
     if (FilenameIn.Length() == 0 && DrawFaultOnly == false
         && DrawFaultsOnly == false && VelocityModel == false
-        && DrawStationsOnly == false) {
+        && DrawStationsOnly == false && DaemonPath.Length() == 0) {
       std::cout << "You must provide a valid filename." << std::endl;
     }
 
@@ -240,22 +405,14 @@ int main(int argc, char* argv[]) {
     }
 
     //---- Read velocity model if necessary.
-    std::vector<double> Top;
-    std::vector<double> Velocity;
+    Taquart::VelocityModel1D Model;
+    const std::vector<double> &Top = Model.Top;
+    const std::vector<double> &Velocity = Model.Velocity;
     if (VelocityModel) {
       std::ifstream VelocityFile;
-      int n;
-      double v;
       VelocityFile.open(FilenameVelocity.c_str());
-      VelocityFile >> n;
-      for (int i = 0; i < n; i++) {
-        VelocityFile >> v;
-        Top.push_back(v);
-      }
-      for (int i = 0; i < n; i++) {
-        VelocityFile >> v;
-        Velocity.push_back(v);
-      }
+      Model.Name = FilenameVelocity;
+      Model.Read(VelocityFile);
 
       // If option -mt is on, get ranges for azimuths and takeoff and
       // output data to a text file.
@@ -356,7 +513,48 @@ int main(int argc, char* argv[]) {
     // Prepare processing structure.
     Taquart::NormType InversionNormType =
         (NormType == "L2") ? Taquart::ntL2 : Taquart::ntL1;
-    int Type = 1;
+    int QualityType = 1;
+
+    // Inversion options of all events.
+    Taquart::InversionOptions Options;
+    Options.Norm = InversionNormType;
+    Options.QualityType = QualityType;
+    Options.JacknifeTest = JacknifeTest;
+    Options.NoiseSamples = NoiseTest ? AmplitudeN : 0;
+    Options.NoiseFactor = AmpFactor;
+    Options.BootstrapSamples = BootstrapTest ? BootstrapSamples : 0;
+    Options.BootstrapPercentReverse = BootstrapPercentReverse;
+    Options.BootstrapPercentReject = BootstrapPercentReject;
+    Options.BootstrapAmplitudeModifier = BootstrapAmplitudeModifier;
+    Options.BootstrapTakeoffModifier = BootstrapTakeoffModifier;
+    Options.SeedSet = SeedSet;
+    Options.GridTolX = GridTolX;
+    Options.GridTolF = GridTolF;
+    Options.GridCoarse = GridCoarse;
+    Options.DCSearch = DCSearch;
+    Options.WarmStart = WarmStart;
+    Options.Residuals = DumpOrder.Pos("U") > 0 || DumpOrder.Pos("u") > 0;
+    Options.AdaptiveTolerance = AdaptiveTolerance;
+    Options.AdaptiveBatch = AdaptiveBatch;
+    Options.Sampling =
+        Sampling == "SOBOL" ? Taquart::smSobol : Taquart::smRandom;
+
+    // Daemon mode: serve events from standard input or a Unix socket.
+    if (DaemonPath.Length() > 0) {
+      Options.Seed = Seed;
+      Taquart::InversionServer Server(Options);
+      if (DaemonPath == "-")
+        return Server.ServeStdin();
+      return Server.ServeSocket(DaemonPath, DaemonWorkers);
+    }
+
+    // Publisher of finished solutions to local consumers.
+    Taquart::SolutionRing Ring;
+    if (RingName.Length() > 0 && !Ring.Open(RingName.c_str(), RingSlots)) {
+      std::cout << "Cannot open solution ring " << RingName.c_str()
+          << " (in use by another writer?)" << std::endl;
+      return 1;
+    }
 
     //---- Read input file and fill input data structures.
     Taquart::SMTInputData InputData;
@@ -365,70 +563,54 @@ int main(int argc, char* argv[]) {
     double azimuth = 0.0, takeoff = 0.0, velocity = 0.0, distance = 0.0,
         density = 0.0, aoi = 0.0;
 
+    // Rays of the -m model, kept for all events.
+    Taquart::RayCache Rays(Model);
+    Taquart::LocatedEvent Event;
+
+    // Models of the -me ensemble, read once and raytraced for all events.
+    std::vector<Taquart::VelocityModel1D> Ensemble;
+    std::vector<Taquart::RayCache> EnsembleRays;
+    if (FilenameEnsemble.Length() > 0 && !VelocityModel)
+      std::cout << "Option -me requires -m." << std::endl;
+    else if (FilenameEnsemble.Length() > 0) {
+      std::ifstream ListFile(FilenameEnsemble.c_str());
+      std::string Line;
+      while (std::getline(ListFile, Line)) {
+        Taquart::String Name = Taquart::String(Line.c_str()).Trim();
+        if (Name.Length() == 0 || Name[1] == '#')
+          continue;
+        Taquart::VelocityModel1D m;
+        if (m.Load(Name))
+          Ensemble.push_back(m);
+        else
+          std::cout << "Cannot read velocity model " << Name.c_str()
+              << std::endl;
+      }
+      // The caches keep references to the models, so they are created
+      // once the ensemble is complete.
+      EnsembleRays.reserve(Ensemble.size());
+      for (unsigned int i = 0; i < Ensemble.size(); i++)
+        EnsembleRays.push_back(Taquart::RayCache(Ensemble[i]));
+    }
+
+    // Kernel rows of all events for the joint inversion (option -jm).
+    Taquart::JointInversion Joint(JointType == "T", JointDamping);
+
     std::ifstream InputFile;
     InputFile.open(FilenameIn.c_str());
     while (InputFile.good()) {
       InputData.Clear();
       if (VelocityModel) {
-        // Reading formatted input file (velocity model format).
-        double e_northing = 0.0f, e_easting = 0.0f, e_z = 0.0f;
-        double s_northing = 0.0f, s_easting = 0.0f, s_z = 0.0f;
-        InputFile >> fileid;
-        InputFile >> N;
-        InputFile >> e_northing;
-        InputFile >> e_easting;
-        InputFile >> e_z;
-        InputFile >> density;
-        for (unsigned int i = 0; i < N; i++) {
-          InputFile >> id;
-          InputFile >> component;
-          InputFile >> phase;
-          InputFile >> moment; // Should hold the area below the first P-wave velocity pulse (=moment)
-          InputFile >> s_northing;
-          InputFile >> s_easting;
-          InputFile >> s_z;
-
-          // Calculation of azimuth, takeoff, velocity and distance.
-          double depth = fabs(e_z * 0.001);
-          double elevation = s_z * 0.001;
-          double epicentral_distance = 0.001
-              * sqrt(
-                  pow(s_northing - e_northing, 2.0)
-                      + pow(s_easting - e_easting, 2.0));
-          azimuth = atan2(s_easting - e_easting, s_northing - e_northing)
-              * 180/ M_PI;
-          double null;
-          bool null2;
-          int null3;
-
-          for (unsigned int j = Velocity.size() - 1; j >= 0; j--) {
-            if (depth >= Top[j]) {
-              velocity = Velocity[j];
-              break;
-            }
-          }
-          CalcTravelTime1D_2(elevation, depth, epicentral_distance, Top,
-              Velocity, null, takeoff, null2, aoi, null3, distance);
-          // Prepare input line structure.
-          Taquart::SMTInputLine il;
-          il.Name = Taquart::String(id); /*!< Station name.*/
-          il.Id = i + 1; /*!< Station id number.*/
-          il.Component = Taquart::String(component);
-          il.MarkerType = Taquart::String(phase);
-          il.Start = 0.0;
-          il.End = 0.0;
-          il.Duration = 0.0;
-          il.Displacement = moment / cos(aoi * M_PI / 180.0); // area below the first P wave pulse is divided by angle of incicence. (vertical sensor)
-          il.Incidence = aoi;
-          il.Azimuth = azimuth;
-          il.TakeOff = takeoff;
-          il.Distance = distance * 1000;
-          il.Density = density;
-          il.Velocity = velocity * 1000;
-          il.PickActive = true;
-          il.ChannelActive = true;
-          InputData.Add(il);
+        // Reading formatted input file (velocity model format). Azimuth,
+        // takeoff, velocity and distance are raytraced for the hypocentre.
+        if (Event.Read(InputFile)) {
+          Taquart::RayCache::Node Hypocentre;
+          Hypocentre.dNorthing = Hypocentre.dEasting = 0.0;
+          Hypocentre.Z = Event.Z;
+          Rays.Prepare(Event, Hypocentre, InputData);
         }
+        strncpy(fileid, Event.Id.c_str(), sizeof(fileid) - 1);
+        fileid[sizeof(fileid) - 1] = 0;
       }
       else {
         // Read formatted input file (standard foci-mt format)
@@ -475,114 +657,71 @@ int main(int argc, char* argv[]) {
       Taquart::FaultSolution fu, tr, dc;
 
       //=======================================================================
-      //==== Perform regular moment tensor inversions using all stations ======
+      //==== Look up the inversion cache ======================================
       //=======================================================================
-      MTInversion(InversionNormType, QualityType, InputData, 0, 'N', FSList);
+      // The key covers station data and all options affecting the inversion.
+      Taquart::FNVHash EventHash;
+      EventHash.Add(Taquart::String("focimt-inversion-1"));
+      EventHash.Add(InputData);
+      EventHash.Add(int(InversionNormType));
+      EventHash.Add(QualityType);
+      EventHash.Add(int(JacknifeTest));
+      EventHash.Add(int(NoiseTest));
+      EventHash.Add(AmpFactor);
+      EventHash.Add(int(AmplitudeN));
+      EventHash.Add(int(BootstrapTest));
+      EventHash.Add(int(BootstrapSamples));
+      EventHash.Add(BootstrapPercentReverse);
+      EventHash.Add(BootstrapPercentReject);
+      EventHash.Add(BootstrapAmplitudeModifier);
+      EventHash.Add(BootstrapTakeoffModifier);
+      EventHash.Add(int(SeedSet));
+      EventHash.Add(int(Seed));
+      EventHash.Add(GridTolX);
+      EventHash.Add(GridTolF);
+      EventHash.Add(GridCoarse);
+      EventHash.Add(WarmStart);
+
+      // With a fixed seed the random sequence of each event depends on the
+      // event data only, so cached and recomputed events are consistent.
+      Options.Seed = (unsigned int) (EventHash.Value()
+          ^ (EventHash.Value() >> 32));
+
+      // Cached entries keep channel amplitudes only if requested.
+      EventHash.Add(int(Options.Residuals));
+
+      // Adaptive resampling stops early, but draws the same sequence.
+      EventHash.Add(AdaptiveTolerance);
+      EventHash.Add(int(AdaptiveBatch));
+      EventHash.Add(int(Options.Sampling));
+      EventHash.Add(int(DCSearch));
+
+      // Random resampling without a fixed seed is not reproducible.
+      bool Cacheable = ResultCacheDir.Length() > 0 && !StreamStats
+          && (SeedSet || !(NoiseTest || BootstrapTest));
+      bool Cached = Cacheable
+          && Taquart::SolutionCache(ResultCacheDir).Load(EventHash.Hex(),
+              FSList);
 
       //=======================================================================
-      //==== Perform additional moment tensor inversions ======================
+      //==== Perform moment tensor inversions (reference and tests) ===========
       //=======================================================================
-      if (NoiseTest) {
-
-        const Taquart::SMTInputData fd = InputData;
-        for (unsigned int i = 0; i < AmplitudeN; i++) {
-          Taquart::SMTInputData td = fd;
-          Taquart::SMTInputLine InputLine;
-
-          int sample;
-          double u1, u2, z;
-          for (unsigned int j = 0; j < td.Count(); j++) {
-            td.Get(j, InputLine);
-            sample = rand();
-            u1 = (sample + 1) / (double(RAND_MAX) + 1);
-            sample = rand();
-            u2 = (sample + 1) / (double(RAND_MAX) + 1);
-            z = sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2);
-            InputLine.Displacement = InputLine.Displacement
-                + z / 3.0 * InputLine.Displacement * AmpFactor;
-            td.Set(j, InputLine);
-          }
-
-          // Run MT inversion for biased dataset.
-          MTInversion(InversionNormType, QualityType, td, 0, 'A', FSList);
-        }
+      // With -st only the reference solution stays in FSList.
+      Taquart::ResamplingStats Stats;
+      bool Inverted = false;
+      if (!Cached) {
+        Inverted = Taquart::Invert(InputData, Options, FSList,
+            StreamStats ? &Stats : NULL);
+        if (!Inverted)
+          std::cout << "Inversion error." << std::endl;
       }
-      else if (JacknifeTest) {
-        const Taquart::SMTInputData fd = InputData;
-        const unsigned int Count = InputData.Count();
-
-        // Remove one channel, calculate the jacknife solution (option -j)
-        for (unsigned int i = 0; i < Count; i++) {
-          Taquart::SMTInputData td = fd;
-          Taquart::SMTInputLine InputLine;
-          td.Get(i, InputLine);
-          int channel = InputLine.Id;
-          td.Remove(i);
-
-          // Run MT inversion for jacknife dataset
-          MTInversion(InversionNormType, QualityType, td, channel, 'J', FSList);
-        }
-      }
-      // Perform additional inversions using resampled datasets
-      // Options -rr/-rp/-ra/-rt
-      else if (BootstrapTest) {
-        Taquart::SMTInputData BootstrapData;
-        Taquart::SMTInputLine InputLine;
-
-        for (unsigned int i = 0; i < BootstrapSamples; i++) {
-
-          // Get original input data.
-          BootstrapData = InputData;
-
-          // Proceed through phase data for single event.
-          unsigned int st_rejected = 0;
-          unsigned int st_reversed = 0;
-          unsigned int st_ampmod = 0;
-          double v;
-          for (unsigned int j = 0; j < BootstrapData.Count(); j++) {
-
-            // Randomly modify station takeoff angle (option -rt)
-            if (BootstrapTakeoffModifier > 0.0) {
-              v = rand_normal(0.0, BootstrapTakeoffModifier);
-              BootstrapData.Get(j, InputLine);
-              InputLine.TakeOff = InputLine.TakeOff + v / 3.0;
-              BootstrapData.Set(j, InputLine);
-            }
 
-            // Randomly reverse station polarity (option -rp)
-            if (BootstrapPercentReverse > 0.0
-                && rand() % 10000 < BootstrapPercentReverse * 10000.0) {
-              BootstrapData.Get(j, InputLine);
-              InputLine.Displacement = InputLine.Displacement * -1.0;
-              BootstrapData.Set(j, InputLine);
-              st_reversed++;
-            }
+      // Failed inversions are not cached, so the next run retries them.
+      if (Cacheable && Inverted && FSList.size() > 0)
+        Taquart::SolutionCache(ResultCacheDir).Store(EventHash.Hex(), FSList);
 
-            // Randomly modify station amplitude (option -ra)
-            if (BootstrapAmplitudeModifier > 0.0) {
-              v = rand_normal(0.0, BootstrapAmplitudeModifier);
-              BootstrapData.Get(j, InputLine);
-              InputLine.Displacement = InputLine.Displacement
-                  + v * InputLine.Displacement / 3.0;
-              BootstrapData.Set(j, InputLine);
-              st_ampmod++;
-            }
-
-            // Randomly reject stations (option -rr)
-            if (BootstrapPercentReject > 0.0
-                && rand() % 10000 < BootstrapPercentReject * 10000.0) {
-              BootstrapData.Remove(j);
-              st_rejected++;
-            }
-          }
-
-          int channel = i + 1;
-
-          // Run MT inversion for resampled dataset.
-          MTInversion(InversionNormType, QualityType, BootstrapData, channel,
-              'B', FSList);
-        }
-      } // End MT inversion loop for different events
+      for (unsigned int i = 0; i < FSList.size(); i++)
+        Ring.Publish(fileid, FSList[i]);
 
       //=======================================================================
       //==== Produce output file and graphical representation of the MT =======
@@ -637,17 +776,23 @@ int main(int argc, char* argv[]) {
 
           // Export graphical representation
           if (OutputFileType.Pos("NONE") == 0 && j == 0) {
-            Taquart::String Formats[] = { "PNG", "SVG", "PS", "PDF" };
+            // RASTER is a fast, Cairo-free PNG renderer (radiation pattern only),
+            // with its own suffix so that it can be combined with PNG.
+            Taquart::String Formats[] = { "PNG", "SVG", "PS", "PDF",
+                "RASTER" };
+            Taquart::String Extensions[] = { "png", "svg", "ps", "pdf",
+                "raster.png" };
             Taquart::TriCairo_CanvasType ctype[] = { Taquart::ctSurface,
-                Taquart::ctSVG, Taquart::ctPS, Taquart::ctPDF };
+                Taquart::ctSVG, Taquart::ctPS, Taquart::ctPDF,
+                Taquart::ctSurface };
 
-            for (int q = 0; q < 4; q++) {
+            for (int q = 0; q < 5; q++) {
               if (OutputFileType.Pos(Formats[q])) {
                 try {
                   Taquart::String OutName;
                   if (FilenameOut.Length() == 0) {
                     OutName = Taquart::String(fileid) + "-" + FSuffix + "."
-                        + Formats[q].LowerCase();
+                        + Extensions[q];
                   }
                   else {
                     Taquart::String path;
@@ -655,15 +800,30 @@ int main(int argc, char* argv[]) {
                     SplitFilename(FilenameOut, file, path);
                     if (path == file) {
                       OutName = path + "-" + Taquart::String(fileid) + "-"
-                          + FSuffix + "." + Formats[q].LowerCase();
+                          + FSuffix + "." + Extensions[q];
                     }
                     else {
                       OutName = path + Taquart::String("/")
                           + Taquart::String(fileid) + "-" + FSuffix + "."
-                          + Formats[q].LowerCase();
+                          + Extensions[q];
                     }
                   }
-                  if (ctype[q] == Taquart::ctSurface) {
+
+                  // Reuse an identical image from the render cache.
+                  Taquart::String CacheFile = "";
+                  if (RenderCacheDir.Length()) {
+                    CacheFile = RenderCacheFile(RenderCacheDir, FSList,
+                        InputData, FSuffix, Formats[q], Extensions[q], Size);
+                    if (RenderCacheFetch(CacheFile, OutName))
+                      continue;
+                  }
+
+                  if (Formats[q] == "RASTER") {
+                    Taquart::RasterMeca Meca(Size, Size);
+                    GenerateBallRaster(Meca, FSList, FSuffix);
+                    Meca.Save(OutName);
+                  }
+                  else if (ctype[q] == Taquart::ctSurface) {
                     Taquart::TriCairo_Meca Meca(Size, Size, ctype[q]);
                     GenerateBallCairo(Meca, FSList, InputData, FSuffix);
                     Meca.Save(OutName);
@@ -672,6 +832,9 @@ int main(int argc, char* argv[]) {
                     Taquart::TriCairo_Meca Meca(Size, Size, ctype[q], OutName);
                     GenerateBallCairo(Meca, FSList, InputData, FSuffix);
                   }
+
+                  if (CacheFile.Length())
+                    RenderCacheStore(CacheFile, OutName);
                 }
                 catch (...) {
                   return 2;
@@ -880,22 +1043,42 @@ int main(int argc, char* argv[]) {
               if (DumpOrder[i] == 'U' && ExportU) {
                 OutFile2 << FOCIMT_SEP << Solution.U_n << std::endl;
                 for (int r = 0; r < Solution.U_n; r++) {
-                  OutFile2 << Solution.Station[r].c_str() << FOCIMT_SEP
-                      << Solution.U_measured[r] << FOCIMT_SEP
-                      << Solution.U_th[r] << std::endl;
+                  OutFile2 << Solution.Station(r).c_str() << FOCIMT_SEP
+                      << Solution.U_measured(r) << FOCIMT_SEP
+                      << Solution.U_th(r);
+                  if (Solution.U_influence())
+                    OutFile2 << FOCIMT_SEP << Solution.U_leverage(r)
+                        << FOCIMT_SEP << Solution.U_cook(r);
+                  OutFile2 << std::endl;
                 }
               }
               else if (DumpOrder[i] == 'u' && ExportU) {
                 OutFile2 << FOCIMT_SEP2 << Solution.U_n << std::endl;
                 for (int r = 0; r < Solution.U_n; r++) {
                   sprintf(txtb, "%5s%s%13.5e%s%13.5e",
-                      Solution.Station[r].c_str(),
-                      FOCIMT_SEP2, Solution.U_measured[r], FOCIMT_SEP2,
-                      Solution.U_th[r]);
-                  OutFile2 << txtb << std::endl;
+                      Solution.Station(r).c_str(),
+                      FOCIMT_SEP2, Solution.U_measured(r), FOCIMT_SEP2,
+                      Solution.U_th(r));
+                  OutFile2 << txtb;
+                  if (Solution.U_influence()) {
+                    sprintf(txtb, "%s%6.3f%s%11.3e", FOCIMT_SEP2,
+                        Solution.U_leverage(r), FOCIMT_SEP2,
+                        Solution.U_cook(r));
+                    OutFile2 << txtb;
+                  }
+                  OutFile2 << std::endl;
                 }
               }
 
+              // Export number of L1 grid search rounds.
+              if (DumpOrder[i] == 'R') {
+                OutFile << FOCIMT_SEP << Solution.ROUNDS;
+              }
+              else if (DumpOrder[i] == 'r') {
+                sprintf(txtb, "%s%3d", FOCIMT_SEP2, Solution.ROUNDS);
+                OutFile << txtb;
+              }
+
               // Export std error of displacement fit.
               if (DumpOrder[i] == 'E') {
                 OutFile << FOCIMT_SEP << Solution.UERR;
@@ -923,6 +1106,25 @@ int main(int argc, char* argv[]) {
                 OutFile << txtb;
               }
 
+              // Export linearised standard deviations.
+              if (DumpOrder[i] == 'S' || DumpOrder[i] == 's') {
+                Taquart::SolutionUncertainty u;
+                Taquart::PropagateUncertainty(Solution, u);
+                const double sd[17] = { u.FIA, u.DLA, u.RAKEA, u.FIB, u.DLB,
+                    u.RAKEB, u.PXTR, u.PXPL, u.TXTR, u.TXPL, u.BXTR, u.BXPL,
+                    u.EXPL, u.CLVD, u.DBCP, u.M0, u.MAGN };
+                for (int q = 0; q < 17; q++) {
+                  if (DumpOrder[i] == 'S')
+                    OutFile << FOCIMT_SEP << sd[q];
+                  else {
+                    sprintf(txtb,
+                        q == 15 ? "%s%11.3e" : q == 16 ? "%s%4.2f" : "%s%5.1f",
+                        FOCIMT_SEP2, sd[q]);
+                    OutFile << txtb;
+                  }
+                }
+              }
+
               if (DumpOrder[i] == '*') {
                 OutFile << FOCIMT_NEWLINE;
               }
@@ -933,9 +1135,226 @@ int main(int argc, char* argv[]) {
 
           } // Loop for all solution types.
         } // Loof for all events
+
+      //---- Export statistics of the tests (option -st).
+      if (StreamStats && (JacknifeTest || NoiseTest || BootstrapTest)) {
+        for (int i = 1; i <= SolutionTypes.Length(); i++) {
+          int Kind = 2;
+          Taquart::String FSuffix = "dc";
+          if (SolutionTypes[i] == 'F') {
+            Kind = 0;
+            FSuffix = "full";
+          }
+          else if (SolutionTypes[i] == 'T') {
+            Kind = 1;
+            FSuffix = "deviatoric";
+          }
+          Taquart::String OutName;
+          if (FilenameOut.Length() == 0)
+            OutName = Taquart::String(fileid) + "-" + FSuffix + "-stat.asc";
+          else
+            OutName = FilenameOut + "-" + FSuffix + "-stat.asc";
+          ofstream OutFile(OutName.c_str(),
+              std::ofstream::out | std::ofstream::app);
+          Stats.Write(OutFile, fileid, Kind);
+          OutFile.close();
+        }
+      }
+
+      //---- Station robustness tests (options -lk and -ls).
+      if (LeaveOutK > 0 || SectorWidth > 0.0) {
+        Taquart::StationSubsets Subsets(InputData);
+        Taquart::String OutName;
+        if (FilenameOut.Length() == 0)
+          OutName = Taquart::String(fileid) + "-subsets.asc";
+        else
+          OutName = FilenameOut + "-subsets.asc";
+        ofstream OutFile(OutName.c_str(),
+            std::ofstream::out | std::ofstream::app);
+        if (LeaveOutK > 0)
+          Subsets.LeaveOut(OutFile, fileid, LeaveOutK, LeaveOutThreads);
+        if (SectorWidth > 0.0)
+          Subsets.Sectors(OutFile, fileid, SectorWidth);
+        OutFile.close();
+      }
+
+      //---- Collect the event for the joint inversion (option -jm).
+      if (JointType.Length() > 0)
+        Joint.Add(fileid, InputData);
+
+      //---- Solutions for the models of the ensemble (option -me).
+      if (VelocityModel && Ensemble.size() > 0) {
+        Taquart::RayCache::Node Hypocentre;
+        Hypocentre.dNorthing = Hypocentre.dEasting = 0.0;
+        Hypocentre.Z = Event.Z;
+        std::vector<Taquart::RayCache::Node> Nodes(1, Hypocentre);
+        std::vector<Taquart::SMTInputData> Variants(Ensemble.size());
+        for (unsigned int i = 0; i < Ensemble.size(); i++) {
+          EnsembleRays[i].Trace(Event, Nodes, 0);
+          EnsembleRays[i].Prepare(Event, Hypocentre, Variants[i]);
+        }
+
+        // Reference solutions only.
+        Taquart::InversionOptions EnsembleOptions = Options;
+        EnsembleOptions.JacknifeTest = false;
+        EnsembleOptions.NoiseSamples = 0;
+        EnsembleOptions.BootstrapSamples = 0;
+        EnsembleOptions.AdaptiveBatch = 0;
+        EnsembleOptions.Residuals = false;
+        std::vector<std::vector<Taquart::FaultSolutions> > Results;
+        if (!Taquart::InvertVariants(Variants, EnsembleOptions,
+            EnsembleWorkers, Results))
+          std::cout << "Ensemble inversion of " << fileid << " incomplete."
+              << std::endl;
+
+        // Spread of the solutions around the -m model solution.
+        Taquart::ResamplingStats Spread;
+        if (FSList.size() > 0)
+          Spread.Start(FSList[0]);
+        for (unsigned int j = 0; j < Results.size(); j++)
+          if (!Results[j].empty()) {
+            Results[j][0].Type = 'M';
+            Spread.Add(Results[j][0]);
+          }
+
+        for (int i = 1; i <= SolutionTypes.Length(); i++) {
+          int Kind = 2;
+          Taquart::String FSuffix = "dc";
+          if (SolutionTypes[i] == 'F') {
+            Kind = 0;
+            FSuffix = "full";
+          }
+          else if (SolutionTypes[i] == 'T') {
+            Kind = 1;
+            FSuffix = "deviatoric";
+          }
+          Taquart::String OutName;
+          if (FilenameOut.Length() == 0)
+            OutName = Taquart::String(fileid) + "-" + FSuffix + "-models.asc";
+          else
+            OutName = FilenameOut + "-" + FSuffix + "-models.asc";
+          ofstream OutFile(OutName.c_str(),
+              std::ofstream::out | std::ofstream::app);
+          OutFile << fileid << FOCIMT_SEP << Ensemble.size()
+              << FOCIMT_NEWLINE;
+          for (unsigned int j = 0; j < Results.size(); j++) {
+            OutFile << Ensemble[j].Name.c_str() << FOCIMT_SEP;
+            if (Results[j].empty()) {
+              OutFile << "FAILED" << FOCIMT_NEWLINE;
+              continue;
+            }
+            const Taquart::FaultSolutions &fs = Results[j][0];
+            const Taquart::FaultSolution &s =
+                Kind == 0 ? fs.FullSolution :
+                Kind == 1 ? fs.TraceNullSolution : fs.DoubleCoupleSolution;
+            Taquart::WriteVariant(OutFile, s);
+            if (FSList.size() > 0) {
+              const Taquart::FaultSolution &r =
+                  Kind == 0 ? FSList[0].FullSolution :
+                  Kind == 1 ?
+                      FSList[0].TraceNullSolution :
+                      FSList[0].DoubleCoupleSolution;
+              OutFile << FOCIMT_SEP << Taquart::RotationAngle(r, s);
+            }
+            OutFile << FOCIMT_NEWLINE;
+          }
+          if (FSList.size() > 0)
+            Spread.Write(OutFile, fileid, Kind);
+          OutFile.close();
+        }
+      }
+
+      //---- Depth scan and hypocentre grid (options -zs and -zh).
+      if (VelocityModel && ScanStep > 0.0) {
+        const int NZ = int(floor((ScanEnd - ScanStart) / ScanStep + 1e-9)) + 1;
+        std::vector<Taquart::RayCache::Node> Nodes;
+        for (int iz = 0; iz < NZ; iz++)
+          for (int in = -GridN; in <= GridN; in++)
+            for (int ie = -GridN; ie <= GridN; ie++) {
+              Taquart::RayCache::Node n;
+              n.dNorthing = in * GridStep;
+              n.dEasting = ie * GridStep;
+              n.Z = ScanStart + iz * ScanStep;
+              Nodes.push_back(n);
+            }
+
+        Rays.Trace(Event, Nodes, 0);
+        std::vector<Taquart::SMTInputData> Variants(Nodes.size());
+        for (unsigned int i = 0; i < Nodes.size(); i++)
+          Rays.Prepare(Event, Nodes[i], Variants[i]);
+
+        // Reference solutions only.
+        Taquart::InversionOptions ScanOptions = Options;
+        ScanOptions.JacknifeTest = false;
+        ScanOptions.NoiseSamples = 0;
+        ScanOptions.BootstrapSamples = 0;
+        ScanOptions.AdaptiveBatch = 0;
+        ScanOptions.Residuals = false;
+        std::vector<std::vector<Taquart::FaultSolutions> > Results;
+        if (!Taquart::InvertVariants(Variants, ScanOptions, ScanWorkers,
+            Results))
+          std::cout << "Depth scan of " << fileid << " incomplete."
+              << std::endl;
+
+        for (int i = 1; i <= SolutionTypes.Length(); i++) {
+          Taquart::String FSuffix = "dc";
+          if (SolutionTypes[i] == 'F')
+            FSuffix = "full";
+          else if (SolutionTypes[i] == 'T')
+            FSuffix = "deviatoric";
+          Taquart::String OutName;
+          if (FilenameOut.Length() == 0)
+            OutName = Taquart::String(fileid) + "-" + FSuffix + "-scan.asc";
+          else
+            OutName = FilenameOut + "-" + FSuffix + "-scan.asc";
+          ofstream OutFile(OutName.c_str(),
+              std::ofstream::out | std::ofstream::app);
+          OutFile << fileid << FOCIMT_SEP << Nodes.size() << FOCIMT_NEWLINE;
+          int Best = -1;
+          double BestErr = 0.0;
+          for (unsigned int j = 0; j < Nodes.size(); j++) {
+            OutFile << Nodes[j].dNorthing << FOCIMT_SEP << Nodes[j].dEasting
+                << FOCIMT_SEP << Nodes[j].Z << FOCIMT_SEP;
+            if (Results[j].empty()) {
+              OutFile << "FAILED" << FOCIMT_NEWLINE;
+              continue;
+            }
+            const Taquart::FaultSolutions &fs = Results[j][0];
+            const Taquart::FaultSolution &s =
+                SolutionTypes[i] == 'F' ? fs.FullSolution :
+                SolutionTypes[i] == 'T' ?
+                    fs.TraceNullSolution : fs.DoubleCoupleSolution;
+            Taquart::WriteVariant(OutFile, s);
+            OutFile << FOCIMT_NEWLINE;
+            if (Best < 0 || s.UERR < BestErr) {
+              Best = j;
+              BestErr = s.UERR;
+            }
+          }
+          if (Best >= 0)
+            OutFile << "BEST" << FOCIMT_SEP << Nodes[Best].dNorthing
+                << FOCIMT_SEP << Nodes[Best].dEasting << FOCIMT_SEP
+                << Nodes[Best].Z << FOCIMT_SEP << BestErr << FOCIMT_NEWLINE;
+          OutFile.close();
+        }
+      }
       }
     }
     //InputFile.close();
+
+    //---- Joint inversion of all events (option -jm).
+    if (JointType.Length() > 0 && Joint.Solve(JointThreads)) {
+      Taquart::String OutName = FilenameOut;
+      if (OutName.Length() == 0) {
+        OutName = Taquart::ExtractFileName(FilenameIn);
+        if (OutName.Pos("."))
+          OutName = OutName.SubString(1, OutName.Pos(".") - 1);
+      }
+      OutName = OutName + "-joint.asc";
+      ofstream OutFile(OutName.c_str());
+      Joint.Write(OutFile);
+      OutFile.close();
+    }
     return 0;
   }
   catch (...) {
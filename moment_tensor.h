@@ -30,7 +30,6 @@
 #ifndef MOMENT_TENSOR_H_
 #define MOMENT_TENSOR_H_
 //---------------------------------------------------------------------------
-#define FOCIMT_MAXCHANNEL 128
 #define FOCIMT_MIN_ALLOWED_CHANNELS 8
 #define FOCIMT_SQ(x) (pow(x,2.0))
 #define FOCIMT_SEP "\t"
@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+// Source: qmc.cpp
+// Module: focimt
+// Quasi-Monte Carlo (scrambled Sobol) sampling of resampling tests.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <math.h>
+#include "qmc.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  const int BITS = 32;
+
+  //! Direction numbers, BITS per dimension, grown on demand.
+  std::vector<uint32_t> Directions;
+
+  //! Product of two polynomials over GF(2) modulo p of degree s.
+  uint32_t MulMod(uint32_t a, uint32_t b, uint32_t p, int s) {
+    uint32_t r = 0;
+    while (b) {
+      if (b & 1)
+        r ^= a;
+      b >>= 1;
+      a <<= 1;
+      if (a & (1u << s))
+        a ^= p;
+    }
+    return r;
+  }
+
+  //! x**e modulo p of degree s.
+  uint32_t PowX(uint32_t e, uint32_t p, int s) {
+    uint32_t r = 1, b = s > 1 ? 2 : 2 ^ p;
+    while (e) {
+      if (e & 1)
+        r = MulMod(r, b, p, s);
+      b = MulMod(b, b, p, s);
+      e >>= 1;
+    }
+    return r;
+  }
+
+  //! True if p of degree s is primitive: x has the order 2**s - 1.
+  bool Primitive(uint32_t p, int s) {
+    const uint32_t Order = (1u << s) - 1;
+    if (PowX(Order, p, s) != 1)
+      return false;
+    uint32_t n = Order;
+    for (uint32_t q = 2; q * q <= n; q++) {
+      if (n % q == 0) {
+        if (PowX(Order / q, p, s) == 1)
+          return false;
+        while (n % q == 0)
+          n /= q;
+      }
+    }
+    return n == 1 || PowX(Order / n, p, s) != 1;
+  }
+
+  //! Direction numbers of dimension d from polynomial p of degree s.
+  void AddDimension(uint32_t p, int s, unsigned int d) {
+    uint32_t m[BITS + 1];
+    uint32_t h = 2654435761u * (d + 1);
+    for (int k = 1; k <= s && k <= BITS; k++) {
+      h ^= h >> 15;
+      h *= 2246822519u;
+      m[k] = (h & ((1u << k) - 1)) | 1;
+    }
+    for (int k = s + 1; k <= BITS; k++) {
+      m[k] = m[k - s] ^ (m[k - s] << s);
+      for (int i = 1; i < s; i++)
+        if (p & (1u << (s - i)))
+          m[k] ^= m[k - i] << i;
+    }
+    for (int k = 1; k <= BITS; k++)
+      Directions.push_back(m[k] << (BITS - k));
+  }
+
+  //! Makes direction numbers available for Count dimensions.
+  void Prepare(unsigned int Count) {
+    if (Directions.size() >= size_t(Count) * BITS)
+      return;
+    if (Directions.empty())
+      for (int k = 1; k <= BITS; k++)
+        Directions.push_back(1u << (BITS - k)); // van der Corput.
+
+    // Continue the search after the polynomial of the last dimension.
+    static uint32_t p = 1;
+    static int s = 1;
+    while (Directions.size() < size_t(Count) * BITS) {
+      p += 2;
+      if (p >> (s + 1)) {
+        s++;
+        p = (1u << s) | 1;
+      }
+      if (Primitive(p, s))
+        AddDimension(p, s, Directions.size() / BITS);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+Taquart::SobolSequence::SobolSequence(unsigned int ADimensions) :
+    Index(0), X(ADimensions, 0), Shift(ADimensions) {
+  Prepare(ADimensions);
+  for (unsigned int d = 0; d < ADimensions; d++)
+    Shift[d] = (uint32_t(rand() & 0xffff) << 16) ^ uint32_t(rand() & 0xffff);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::SobolSequence::Next(void) {
+  // Gray code order: one direction number per step.
+  Index++;
+  int c = 0;
+  while (c < BITS - 1 && !(Index & (1u << c)))
+    c++;
+  const uint32_t * v = &Directions[c];
+  for (size_t d = 0; d < X.size(); d++)
+    X[d] ^= v[d * BITS];
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::SobolSequence::Uniform(unsigned int d) const {
+  return ((X[d] ^ Shift[d]) + 0.5) / 4294967296.0;
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::SobolSequence::Normal(unsigned int d) const {
+  return InverseNormal(Uniform(d));
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::InverseNormal(double p) {
+  static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02,
+      -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+      2.506628277459239e+00 };
+  static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02,
+      -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+  static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+      -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+      2.938163982698783e+00 };
+  static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01,
+      2.445134137142996e+00, 3.754408661907416e+00 };
+  const double Low = 0.02425;
+
+  if (p < Low) {
+    double q = sqrt(-2.0 * log(p));
+    return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q
+        + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  }
+  if (p > 1.0 - Low) {
+    double q = sqrt(-2.0 * log(1.0 - p));
+    return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q
+        + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  }
+  double q = p - 0.5, r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5])
+      * q
+      / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
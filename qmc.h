@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// Source: qmc.h
+// Module: focimt
+// Quasi-Monte Carlo (scrambled Sobol) sampling of resampling tests.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef QMC_H_
+#define QMC_H_
+//-----------------------------------------------------------------------------
+#include <vector>
+#include <stdint.h>
+
+namespace Taquart {
+
+  //! Scrambled Sobol low-discrepancy sequence.
+  /*! Direction numbers use the primitive polynomials over GF(2) in order of
+   *  degree, generated on first use for any number of dimensions, with
+   *  fixed odd initial numbers. Each sequence is randomized by a digital
+   *  shift drawn from rand(), so -rs keeps the tests reproducible and
+   *  independent sequences give unbiased estimates. Every prefix of 2^k
+   *  points stratifies each dimension into 2^k equal intervals.
+   */
+  class SobolSequence {
+    public:
+      //! Constructor.
+      /*! \param ADimensions Number of dimensions.
+       */
+      SobolSequence(unsigned int ADimensions);
+
+      //! Moves to the next point.
+      void Next(void);
+
+      //! Coordinate \p d of the current point, uniform in (0,1).
+      double Uniform(unsigned int d) const;
+
+      //! Coordinate \p d of the current point mapped to a standard normal.
+      double Normal(unsigned int d) const;
+
+    private:
+      uint32_t Index;
+      std::vector<uint32_t> X;
+      std::vector<uint32_t> Shift;
+  };
+
+  //! Inverse of the standard normal cumulative distribution function.
+  /*! Rational approximation of P. J. Acklam, relative error below 1.2e-9.
+   *  \param p Probability, 0 < p < 1.
+   */
+  double InverseNormal(double p);
+}
+
+//-----------------------------------------------------------------------------
+#endif /* QMC_H_ */
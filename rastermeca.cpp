@@ -0,0 +1,407 @@
+//-----------------------------------------------------------------------------
+// Source: rastermeca.cpp
+// Module: focimt
+// Fast raster beach ball renderer (no Cairo dependency).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <fstream>
+#include <thread>
+#include "rastermeca.h"
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//---- PNG output (zlib stream with fixed-Huffman deflate block).
+//-----------------------------------------------------------------------------
+namespace {
+
+  // CRC-32 table, built during static initialization (before any thread
+  // can use it).
+  struct CRCTable {
+      unsigned int Entry[256];
+      CRCTable(void) {
+        for (unsigned int i = 0; i < 256; i++) {
+          unsigned int c = i;
+          for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+          Entry[i] = c;
+        }
+      }
+  };
+  const CRCTable CRC;
+
+  //---------------------------------------------------------------------------
+  unsigned int crc32(const unsigned char *buf, size_t n, unsigned int crc) {
+    crc = crc ^ 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++)
+      crc = CRC.Entry[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+  }
+
+  //---------------------------------------------------------------------------
+  unsigned int adler32(const std::vector<unsigned char> &buf) {
+    unsigned int a = 1, b = 0;
+    for (size_t i = 0; i < buf.size(); i++) {
+      a = (a + buf[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+  }
+
+  //---------------------------------------------------------------------------
+  // Bit writer for the deflate stream (least significant bit first).
+  class BitWriter {
+    public:
+      BitWriter(std::vector<unsigned char> &out) :
+          Out(out), Buffer(0), Count(0) {
+      }
+      void Put(unsigned int value, int nbits) {
+        Buffer |= value << Count;
+        Count += nbits;
+        while (Count >= 8) {
+          Out.push_back((unsigned char) (Buffer & 0xFF));
+          Buffer >>= 8;
+          Count -= 8;
+        }
+      }
+      // Huffman codes are stored starting from the most significant bit.
+      void PutCode(unsigned int code, int nbits) {
+        unsigned int r = 0;
+        for (int i = 0; i < nbits; i++)
+          r |= ((code >> i) & 1) << (nbits - 1 - i);
+        Put(r, nbits);
+      }
+      void Flush(void) {
+        if (Count > 0)
+          Out.push_back((unsigned char) (Buffer & 0xFF));
+        Buffer = 0;
+        Count = 0;
+      }
+    private:
+      std::vector<unsigned char> &Out;
+      unsigned int Buffer;
+      int Count;
+  };
+
+  const unsigned int LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+      17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227,
+      258 };
+  const int LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+  const unsigned int DistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49,
+      65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+      8193, 12289, 16385, 24577 };
+  const int DistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7,
+      7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+  //---------------------------------------------------------------------------
+  // Literal/length symbol in the fixed Huffman table.
+  void PutSymbol(BitWriter &bw, unsigned int sym) {
+    if (sym < 144)
+      bw.PutCode(0x30 + sym, 8);
+    else if (sym < 256)
+      bw.PutCode(0x190 + sym - 144, 9);
+    else if (sym < 280)
+      bw.PutCode(sym - 256, 7);
+    else
+      bw.PutCode(0xC0 + sym - 280, 8);
+  }
+
+  //---------------------------------------------------------------------------
+  void PutMatch(BitWriter &bw, unsigned int len, unsigned int dist) {
+    int i = 28;
+    while (LengthBase[i] > len)
+      i--;
+    PutSymbol(bw, 257 + i);
+    bw.Put(len - LengthBase[i], LengthExtra[i]);
+    int j = 29;
+    while (DistBase[j] > dist)
+      j--;
+    bw.PutCode(j, 5);
+    bw.Put(dist - DistBase[j], DistExtra[j]);
+  }
+
+  //---------------------------------------------------------------------------
+  // Compress filtered scanlines. Beach balls consist of large areas of
+  // uniform color, so it is sufficient to look for matches with the previous
+  // pixel and with the same pixel in the previous row.
+  void Deflate(const std::vector<unsigned char> &in, unsigned int stride,
+      std::vector<unsigned char> &out) {
+    BitWriter bw(out);
+    bw.Put(1, 1); // Final block.
+    bw.Put(1, 2); // Fixed Huffman codes.
+    const size_t n = in.size();
+    const unsigned int dists[2] = { 4, stride };
+    size_t i = 0;
+    while (i < n) {
+      unsigned int bestlen = 0, bestdist = 0;
+      for (int k = 0; k < 2; k++) {
+        unsigned int d = dists[k];
+        if (d > i || d > 32768)
+          continue;
+        unsigned int len = 0;
+        while (len < 258 && i + len < n && in[i + len] == in[i + len - d])
+          len++;
+        if (len > bestlen) {
+          bestlen = len;
+          bestdist = d;
+        }
+      }
+      if (bestlen >= 3) {
+        PutMatch(bw, bestlen, bestdist);
+        i += bestlen;
+      }
+      else {
+        PutSymbol(bw, in[i]);
+        i++;
+      }
+    }
+    PutSymbol(bw, 256); // End of block.
+    bw.Flush();
+  }
+
+  //---------------------------------------------------------------------------
+  void PutBE32(std::vector<unsigned char> &out, unsigned int v) {
+    out.push_back((unsigned char) (v >> 24));
+    out.push_back((unsigned char) (v >> 16));
+    out.push_back((unsigned char) (v >> 8));
+    out.push_back((unsigned char) v);
+  }
+
+  //---------------------------------------------------------------------------
+  void WriteChunk(std::ofstream &file, const char *type,
+      const std::vector<unsigned char> &data) {
+    std::vector<unsigned char> chunk;
+    PutBE32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    PutBE32(chunk, crc32(&chunk[4], chunk.size() - 4, 0));
+    file.write((const char *) &chunk[0], chunk.size());
+  }
+
+  //---------------------------------------------------------------------------
+  unsigned char ColorByte(double c) {
+    if (c <= 0.0)
+      return 0;
+    if (c >= 1.0)
+      return 255;
+    return (unsigned char) (c * 255.0 + 0.5);
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+//---- RasterMeca class.
+//-----------------------------------------------------------------------------
+Taquart::RasterMeca::RasterMeca(unsigned int width, unsigned int height) :
+    Width(width), Height(height) {
+  // Geometry is the same as in TriCairo_Meca.
+  Margin = Width * 0.01;
+  BWidth = Width - Margin * 2;
+  BHeight = Height - Margin * 2;
+  BRadius = BWidth > BHeight ? BHeight / 2 : BWidth / 2;
+  BXo = Margin + BWidth / 2;
+  BYo = Margin + BHeight / 2;
+  BOutlineWidth = double(BRadius) / 100.0;
+  BOutlineColor = TCColor(0.0, 0.0, 0.0);
+  BPlusColor = TCColor(0.85, 0.85, 0.85);
+  BMinusColor = TCColor(0.99, 0.99, 0.99);
+  BBackgroundColor = TCColor(0.0, 0.0, 0.0, 0.0);
+  Projection = prSchmidt;
+  Hemisphere = heLower;
+  Threads = 0;
+
+  Pixels.resize(Width * Height * 4);
+  East.resize(Width);
+  Clear();
+}
+
+//-----------------------------------------------------------------------------
+Taquart::RasterMeca::~RasterMeca(void) {
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::RasterMeca::Clear(void) {
+  unsigned char bg[4] = { ColorByte(BBackgroundColor.R), ColorByte(
+      BBackgroundColor.G), ColorByte(BBackgroundColor.B), ColorByte(
+      BBackgroundColor.A) };
+  for (size_t i = 0; i < Pixels.size(); i += 4) {
+    Pixels[i] = bg[0];
+    Pixels[i + 1] = bg[1];
+    Pixels[i + 2] = bg[2];
+    Pixels[i + 3] = bg[3];
+  }
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::RasterMeca::Tensor(const double M[4][4]) {
+  if (BRadius == 0)
+    return;
+
+  // Only the sign of the radiation pattern is needed, so the tensor is
+  // normalized to avoid overflows for large moments.
+  double scal = 0.0;
+  for (int i = 1; i <= 3; i++)
+    for (int j = 1; j <= 3; j++)
+      scal = fabs(M[i][j]) > scal ? fabs(M[i][j]) : scal;
+  if (scal == 0.0)
+    scal = 1.0;
+  const double m11 = M[1][1] / scal, m22 = M[2][2] / scal, m33 = M[3][3]
+      / scal;
+  const double m12 = 2.0 * M[1][2] / scal, m13 = 2.0 * M[1][3] / scal, m23 =
+      2.0 * M[2][3] / scal;
+
+  // Upper hemisphere is a point reflection of the lower one.
+  const double R = double(BRadius);
+  const double hs = Hemisphere == heUpper ? -1.0 : 1.0;
+  for (unsigned int px = 0; px < Width; px++)
+    East[px] = hs * (double(px) + 0.5 - double(BXo)) / R;
+
+  // Squared radius of the visible part of the outline (the inner half of the
+  // outline is covered by the shading in TriCairo_Meca as well).
+  const double ro = 1.0 + 0.5 * BOutlineWidth / R;
+  const double ro2 = ro * ro;
+
+  unsigned char cp[4] = { ColorByte(BPlusColor.R), ColorByte(BPlusColor.G),
+      ColorByte(BPlusColor.B), ColorByte(BPlusColor.A) };
+  unsigned char cm[4] = { ColorByte(BMinusColor.R), ColorByte(BMinusColor.G),
+      ColorByte(BMinusColor.B), ColorByte(BMinusColor.A) };
+  unsigned char co[4] = { ColorByte(BOutlineColor.R), ColorByte(
+      BOutlineColor.G), ColorByte(BOutlineColor.B), ColorByte(
+      BOutlineColor.A) };
+
+  // Rows are rendered in bands, one per thread. Thumbnails are too small to
+  // pay for the threads, so each band has at least 256k pixels.
+  const double *e = &East[0];
+  auto Band = [&](unsigned int First, unsigned int Last) {
+    std::vector<double> Amplitude(Width);
+    double *a = &Amplitude[0];
+    for (unsigned int py = First; py < Last; py++) {
+      // Image rows go from north to south.
+      const double n = hs * (double(Height) - double(BYo) - double(py) - 0.5)
+          / R;
+      const double n2 = n * n;
+
+      // Direction cosines (north, east, down) of the ray are obtained from the
+      // projected radius without trigonometric functions. Only the sign of the
+      // amplitude is used, so the common positive factors are dropped. The
+      // loops are branch-free and vectorized by the compiler.
+      switch (Projection) {
+        case prWulff:
+          // r = tan(i/2): g ~ (2n, 2e, 1 - r^2)
+          for (unsigned int px = 0; px < Width; px++) {
+            const double r2 = e[px] * e[px] + n2;
+            const double g1 = 2.0 * n, g2 = 2.0 * e[px], g3 = 1.0 - r2;
+            a[px] = m11 * g1 * g1 + m22 * g2 * g2 + m33 * g3 * g3
+                + m12 * g1 * g2 + m13 * g1 * g3 + m23 * g2 * g3;
+          }
+          break;
+        default:
+          // r = sqrt(2) sin(i/2): g ~ (n s, e s, 1 - r^2), s = sqrt(2 - r^2)
+          for (unsigned int px = 0; px < Width; px++) {
+            const double r2 = e[px] * e[px] + n2;
+            const double s = sqrt(fabs(2.0 - r2));
+            const double g1 = n * s, g2 = e[px] * s, g3 = 1.0 - r2;
+            a[px] = m11 * g1 * g1 + m22 * g2 * g2 + m33 * g3 * g3
+                + m12 * g1 * g2 + m13 * g1 * g3 + m23 * g2 * g3;
+          }
+          break;
+      }
+
+      unsigned char *p = &Pixels[py * Width * 4];
+      for (unsigned int px = 0; px < Width; px++, p += 4) {
+        const double r2 = e[px] * e[px] + n2;
+        const unsigned char *c;
+        if (r2 <= 1.0)
+          c = a[px] > 0.0 ? cp : cm;
+        else if (r2 <= ro2)
+          c = co;
+        else
+          continue;
+        p[0] = c[0];
+        p[1] = c[1];
+        p[2] = c[2];
+        p[3] = c[3];
+      }
+    }
+  };
+
+  unsigned int Bands = Threads ? Threads : std::thread::hardware_concurrency();
+  const unsigned int MaxBands = 1 + Width * Height / (1 << 18);
+  Bands = Bands < 1 ? 1 : (Bands > MaxBands ? MaxBands : Bands);
+  if (Bands == 1) {
+    Band(0, Height);
+    return;
+  }
+  std::vector<std::thread> Pool;
+  for (unsigned int t = 0; t < Bands; t++)
+    Pool.push_back(
+        std::thread(Band, Height * t / Bands, Height * (t + 1) / Bands));
+  for (unsigned int t = 0; t < Bands; t++)
+    Pool[t].join();
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::RasterMeca::Save(Taquart::String filename) {
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!file)
+    throw Taquart::TriEIOError("RasterMeca::Save(): Cannot create file.");
+
+  const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+  file.write((const char *) signature, 8);
+
+  // Header: 8-bit RGBA, no interlace.
+  std::vector<unsigned char> chunk;
+  PutBE32(chunk, Width);
+  PutBE32(chunk, Height);
+  chunk.push_back(8);
+  chunk.push_back(6);
+  chunk.push_back(0);
+  chunk.push_back(0);
+  chunk.push_back(0);
+  WriteChunk(file, "IHDR", chunk);
+
+  // Scanlines with filter type 0.
+  const unsigned int stride = Width * 4 + 1;
+  std::vector<unsigned char> raw(stride * Height);
+  for (unsigned int py = 0; py < Height; py++) {
+    raw[py * stride] = 0;
+    std::copy(Pixels.begin() + py * Width * 4,
+        Pixels.begin() + (py + 1) * Width * 4, raw.begin() + py * stride + 1);
+  }
+
+  chunk.clear();
+  chunk.push_back(0x78);
+  chunk.push_back(0x01);
+  Deflate(raw, stride, chunk);
+  PutBE32(chunk, adler32(raw));
+  WriteChunk(file, "IDAT", chunk);
+
+  chunk.clear();
+  WriteChunk(file, "IEND", chunk);
+
+  if (!file)
+    throw Taquart::TriEIOError("RasterMeca::Save(): Cannot write file.");
+}
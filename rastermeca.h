@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// Source: rastermeca.h
+// Module: focimt
+// Fast raster beach ball renderer (no Cairo dependency).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef RASTERMECA_H_
+#define RASTERMECA_H_
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "tricairo.h"
+
+namespace Taquart {
+
+  //! Fast raster renderer of the moment tensor radiation pattern.
+  /*! The class evaluates the polarity of the P-wave radiation pattern
+   *  directly for each pixel of the projected focal sphere and writes the
+   *  result to a PNG file. Contrary to TriCairo_Meca no vector paths are
+   *  produced (nodal lines, axes and stations are not drawn), which makes it
+   *  suitable for a large number of small thumbnails. The geometry of the
+   *  beach ball (margin, radius, center) follows TriCairo_Meca.
+   *  \ingroup tricairo
+   */
+  class RasterMeca {
+    public:
+      //! Constructor.
+      /*! \param width Width of the image in pixels.
+       *  \param height Height of the image in pixels.
+       */
+      RasterMeca(unsigned int width, unsigned int height);
+
+      //! Destructor.
+      ~RasterMeca(void);
+
+      // Public variables.
+      unsigned int Margin; // Margin size.
+      unsigned int BWidth;
+      unsigned int BHeight;
+      unsigned int BRadius;
+      unsigned int BXo;
+      unsigned int BYo;
+      double BOutlineWidth;
+      TCColor BOutlineColor;
+      TCColor BPlusColor; // For compressional part.
+      TCColor BMinusColor; // For dilatational part.
+      TCColor BBackgroundColor;
+      TriCairo_Projection Projection;
+      TriCairo_Hemisphere Hemisphere;
+      unsigned int Threads; // Threads rendering row bands (0 - one per processor).
+
+      //! Render the radiation pattern of the moment tensor.
+      /*! \param M Moment tensor, M[1][1] corresponds to M11 element etc.
+       *  (the layout of FaultSolution::M). Directions: 1 - north, 2 - east,
+       *  3 - down.
+       */
+      void Tensor(const double M[4][4]);
+
+      //! Save the image as a PNG file.
+      /*! \param filename Name of the output file.
+       */
+      void Save(Taquart::String filename);
+
+    private:
+      const unsigned int Width;
+      const unsigned int Height;
+      std::vector<unsigned char> Pixels; // RGBA, row by row.
+      std::vector<double> East; // Projected east coordinates of columns.
+
+      void Clear(void);
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* RASTERMECA_H_ */
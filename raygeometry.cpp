@@ -0,0 +1,224 @@
+//-----------------------------------------------------------------------------
+// Source: raygeometry.cpp
+// Module: focimt
+// Station geometry of located events from a 1D velocity model.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <math.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "raygeometry.h"
+#include "traveltime.h"
+
+//-----------------------------------------------------------------------------
+//---- VelocityModel1D class.
+//-----------------------------------------------------------------------------
+bool Taquart::VelocityModel1D::Read(std::istream &In) {
+  int n = 0;
+  double v;
+  Top.clear();
+  Velocity.clear();
+  In >> n;
+  for (int i = 0; i < n; i++) {
+    In >> v;
+    Top.push_back(v);
+  }
+  for (int i = 0; i < n; i++) {
+    In >> v;
+    Velocity.push_back(v);
+  }
+  return !In.fail() && n > 0;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::VelocityModel1D::Load(Taquart::String FileName) {
+  std::ifstream In(FileName.c_str());
+  Name = FileName;
+  return Read(In);
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::VelocityModel1D::LayerVelocity(double Depth) const {
+  for (int j = int(Velocity.size()) - 1; j >= 0; j--)
+    if (Depth >= Top[j])
+      return Velocity[j];
+  return Velocity.size() ? Velocity[0] : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+//---- LocatedEvent class.
+//-----------------------------------------------------------------------------
+bool Taquart::LocatedEvent::Read(std::istream &In) {
+  std::string s;
+  unsigned int n = 0;
+  Channels.clear();
+  In >> s;
+  Id = s.c_str();
+  In >> n;
+  In >> Northing;
+  In >> Easting;
+  In >> Z;
+  In >> Density;
+  for (unsigned int i = 0; i < n && In.good(); i++) {
+    Channel c;
+    In >> s;
+    c.Name = s.c_str();
+    In >> s;
+    c.Component = s.c_str();
+    In >> s;
+    c.Phase = s.c_str();
+    In >> c.Moment;
+    In >> c.Northing;
+    In >> c.Easting;
+    In >> c.Z;
+    Channels.push_back(c);
+  }
+  return In.good();
+}
+
+//-----------------------------------------------------------------------------
+//---- RayCache class.
+//-----------------------------------------------------------------------------
+Taquart::RayCache::RayCache(const Taquart::VelocityModel1D &AModel,
+    size_t ALimit) :
+    VModel(AModel), Limit(ALimit) {
+}
+
+//-----------------------------------------------------------------------------
+Taquart::RayCache::Key Taquart::RayCache::RayKey(
+    const Taquart::LocatedEvent &Event,
+    const Taquart::LocatedEvent::Channel &c, const Node &n, double &Azimuth) {
+  const double e_northing = Event.Northing + n.dNorthing;
+  const double e_easting = Event.Easting + n.dEasting;
+  Key k;
+  k.Depth = fabs(n.Z * 0.001);
+  k.Elevation = c.Z * 0.001;
+  k.Delta = 0.001
+      * sqrt(
+          pow(c.Northing - e_northing, 2.0) + pow(c.Easting - e_easting, 2.0));
+  Azimuth = atan2(c.Easting - e_easting, c.Northing - e_northing) * 180
+      / M_PI;
+  return k;
+}
+
+//-----------------------------------------------------------------------------
+Taquart::RayCache::Ray Taquart::RayCache::Compute(const Key &k) const {
+  double traveltime;
+  bool directphase;
+  int kk;
+  Ray r;
+  CalcTravelTime1D_2(k.Elevation, k.Depth, k.Delta, VModel.Top,
+      VModel.Velocity, traveltime, r.TakeOff, directphase, r.Incidence, kk,
+      r.Distance);
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+Taquart::RayCache::Ray Taquart::RayCache::Get(double Elevation, double Depth,
+    double Delta) {
+  Key k;
+  k.Elevation = Elevation;
+  k.Depth = Depth;
+  k.Delta = Delta;
+  std::map<Key, Ray>::iterator i = Rays.find(k);
+  if (i != Rays.end())
+    return i->second;
+  if (Rays.size() >= Limit)
+    Rays.clear();
+  return Rays[k] = Compute(k);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::RayCache::Trace(const Taquart::LocatedEvent &Event,
+    const std::vector<Node> &Nodes, int Threads) {
+  std::vector<Key> Missing;
+  std::map<Key, Ray> Seen;
+  double Azimuth;
+  for (size_t n = 0; n < Nodes.size(); n++)
+    for (size_t c = 0; c < Event.Channels.size(); c++) {
+      Key k = RayKey(Event, Event.Channels[c], Nodes[n], Azimuth);
+      if (Rays.count(k) == 0 && Seen.insert(std::make_pair(k, Ray())).second)
+        Missing.push_back(k);
+    }
+  if (Missing.empty())
+    return;
+  if (Rays.size() + Missing.size() > Limit)
+    Rays.clear();
+
+  std::vector<Ray> Traced(Missing.size());
+  std::atomic<size_t> Next(0);
+  auto Work = [&]() {
+    for (size_t i = Next++; i < Missing.size(); i = Next++)
+      Traced[i] = Compute(Missing[i]);
+  };
+  if (Threads <= 0)
+    Threads = std::thread::hardware_concurrency();
+  Threads = std::min(std::max(1, Threads), int(Missing.size()));
+  std::vector<std::thread> Pool;
+  for (int t = 1; t < Threads; t++)
+    Pool.push_back(std::thread(Work));
+  Work();
+  for (size_t t = 0; t < Pool.size(); t++)
+    Pool[t].join();
+
+  for (size_t i = 0; i < Missing.size(); i++)
+    Rays[Missing[i]] = Traced[i];
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::RayCache::Prepare(const Taquart::LocatedEvent &Event,
+    const Node &n, Taquart::SMTInputData &InputData) {
+  InputData.Clear();
+  for (size_t i = 0; i < Event.Channels.size(); i++) {
+    const Taquart::LocatedEvent::Channel &c = Event.Channels[i];
+    double Azimuth;
+    Key k = RayKey(Event, c, n, Azimuth);
+    Ray r = Get(k.Elevation, k.Depth, k.Delta);
+
+    // Prepare input line structure.
+    Taquart::SMTInputLine il;
+    il.Name = c.Name;
+    il.Id = i + 1;
+    il.Component = c.Component;
+    il.MarkerType = c.Phase;
+    il.Start = 0.0;
+    il.End = 0.0;
+    il.Duration = 0.0;
+    il.Displacement = c.Moment / cos(r.Incidence * M_PI / 180.0); // Vertical sensor.
+    il.Incidence = r.Incidence;
+    il.Azimuth = Azimuth;
+    il.TakeOff = r.TakeOff;
+    il.Distance = r.Distance * 1000;
+    il.Density = Event.Density;
+    il.Velocity = VModel.LayerVelocity(k.Depth) * 1000;
+    il.PickActive = true;
+    il.ChannelActive = true;
+    InputData.Add(il);
+  }
+}
@@ -0,0 +1,169 @@
+//-----------------------------------------------------------------------------
+// Source: raygeometry.h
+// Module: focimt
+// Station geometry of located events from a 1D velocity model.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef RAYGEOMETRY_H_
+#define RAYGEOMETRY_H_
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include <vector>
+#include <map>
+#include "inputdata.h"
+
+namespace Taquart {
+
+  //! 1D velocity model (option -m).
+  /*! File format: the number of layers, the tops of the layers [km] and
+   *  their P-wave velocities [km/s].
+   */
+  class VelocityModel1D {
+    public:
+      Taquart::String Name; /*!< File name. */
+      std::vector<double> Top; /*!< Tops of the layers [km]. */
+      std::vector<double> Velocity; /*!< Velocities of the layers [km/s]. */
+
+      //! Reads the layers from a stream.
+      /*! \return \p false if the stream failed.
+       */
+      bool Read(std::istream &In);
+
+      //! Reads the model from a file.
+      bool Load(Taquart::String FileName);
+
+      //! Velocity of the layer at Depth [km] (of the first layer above it).
+      double LayerVelocity(double Depth) const;
+  };
+
+  //! Event with hypocentre and station coordinates (input format of -m).
+  /*! Format: 'fileid N northing easting z density', followed by N lines
+   *  'id component phase moment northing easting z'. Coordinates are in
+   *  meters, the depth of the hypocentre is |z|.
+   */
+  class LocatedEvent {
+    public:
+      //! Channel of a station.
+      class Channel {
+        public:
+          Taquart::String Name;
+          Taquart::String Component;
+          Taquart::String Phase;
+          double Moment; /*!< Area below the first P-wave pulse. */
+          double Northing, Easting, Z; /*!< Station coordinates [m]. */
+      };
+
+      Taquart::String Id; /*!< Event id (fileid). */
+      double Northing, Easting, Z; /*!< Hypocentre [m]. */
+      double Density; /*!< Density in the source [kg/m**3]. */
+      std::vector<Channel> Channels;
+
+      //! Reads an event from a stream.
+      /*! \return \p false if the stream failed.
+       */
+      bool Read(std::istream &In);
+  };
+
+  //! Raytraced rays of a velocity model.
+  /*! Rays depend on the station elevation, the source depth and the
+   *  epicentral distance only, so the channels of a station, nodes of the
+   *  same depth and repeated positions share them. Rays missing for a set
+   *  of positions are traced on several threads (CalcTravelTime1D_2 keeps
+   *  no state). The cache is cleared when it grows beyond Limit rays.
+   */
+  class RayCache {
+    public:
+      //! Ray geometry.
+      class Ray {
+        public:
+          double TakeOff; /*!< Takeoff angle [deg]. */
+          double Incidence; /*!< Angle of incidence [deg]. */
+          double Distance; /*!< Ray length [km]. */
+      };
+
+      //! Source position relative to the hypocentre of an event.
+      class Node {
+        public:
+          double dNorthing, dEasting; /*!< Shift of the epicentre [m]. */
+          double Z; /*!< Depth [m]. */
+      };
+
+      //! Constructor.
+      /*! \param AModel Velocity model, kept by reference.
+       *  \param ALimit Maximum number of cached rays.
+       */
+      RayCache(const Taquart::VelocityModel1D &AModel, size_t ALimit =
+          1 << 20);
+
+      //! Velocity model of the rays.
+      const Taquart::VelocityModel1D &Model(void) const {
+        return VModel;
+      }
+
+      //! Traces the rays of the channels of Event for all Nodes.
+      /*! \param Threads Number of threads (0 - one per processor).
+       */
+      void Trace(const Taquart::LocatedEvent &Event,
+          const std::vector<Node> &Nodes, int Threads);
+
+      //! Ray from a source at Depth to a station at Elevation, Delta away
+      //! (all in km), traced if not cached.
+      Ray Get(double Elevation, double Depth, double Delta);
+
+      //! Input data of Event with the source at node n.
+      void Prepare(const Taquart::LocatedEvent &Event, const Node &n,
+          Taquart::SMTInputData &InputData);
+
+    private:
+      //! Station elevation, source depth and epicentral distance [km].
+      class Key {
+        public:
+          double Elevation, Depth, Delta;
+          bool operator<(const Key &k) const {
+            if (Elevation != k.Elevation)
+              return Elevation < k.Elevation;
+            if (Depth != k.Depth)
+              return Depth < k.Depth;
+            return Delta < k.Delta;
+          }
+      };
+
+      const Taquart::VelocityModel1D &VModel;
+      size_t Limit;
+      std::map<Key, Ray> Rays;
+
+      //! Key of the ray from node n to channel c of Event.
+      static Key RayKey(const Taquart::LocatedEvent &Event,
+          const Taquart::LocatedEvent::Channel &c, const Node &n,
+          double &Azimuth);
+
+      //! Traces a single ray.
+      Ray Compute(const Key &k) const;
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* RAYGEOMETRY_H_ */
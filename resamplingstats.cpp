@@ -0,0 +1,439 @@
+//-----------------------------------------------------------------------------
+// Source: resamplingstats.cpp
+// Module: focimt
+// Streaming statistics of resampled inversions (option -st).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <math.h>
+#include <algorithm>
+#include "resamplingstats.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  const double D2R = M_PI / 180.0;
+
+  //! Fault normal n, slip vector d and the P, T, B frame of a nodal plane.
+  void PlaneVectors(double Strike, double Dip, double Rake, double n[3],
+      double d[3]) {
+    const double sf = sin(Strike * D2R), cf = cos(Strike * D2R);
+    const double sd = sin(Dip * D2R), cd = cos(Dip * D2R);
+    const double sr = sin(Rake * D2R), cr = cos(Rake * D2R);
+    n[0] = -sd * sf;
+    n[1] = sd * cf;
+    n[2] = -cd;
+    d[0] = cr * cf + sr * cd * sf;
+    d[1] = cr * sf - sr * cd * cf;
+    d[2] = -sr * sd;
+  }
+
+  //! Unit vector of an axis (north, east, down).
+  void AxisVector(double Trend, double Plunge, double v[3]) {
+    v[0] = cos(Plunge * D2R) * cos(Trend * D2R);
+    v[1] = cos(Plunge * D2R) * sin(Trend * D2R);
+    v[2] = sin(Plunge * D2R);
+  }
+
+  //! Trend and plunge of the axis direction closest to Ref (the plunge is
+  //! negative if the axis is turned upwards).
+  void AlignAxis(double &Trend, double &Plunge, const double Ref[3]) {
+    double v[3];
+    AxisVector(Trend, Plunge, v);
+    if (v[0] * Ref[0] + v[1] * Ref[1] + v[2] * Ref[2] < 0.0) {
+      Trend += 180.0;
+      Plunge = -Plunge;
+    }
+  }
+
+  //! Columns T, P, B of the principal axes frame of a double couple.
+  void Frame(const Taquart::FaultSolution &s, double F[3][3]) {
+    double n[3], d[3];
+    PlaneVectors(s.FIA, s.DLA, s.RAKEA, n, d);
+    for (int i = 0; i < 3; i++) {
+      F[i][0] = (n[i] + d[i]) / sqrt(2.0);
+      F[i][1] = (n[i] - d[i]) / sqrt(2.0);
+    }
+    F[0][2] = n[1] * d[2] - n[2] * d[1];
+    F[1][2] = n[2] * d[0] - n[0] * d[2];
+    F[2][2] = n[0] * d[1] - n[1] * d[0];
+  }
+
+  //! Rotation angle between two frames, over the symmetries of the DC.
+  double FrameAngle(const double A[3][3], const double B[3][3]) {
+    double R[3];
+    for (int k = 0; k < 3; k++) {
+      R[k] = 0.0;
+      for (int i = 0; i < 3; i++)
+        R[k] += A[i][k] * B[i][k];
+    }
+    // Identity and 180 degree rotations about T, P and B.
+    double t = std::max(std::max(R[0] + R[1] + R[2], R[0] - R[1] - R[2]),
+        std::max(-R[0] + R[1] - R[2], -R[0] - R[1] + R[2]));
+    double c = std::min(1.0, std::max(-1.0, (t - 1.0) / 2.0));
+    return acos(c) / D2R;
+  }
+
+  const double Probabilities[Taquart::SolutionStats::NQ] = { 0.025, 0.16, 0.5,
+      0.84, 0.975 };
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::RotationAngle(const Taquart::FaultSolution &a,
+    const Taquart::FaultSolution &b) {
+  double A[3][3], B[3][3];
+  Frame(a, A);
+  Frame(b, B);
+  return FrameAngle(A, B);
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::RotationAngle(const double Ta[3], const double Pa[3],
+    const double Tb[3], const double Pb[3]) {
+  // B = P x T, the orientation of the frames of Frame().
+  const double * T[2] = { Ta, Tb };
+  const double * P[2] = { Pa, Pb };
+  double F[2][3][3];
+  for (int f = 0; f < 2; f++) {
+    for (int i = 0; i < 3; i++) {
+      F[f][i][0] = T[f][i];
+      F[f][i][1] = P[f][i];
+    }
+    F[f][0][2] = P[f][1] * T[f][2] - P[f][2] * T[f][1];
+    F[f][1][2] = P[f][2] * T[f][0] - P[f][0] * T[f][2];
+    F[f][2][2] = P[f][0] * T[f][1] - P[f][1] * T[f][0];
+  }
+  return FrameAngle(F[0], F[1]);
+}
+
+//-----------------------------------------------------------------------------
+//---- P2Quantile class.
+//-----------------------------------------------------------------------------
+Taquart::P2Quantile::P2Quantile(double AP) :
+    p(AP), Count(0) {
+  for (int i = 0; i < 5; i++)
+    q[i] = n[i] = np[i] = dn[i] = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::P2Quantile::Add(double x) {
+  if (Count < 5) {
+    q[Count++] = x;
+    if (Count == 5) {
+      std::sort(q, q + 5);
+      for (int i = 0; i < 5; i++)
+        n[i] = i + 1;
+      np[0] = 1.0;
+      np[1] = 1.0 + 2.0 * p;
+      np[2] = 1.0 + 4.0 * p;
+      np[3] = 3.0 + 2.0 * p;
+      np[4] = 5.0;
+      dn[0] = 0.0;
+      dn[1] = p / 2.0;
+      dn[2] = p;
+      dn[3] = (1.0 + p) / 2.0;
+      dn[4] = 1.0;
+    }
+    return;
+  }
+  Count++;
+
+  // Cell of x, extreme markers follow the minimum and maximum.
+  int k;
+  if (x < q[0]) {
+    q[0] = x;
+    k = 0;
+  }
+  else if (x >= q[4]) {
+    q[4] = x;
+    k = 3;
+  }
+  else {
+    k = 0;
+    while (x >= q[k + 1])
+      k++;
+  }
+  for (int i = k + 1; i < 5; i++)
+    n[i] += 1.0;
+  for (int i = 0; i < 5; i++)
+    np[i] += dn[i];
+
+  // Adjust the middle markers (parabolic, or linear if not monotonic).
+  for (int i = 1; i <= 3; i++) {
+    double d = np[i] - n[i];
+    if ((d >= 1.0 && n[i + 1] - n[i] > 1.0)
+        || (d <= -1.0 && n[i - 1] - n[i] < -1.0)) {
+      int s = d > 0.0 ? 1 : -1;
+      double qp = q[i]
+          + s / (n[i + 1] - n[i - 1])
+              * ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i])
+                  + (n[i + 1] - n[i] - s) * (q[i] - q[i - 1])
+                      / (n[i] - n[i - 1]));
+      if (q[i - 1] < qp && qp < q[i + 1])
+        q[i] = qp;
+      else
+        q[i] = q[i] + s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+      n[i] += s;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+double Taquart::P2Quantile::Value(void) const {
+  if (Count == 0)
+    return 0.0;
+  if (Count >= 5)
+    return q[2];
+  // Few observations: nearest rank.
+  double v[5];
+  std::copy(q, q + Count, v);
+  std::sort(v, v + Count);
+  int r = int(floor(p * Count));
+  return v[std::min(r, Count - 1)];
+}
+
+//-----------------------------------------------------------------------------
+//---- SolutionStats class.
+//-----------------------------------------------------------------------------
+Taquart::SolutionStats::SolutionStats(void) {
+  Taquart::FaultSolution s;
+  Reference(s);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::SolutionStats::Reference(const Taquart::FaultSolution &s) {
+  N = 0;
+  for (int i = 0; i < 6; i++) {
+    Mean[i] = 0.0;
+    for (int j = 0; j < 6; j++)
+      Co[i][j] = 0.0;
+  }
+  for (int i = 0; i < NANGLE; i++)
+    Cos[i] = Sin[i] = 0.0;
+  for (int i = 0; i < NQUANTITY; i++)
+    for (int j = 0; j < NQ; j++)
+      Q[i][j] = P2Quantile(Probabilities[j]);
+  double d[3];
+  PlaneVectors(s.FIA, s.DLA, s.RAKEA, RefNormal, d);
+  AxisVector(s.PXTR, s.PXPL, RefP);
+  AxisVector(s.TXTR, s.TXPL, RefT);
+  Frame(s, RefFrame);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::SolutionStats::Add(const Taquart::FaultSolution &s) {
+  N++;
+
+  // Mean and covariance of the tensor components.
+  const double m[6] = { s.M[1][1], s.M[1][2], s.M[1][3], s.M[2][2],
+      s.M[2][3], s.M[3][3] };
+  double delta[6];
+  for (int i = 0; i < 6; i++) {
+    delta[i] = m[i] - Mean[i];
+    Mean[i] += delta[i] / N;
+  }
+  for (int i = 0; i < 6; i++)
+    for (int j = i; j < 6; j++)
+      Co[i][j] += delta[i] * (m[j] - Mean[j]);
+
+  // The nodal plane closer to the first reference plane.
+  double na[3], nb[3], d[3];
+  PlaneVectors(s.FIA, s.DLA, s.RAKEA, na, d);
+  PlaneVectors(s.FIB, s.DLB, s.RAKEB, nb, d);
+  double ca = 0.0, cb = 0.0;
+  for (int i = 0; i < 3; i++) {
+    ca += na[i] * RefNormal[i];
+    cb += nb[i] * RefNormal[i];
+  }
+  const bool PlaneA = fabs(ca) >= fabs(cb);
+  double a[NANGLE] = { PlaneA ? s.FIA : s.FIB, PlaneA ? s.DLA : s.DLB,
+      PlaneA ? s.RAKEA : s.RAKEB, s.PXTR, s.PXPL, s.TXTR, s.TXPL };
+
+  // Planes and axes are undirected: the same plane with the opposite normal
+  // is (strike + 180, 180 - dip, -rake), so that a near-vertical plane or a
+  // near-horizontal axis does not jump by 180 degrees between samples.
+  if ((PlaneA ? ca : cb) < 0.0) {
+    a[aSTRIKE] += 180.0;
+    a[aDIP] = 180.0 - a[aDIP];
+    a[aRAKE] = -a[aRAKE];
+  }
+  AlignAxis(a[aPTREND], a[aPPLUNGE], RefP);
+  AlignAxis(a[aTTREND], a[aTPLUNGE], RefT);
+  for (int i = 0; i < NANGLE; i++) {
+    Cos[i] += cos(a[i] * D2R);
+    Sin[i] += sin(a[i] * D2R);
+  }
+
+  double F[3][3];
+  Frame(s, F);
+  const double v[NQUANTITY] = { s.M0, s.MAGN, s.EXPL, s.CLVD, s.DBCP,
+      FrameAngle(RefFrame, F) };
+  for (int i = 0; i < NQUANTITY; i++)
+    for (int j = 0; j < NQ; j++)
+      Q[i][j].Add(v[i]);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::SolutionStats::Write(std::ostream &Out) {
+  Out << "MEAN";
+  for (int i = 0; i < 6; i++)
+    Out << FOCIMT_SEP << Mean[i];
+  Out << std::endl;
+
+  Out << "COV";
+  for (int i = 0; i < 6; i++)
+    for (int j = i; j < 6; j++)
+      Out << FOCIMT_SEP << (N > 1 ? Co[i][j] / (N - 1) : 0.0);
+  Out << std::endl;
+
+  double m[NANGLE], sd[NANGLE];
+  for (int i = 0; i < NANGLE; i++) {
+    double c = N ? Cos[i] / N : 1.0, s = N ? Sin[i] / N : 0.0;
+    double R = std::min(1.0, sqrt(c * c + s * s));
+    m[i] = atan2(s, c) / D2R;
+    sd[i] = R > 0.0 ? sqrt(-2.0 * log(R)) / D2R : 180.0;
+  }
+
+  // Mean plane and axes back in the usual ranges (dip up to 90 degrees,
+  // plunges downwards).
+  if (m[aDIP] > 90.0) {
+    m[aSTRIKE] += 180.0;
+    m[aDIP] = 180.0 - m[aDIP];
+    m[aRAKE] = -m[aRAKE];
+  }
+  const int Axes[2] = { aPTREND, aTTREND };
+  for (int i = 0; i < 2; i++)
+    if (m[Axes[i] + 1] < 0.0) {
+      m[Axes[i]] += 180.0;
+      m[Axes[i] + 1] = -m[Axes[i] + 1];
+    }
+
+  Out << "ANGLE";
+  for (int i = 0; i < NANGLE; i++) {
+    if (i != aRAKE) {
+      m[i] = fmod(m[i], 360.0);
+      if (m[i] < 0.0)
+        m[i] += 360.0;
+    }
+    Out << FOCIMT_SEP << m[i] << FOCIMT_SEP << sd[i];
+  }
+  Out << std::endl;
+
+  const char * Names[NQUANTITY] = { "M0", "MAGN", "EXPL", "CLVD", "DBCP",
+      "ROTATION" };
+  for (int i = 0; i < NQUANTITY; i++) {
+    Out << "Q" << FOCIMT_SEP << Names[i];
+    for (int j = 0; j < NQ; j++)
+      Out << FOCIMT_SEP << Q[i][j].Value();
+    Out << std::endl;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---- ConvergenceMonitor class.
+//-----------------------------------------------------------------------------
+Taquart::ConvergenceMonitor::ConvergenceMonitor(double ATolerance) :
+    Tolerance(ATolerance), First(true), Stable(0) {
+  Last[0] = Last[1] = Last[2] = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ConvergenceMonitor::Start(
+    const Taquart::FaultSolutions &Reference) {
+  First = true;
+  Stable = 0;
+  Last[0] = Last[1] = Last[2] = 0.0;
+  Full.Reference(Reference.FullSolution);
+  DoubleCouple.Reference(Reference.DoubleCoupleSolution);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ConvergenceMonitor::Add(const Taquart::FaultSolutions &fs) {
+  Full.Add(fs.FullSolution);
+  DoubleCouple.Add(fs.DoubleCoupleSolution);
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::ConvergenceMonitor::Check(void) {
+  const double Median = Full.Quantile(SolutionStats::qM0, 2);
+  double Now[3];
+  Now[0] = DoubleCouple.Quantile(SolutionStats::qROTATION, 3);
+  Now[1] = Full.Quantile(SolutionStats::qDBCP, 3)
+      - Full.Quantile(SolutionStats::qDBCP, 1);
+  Now[2] =
+      Median > 0.0 ?
+          100.0
+              * (Full.Quantile(SolutionStats::qM0, 3)
+                  - Full.Quantile(SolutionStats::qM0, 1)) / Median :
+          0.0;
+
+  // The first check only sets the measures; two quiet batches in a row
+  // are required, so a single accidental match does not stop the test.
+  if (First) {
+    for (int i = 0; i < 3; i++)
+      Last[i] = Now[i];
+    First = false;
+    return false;
+  }
+  bool Quiet = Full.Count() > 0;
+  for (int i = 0; i < 3; i++) {
+    if (fabs(Now[i] - Last[i]) > Tolerance)
+      Quiet = false;
+    Last[i] = Now[i];
+  }
+  Stable = Quiet ? Stable + 1 : 0;
+  return Stable >= 2;
+}
+
+//-----------------------------------------------------------------------------
+//---- ResamplingStats class.
+//-----------------------------------------------------------------------------
+Taquart::ResamplingStats::ResamplingStats(void) :
+    Type('N') {
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ResamplingStats::Start(
+    const Taquart::FaultSolutions &Reference) {
+  Type = 'N';
+  Stats[0].Reference(Reference.FullSolution);
+  Stats[1].Reference(Reference.TraceNullSolution);
+  Stats[2].Reference(Reference.DoubleCoupleSolution);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ResamplingStats::Add(const Taquart::FaultSolutions &fs) {
+  Type = fs.Type;
+  Stats[0].Add(fs.FullSolution);
+  Stats[1].Add(fs.TraceNullSolution);
+  Stats[2].Add(fs.DoubleCoupleSolution);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::ResamplingStats::Write(std::ostream &Out,
+    Taquart::String EventId, int Kind) {
+  Out << EventId.c_str() << FOCIMT_SEP << Type << FOCIMT_SEP
+      << Stats[Kind].Count() << std::endl;
+  Stats[Kind].Write(Out);
+}
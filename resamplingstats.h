@@ -0,0 +1,194 @@
+//-----------------------------------------------------------------------------
+// Source: resamplingstats.h
+// Module: focimt
+// Streaming statistics of resampled inversions (option -st).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef RESAMPLINGSTATS_H_
+#define RESAMPLINGSTATS_H_
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include "focimtlib.h"
+
+namespace Taquart {
+
+  //! Streaming estimate of a single quantile (P-square algorithm).
+  /*! Five markers are kept, so the memory does not depend on the number
+   *  of observations (Jain and Chlamtac, 1985).
+   */
+  class P2Quantile {
+    public:
+      //! Constructor.
+      /*! \param AP Probability of the quantile (0..1).
+       */
+      P2Quantile(double AP = 0.5);
+
+      //! Adds an observation.
+      void Add(double x);
+
+      //! Current estimate of the quantile (0 without observations).
+      double Value(void) const;
+
+    private:
+      double p;
+      int Count;
+      double q[5]; // Marker heights.
+      double n[5]; // Marker positions.
+      double np[5]; // Desired marker positions.
+      double dn[5]; // Increments of the desired positions.
+  };
+
+  //! Running statistics of one solution type (full, trace-null or DC).
+  class SolutionStats {
+    public:
+      //! Number of quantiles kept for each quantity.
+      static const int NQ = 5;
+
+      //! Quantities with quantile estimates.
+      enum {
+        qM0, qMAGN, qEXPL, qCLVD, qDBCP, qROTATION, NQUANTITY
+      };
+
+      //! Angles with circular statistics.
+      enum {
+        aSTRIKE, aDIP, aRAKE, aPTREND, aPPLUNGE, aTTREND, aTPLUNGE, NANGLE
+      };
+
+      //! Constructor.
+      SolutionStats(void);
+
+      //! Sets the reference solution (clears the statistics).
+      void Reference(const Taquart::FaultSolution &s);
+
+      //! Adds a sample.
+      void Add(const Taquart::FaultSolution &s);
+
+      //! Writes the summary.
+      /*! Lines: MEAN (M11 M12 M13 M22 M23 M33), COV (upper triangle of the
+       *  covariance of the six components, by rows), ANGLE (circular mean
+       *  and standard deviation of strike, dip, rake of the nodal plane
+       *  closest to the first reference plane, P-axis trend and plunge,
+       *  T-axis trend and plunge; planes and axes are taken with the sign
+       *  of their normal or direction closest to the reference, so that
+       *  near-vertical planes and near-horizontal axes do not flip by 180
+       *  degrees) and one Q line per quantity with the
+       *  2.5, 16, 50, 84 and 97.5% quantiles: M0, MAGN, EXPL, CLVD, DBCP
+       *  and ROTATION (double-couple rotation angle to the reference).
+       */
+      void Write(std::ostream &Out);
+
+      //! Number of samples.
+      unsigned long Count(void) const {
+        return N;
+      }
+
+      //! Current estimate of quantile \p k (0..NQ-1) of a quantity.
+      double Quantile(int Quantity, int k) const {
+        return Q[Quantity][k].Value();
+      }
+
+    private:
+      unsigned long N;
+      double Mean[6];
+      double Co[6][6]; // Sums of products of deviations (Welford).
+      double Cos[NANGLE], Sin[NANGLE];
+      P2Quantile Q[NQUANTITY][NQ];
+      double RefNormal[3];
+      double RefP[3], RefT[3];
+      double RefFrame[3][3];
+  };
+
+  //! Sink for Invert() keeping only the statistics of the test inversions.
+  /*! The memory stays the same for any number of samples.
+   *  \ingroup libfocimt
+   */
+  class ResamplingStats: public Taquart::SolutionSink {
+    public:
+      //! Constructor.
+      ResamplingStats(void);
+
+      //! Takes the reference solutions (clears the statistics).
+      void Start(const Taquart::FaultSolutions &Reference);
+
+      //! Adds the solutions of a test inversion.
+      void Add(const Taquart::FaultSolutions &fs);
+
+      //! Writes the summary of the full (0), trace-null (1) or DC (2)
+      //! solutions, headed by the event id, test type and sample count.
+      void Write(std::ostream &Out, Taquart::String EventId, int Kind);
+
+    private:
+      char Type;
+      Taquart::SolutionStats Stats[3];
+  };
+
+  //! Convergence of the uncertainty of resampling tests.
+  /*! Tracks the 84% quantile of the rotation angle of the double couples to
+   *  the reference [deg], the 16-84% interval of the DC part of the full
+   *  solutions [%] and the 16-84% interval of their M0, relative to the
+   *  median [%]. Check() is called at the end of each batch of samples.
+   */
+  class ConvergenceMonitor {
+    public:
+      //! Constructor.
+      /*! \param ATolerance Largest change of all measures between two
+       *    batches, in their units, for the test to be converged.
+       */
+      ConvergenceMonitor(double ATolerance);
+
+      //! Takes the reference solutions.
+      void Start(const Taquart::FaultSolutions &Reference);
+
+      //! Adds the solutions of a test inversion.
+      void Add(const Taquart::FaultSolutions &fs);
+
+      //! \return \p true if no measure changed by more than the tolerance
+      //!   since the two previous checks.
+      bool Check(void);
+
+    private:
+      double Tolerance;
+      bool First; //!< No check since Start(), Last is not set.
+      int Stable;
+      double Last[3];
+      Taquart::SolutionStats Full, DoubleCouple;
+  };
+
+  //! Minimum rotation angle between two double couples [deg] (Kagan angle).
+  /*! \param a First double couple (FIA, DLA, RAKEA are used).
+   *  \param b Second double couple.
+   */
+  double RotationAngle(const Taquart::FaultSolution &a,
+      const Taquart::FaultSolution &b);
+
+  //! Minimum rotation angle between two double couples [deg] given by
+  //! their T and P axes (unit vectors, any sign).
+  double RotationAngle(const double Ta[3], const double Pa[3],
+      const double Tb[3], const double Pb[3]);
+}
+
+//-----------------------------------------------------------------------------
+#endif /* RESAMPLINGSTATS_H_ */
@@ -0,0 +1,387 @@
+//-----------------------------------------------------------------------------
+// Source: server.cpp
+// Module: focimt
+// Persistent inversion server (daemon mode, options -dm and -dw).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <ctype.h>
+#include <algorithm>
+#include <iostream>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+#include "solutioncache.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  // Set by SIGINT and SIGTERM in the parent of the socket workers.
+  volatile sig_atomic_t Stop = 0;
+
+  void OnStop(int) {
+    Stop = 1;
+  }
+
+  // Reads a whitespace-delimited token of at most Size - 1 characters.
+  // Returns 1 - token read, 0 - end of stream, -1 - longer token (skipped,
+  // so that it is not taken for a different, truncated one).
+  int ReadToken(FILE * In, char * Buffer, int Size) {
+    char Format[16];
+    sprintf(Format, "%%%ds", Size - 1);
+    if (fscanf(In, Format, Buffer) != 1)
+      return 0;
+    int c = fgetc(In);
+    if (c == EOF || isspace(c))
+      return 1;
+    while (c != EOF && !isspace(c))
+      c = fgetc(In);
+    return -1;
+  }
+
+  // Reads a station line of a request (id component phase moment azimuth
+  // aoi takeoff velocity distance density).
+  bool ReadStation(FILE * In, char id[50], char component[10],
+      char phase[10], double &moment, double &azimuth, double &aoi,
+      double &takeoff, double &velocity, double &distance, double &density) {
+    return ReadToken(In, id, 50) == 1 && ReadToken(In, component, 10) == 1
+        && ReadToken(In, phase, 10) == 1
+        && fscanf(In, "%lf %lf %lf %lf %lf %lf %lf", &moment, &azimuth, &aoi,
+            &takeoff, &velocity, &distance, &density) == 7;
+  }
+}
+
+//-----------------------------------------------------------------------------
+Taquart::InversionServer::InversionServer(
+    const Taquart::InversionOptions &AOptions) :
+    Options(AOptions) {
+  // Channel amplitudes are not part of the response.
+  Options.Residuals = false;
+}
+
+//-----------------------------------------------------------------------------
+int Taquart::InversionServer::ServeStdin(void) {
+  Serve(stdin, stdout);
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int Taquart::InversionServer::ServeSocket(Taquart::String Path, int Workers) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (Path.Length() == 0 || Path.Length() >= int(sizeof(addr.sun_path))) {
+    std::cerr << "Invalid socket path." << std::endl;
+    return 1;
+  }
+  strcpy(addr.sun_path, Path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    std::cerr << "Cannot create socket." << std::endl;
+    return 1;
+  }
+  unlink(Path.c_str());
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+      || listen(fd, 64) < 0) {
+    std::cerr << "Cannot listen on socket " << Path.c_str() << std::endl;
+    close(fd);
+    return 1;
+  }
+
+  // Clients closing the connection early must not kill the workers.
+  signal(SIGPIPE, SIG_IGN);
+
+  // SIGINT and SIGTERM stop the workers and remove the socket. Without
+  // SA_RESTART they interrupt the wait below.
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OnStop;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  if (Workers < 1)
+    Workers = 1;
+  std::vector<pid_t> Pool;
+  for (int i = 0; i < Workers && !Stop; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      signal(SIGINT, SIG_DFL);
+      signal(SIGTERM, SIG_DFL);
+      for (;;) {
+        int cfd = accept(fd, NULL, NULL);
+        if (cfd < 0) {
+          const int Error = errno;
+          if (Error == EINTR || Error == ECONNABORTED)
+            continue;
+          std::cerr << "Cannot accept connection: " << strerror(Error)
+              << std::endl;
+          // Out of descriptors or memory: wait for other clients to finish.
+          if (Error == EMFILE || Error == ENFILE || Error == ENOBUFS
+              || Error == ENOMEM) {
+            sleep(1);
+            continue;
+          }
+          _exit(1);
+        }
+        FILE * In = fdopen(cfd, "r");
+        FILE * Out = fdopen(dup(cfd), "w");
+        if (In && Out)
+          Serve(In, Out);
+        if (In)
+          fclose(In);
+        if (Out)
+          fclose(Out);
+      }
+    }
+    else if (pid > 0)
+      Pool.push_back(pid);
+  }
+
+  // The parent only waits for the workers.
+  int status;
+  while (Pool.size() > 0) {
+    pid_t pid = wait(&status);
+    if (pid > 0)
+      Pool.erase(std::remove(Pool.begin(), Pool.end(), pid), Pool.end());
+    else if (errno != EINTR)
+      break;
+    if (Stop) {
+      for (unsigned int i = 0; i < Pool.size(); i++)
+        kill(Pool[i], SIGTERM);
+      while (wait(&status) > 0 || errno == EINTR)
+        ;
+      Pool.clear();
+    }
+  }
+  close(fd);
+  unlink(Path.c_str());
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::InversionServer::Serve(FILE * In, FILE * Out) {
+  Taquart::String EventId;
+  Taquart::SMTInputData InputData;
+  std::vector<Taquart::FaultSolutions> FSList;
+  std::map<std::string, Taquart::EventSession> Sessions;
+  char fileid[50];
+  for (;;) {
+    const int r = ReadToken(In, fileid, sizeof(fileid));
+    if (r == 0)
+      break;
+    if (r < 0) {
+      fprintf(Out, "%s\tERR\ttoken too long\n", fileid);
+      fflush(Out);
+      break;
+    }
+    const Taquart::String Command(fileid);
+    if (Command == "ADD" || Command == "DEL" || Command == "AMP"
+        || Command == "SOLVE" || Command == "CLOSE") {
+      if (!ServeSession(In, Out, Command, Sessions))
+        break;
+      continue;
+    }
+    if (!ReadEvent(In, fileid, EventId, InputData)) {
+      fprintf(Out, "%s\tERR\tmalformed request\n", EventId.c_str());
+      fflush(Out);
+      break;
+    }
+
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
+
+    // With a fixed seed the random sequence depends on the event data only.
+    Taquart::InversionOptions o = Options;
+    if (o.SeedSet) {
+      Taquart::FNVHash Hash;
+      Hash.Add(int(Options.Seed));
+      Hash.Add(InputData);
+      o.Seed = (unsigned int) (Hash.Value() ^ (Hash.Value() >> 32));
+    }
+
+    FSList.clear();
+    if (!Taquart::Invert(InputData, o, FSList)) {
+      fprintf(Out, "%s\tERR\tinversion failed\n", EventId.c_str());
+      fflush(Out);
+      continue;
+    }
+    for (unsigned int i = 0; i < FSList.size(); i++) {
+      WriteSolution(Out, EventId, FSList[i], 'F', FSList[i].FullSolution);
+      WriteSolution(Out, EventId, FSList[i], 'D',
+          FSList[i].TraceNullSolution);
+      WriteSolution(Out, EventId, FSList[i], 'C',
+          FSList[i].DoubleCoupleSolution);
+    }
+
+    gettimeofday(&t1, NULL);
+    long long us = (t1.tv_sec - t0.tv_sec) * 1000000LL
+        + (t1.tv_usec - t0.tv_usec);
+    fprintf(Out, "%s\tEND\t%u\t%lld\n", EventId.c_str(),
+        (unsigned int) FSList.size(), us);
+    fflush(Out);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::InversionServer::ServeSession(FILE * In, FILE * Out,
+    Taquart::String Command,
+    std::map<std::string, Taquart::EventSession> &Sessions) {
+  char id[50], phase[10], component[10], fileid[50];
+  double moment = 0.0;
+  double azimuth = 0.0, takeoff = 0.0, velocity = 0.0, distance = 0.0,
+      density = 0.0, aoi = 0.0;
+
+  bool Ok = ReadToken(In, fileid, sizeof(fileid)) == 1;
+  if (Ok && Command == "ADD")
+    Ok = ReadStation(In, id, component, phase, moment, azimuth, aoi, takeoff,
+        velocity, distance, density);
+  else if (Ok && (Command == "DEL" || Command == "AMP"))
+    Ok = ReadToken(In, id, sizeof(id)) == 1
+        && ReadToken(In, component, sizeof(component)) == 1
+        && (Command == "DEL" || fscanf(In, "%lf", &moment) == 1);
+  if (!Ok) {
+    fprintf(Out, "%s\tERR\tmalformed request\n", Command.c_str());
+    fflush(Out);
+    return false;
+  }
+  Taquart::String EventId(fileid);
+
+  struct timeval t0, t1;
+  gettimeofday(&t0, NULL);
+
+  std::map<std::string, Taquart::EventSession>::iterator it = Sessions.find(
+      fileid);
+  if (it == Sessions.end() && Command == "ADD")
+    it = Sessions.insert(
+        std::make_pair(std::string(fileid), Taquart::EventSession(Options))).first;
+  if (it == Sessions.end()) {
+    fprintf(Out, "%s\tERR\tunknown session\n", EventId.c_str());
+    fflush(Out);
+    return true;
+  }
+  Taquart::EventSession &Session = it->second;
+
+  const char * Error = NULL;
+  unsigned int Count = 0;
+  if (Command == "SOLVE") {
+    std::vector<Taquart::FaultSolutions> FSList;
+    if (Session.Solve(FSList)) {
+      for (unsigned int i = 0; i < FSList.size(); i++) {
+        WriteSolution(Out, EventId, FSList[i], 'F', FSList[i].FullSolution);
+        WriteSolution(Out, EventId, FSList[i], 'D',
+            FSList[i].TraceNullSolution);
+        WriteSolution(Out, EventId, FSList[i], 'C',
+            FSList[i].DoubleCoupleSolution);
+      }
+      Count = FSList.size();
+    }
+    else
+      Error = "inversion failed";
+  }
+  else if (Command == "CLOSE")
+    Sessions.erase(it);
+  else {
+    const int Handle = Session.Find(Taquart::String(id),
+        Taquart::String(component));
+    if (Command == "ADD") {
+      // A pick of a component already in the session is revised.
+      if (Handle >= 0)
+        Session.Remove(Handle);
+      Session.Add(
+          Taquart::StationLine(Taquart::String(id), Session.Count() + 1,
+              Taquart::String(component), Taquart::String(phase), moment,
+              azimuth, aoi, takeoff, velocity, distance, density));
+    }
+    else if (Handle < 0)
+      Error = "unknown channel";
+    else if (Command == "DEL")
+      Session.Remove(Handle);
+    else {
+      // Displacement of a vertical sensor, as in StationLine().
+      const double Incidence = Session.Line(Handle).Incidence;
+      Session.SetDisplacement(Handle, moment / cos(Incidence * M_PI / 180.0));
+    }
+    Count = Session.Count();
+  }
+
+  gettimeofday(&t1, NULL);
+  long long us = (t1.tv_sec - t0.tv_sec) * 1000000LL
+      + (t1.tv_usec - t0.tv_usec);
+  if (Error)
+    fprintf(Out, "%s\tERR\t%s\n", EventId.c_str(), Error);
+  else
+    fprintf(Out, "%s\t%s\t%u\t%lld\n", EventId.c_str(),
+        Command == "SOLVE" ? "END" : "OK", Count, us);
+  fflush(Out);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::InversionServer::ReadEvent(FILE * In, const char * FileId,
+    Taquart::String &EventId, Taquart::SMTInputData &InputData) {
+  char id[50], phase[10], component[10];
+  double moment = 0.0;
+  double azimuth = 0.0, takeoff = 0.0, velocity = 0.0, distance = 0.0,
+      density = 0.0, aoi = 0.0;
+  unsigned int N = 0;
+
+  InputData.Clear();
+  EventId = Taquart::String(FileId);
+  if (fscanf(In, "%u", &N) != 1 || N == 0)
+    return false;
+  for (unsigned int i = 0; i < N; i++) {
+    if (!ReadStation(In, id, component, phase, moment, azimuth, aoi, takeoff,
+        velocity, distance, density))
+      return false;
+    Taquart::SMTInputLine il = Taquart::StationLine(Taquart::String(id),
+        i + 1, Taquart::String(component), Taquart::String(phase), moment,
+        azimuth, aoi, takeoff, velocity, distance, density);
+    InputData.Add(il);
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::InversionServer::WriteSolution(FILE * Out,
+    Taquart::String &EventId, Taquart::FaultSolutions &fs, char Kind,
+    Taquart::FaultSolution &s) {
+  fprintf(Out, "%s\t%c\t%d\t%c", EventId.c_str(), fs.Type, fs.Channel, Kind);
+  fprintf(Out, "\t%.9g\t%.9g\t%.9g\t%.9g\t%.9g\t%.9g", s.M[1][1], s.M[1][2],
+      s.M[1][3], s.M[2][2], s.M[2][3], s.M[3][3]);
+  fprintf(Out, "\t%.9g\t%.9g\t%.9g\t%.9g", s.M0, s.MT, s.ERR, s.UERR);
+  fprintf(Out, "\t%.6g\t%.6g\t%.6g", s.EXPL, s.CLVD, s.DBCP);
+  fprintf(Out, "\t%.6g\t%.6g\t%.6g\t%.6g\t%.6g\t%.6g", s.FIA, s.DLA, s.RAKEA,
+      s.FIB, s.DLB, s.RAKEB);
+  fprintf(Out, "\t%.4g\n", s.MAGN);
+}
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// Source: server.h
+// Module: focimt
+// Persistent inversion server (daemon mode, options -dm and -dw).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SERVER_H_
+#define SERVER_H_
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <map>
+#include <string>
+#include "focimtlib.h"
+#include "session.h"
+
+namespace Taquart {
+
+  //! Inversion server for real-time processing.
+  /*! Events are read from standard input or from connections to a Unix
+   *  domain socket, inverted with fixed options and the solutions are
+   *  written back as tab-separated lines, one line per solution.
+   *
+   *  Request (the standard focimt input format, any whitespace):
+   *  \code
+   *  fileid N
+   *  id component phase moment azimuth aoi takeoff velocity distance density
+   *  ... (N lines)
+   *  \endcode
+   *
+   *  Response:
+   *  \code
+   *  fileid type channel F|D|C M11 M12 M13 M22 M23 M33 M0 MT ERR UERR
+   *    EXPL CLVD DBCP strikeA dipA rakeA strikeB dipB rakeB MW  (per solution)
+   *  fileid END count latency_us
+   *  \endcode
+   *  F, D and C stand for the full, trace-null (deviatoric) and
+   *  double-couple solution. The latency covers the inversion and the
+   *  output of the event. Malformed requests, including ids longer than 49
+   *  and components or phases longer than 9 characters, are answered with
+   *  "fileid ERR message" and the connection is closed.
+   *
+   *  Picks of an event can also be sent one at a time to an event session
+   *  of the connection (see EventSession), which keeps the L2 solutions up
+   *  to date with rank-one updates (the norm and tests of the options do
+   *  not apply). ADD, DEL, AMP, SOLVE and CLOSE are thus not valid fileids:
+   *  \code
+   *  ADD fileid id component phase moment azimuth aoi takeoff velocity
+   *    distance density      (new pick; revises the pick of the component)
+   *  DEL fileid id component        (removes a pick)
+   *  AMP fileid id component moment (revises the amplitude of a pick)
+   *  SOLVE fileid                   (decomposes the current solutions)
+   *  CLOSE fileid                   (drops the session)
+   *  \endcode
+   *  ADD, DEL, AMP and CLOSE are answered with "fileid OK channels
+   *  latency_us", SOLVE with the solution lines and the END line of an
+   *  event. Requests for unknown sessions or channels, and SOLVE with less
+   *  than FOCIMT_MIN_ALLOWED_CHANNELS picks, are answered with "fileid ERR
+   *  message" and the connection stays open.
+   *
+   *  The inversion core is not reentrant, so the socket server runs a pool
+   *  of pre-forked worker processes, each accepting connections on the
+   *  same socket and keeping its USMT tables warm between events. SIGINT
+   *  and SIGTERM stop the workers and remove the socket file.
+   */
+  class InversionServer {
+    public:
+      //! Constructor.
+      /*! \param AOptions Inversion options of all events.
+       */
+      InversionServer(const Taquart::InversionOptions &AOptions);
+
+      //! Serves events from standard input until end of file.
+      /*! \return Program exit code.
+       */
+      int ServeStdin(void);
+
+      //! Serves events from connections to a Unix domain socket.
+      /*! \param Path Socket path (an existing socket file is replaced).
+       *  \param Workers Number of worker processes.
+       *  \return Program exit code.
+       */
+      int ServeSocket(Taquart::String Path, int Workers);
+
+    private:
+      Taquart::InversionOptions Options;
+
+      //! Serves all events of a single stream.
+      void Serve(FILE * In, FILE * Out);
+
+      //! Reads a single event.
+      /*! \param FileId Event id, already read.
+       *  \return \p false if the request is malformed.
+       */
+      bool ReadEvent(FILE * In, const char * FileId,
+          Taquart::String &EventId, Taquart::SMTInputData &InputData);
+
+      //! Serves a request to an event session.
+      /*! \param Command Request (ADD, DEL, AMP, SOLVE or CLOSE).
+       *  \param Sessions Event sessions of the stream.
+       *  \return \p false if the request is malformed.
+       */
+      bool ServeSession(FILE * In, FILE * Out, Taquart::String Command,
+          std::map<std::string, Taquart::EventSession> &Sessions);
+
+      //! Writes a single solution line.
+      void WriteSolution(FILE * Out, Taquart::String &EventId,
+          Taquart::FaultSolutions &fs, char Kind, Taquart::FaultSolution &s);
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* SERVER_H_ */
@@ -0,0 +1,290 @@
+//-----------------------------------------------------------------------------
+// Source: session.cpp
+// Module: focimt
+// Incremental L2 inversion of a single event (event sessions).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <memory>
+#include "session.h"
+#include "usmtcore.h"
+#include "symsolve.h"
+
+namespace {
+  // Updates between refactorizations of the inverses.
+  const int RESYNC = 64;
+
+  // Kernel rows of a channel, as computed from the input line by ANGGA,
+  // RDINP and KERNEL.
+  void KernelRows(const Taquart::SMTInputLine &Line, double a[], double h[]) {
+    double GA[3 + 1];
+    Taquart::UsmtCore::RAYGA(Line.Azimuth, Line.TakeOff, GA);
+    Taquart::UsmtCore::KERNELROW(GA, int(Line.Density), int(Line.Velocity),
+        int(Line.Distance), a);
+
+    // Trace-null rows (H in MOM2).
+    h[1] = a[1] - a[6];
+    h[2] = a[2];
+    h[3] = a[3];
+    h[4] = a[4] - a[6];
+    h[5] = a[5];
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---- Normal equations.
+//-----------------------------------------------------------------------------
+template<int P>
+void Taquart::EventSession::Normal<P>::Clear(void) {
+  for (int i = 0; i <= P; i++) {
+    B[i] = X[i] = 0.0;
+    for (int j = 0; j <= P; j++)
+      N[i][j] = Inv[i][j] = 0.0;
+  }
+  Valid = false;
+}
+
+//-----------------------------------------------------------------------------
+template<int P>
+void Taquart::EventSession::Normal<P>::Update(const double a[], double u,
+    double Sign) {
+  for (int i = 1; i <= P; i++) {
+    B[i] += Sign * a[i] * u;
+    for (int j = 1; j <= P; j++)
+      N[i][j] += Sign * a[i] * a[j];
+  }
+  if (!Valid)
+    return;
+
+  // Sherman-Morrison: with g = Inv a and d = 1 + Sign a'g, the inverse
+  // changes by -Sign g g'/d and the solution by Sign g (u - a'X)/d.
+  double g[P + 1];
+  double ag = 0.0, r = u;
+  for (int i = 1; i <= P; i++) {
+    g[i] = 0.0;
+    for (int j = 1; j <= P; j++)
+      g[i] += Inv[i][j] * a[j];
+    ag += a[i] * g[i];
+    r -= a[i] * X[i];
+  }
+  const double d = 1.0 + Sign * ag;
+  if (d <= 1.0e-10 * (1.0 + ag)) {
+    // The removed row carried a direction of its own: N is singular.
+    Valid = false;
+    return;
+  }
+  const double f = Sign / d;
+  for (int i = 1; i <= P; i++) {
+    X[i] += f * g[i] * r;
+    for (int j = 1; j <= P; j++)
+      Inv[i][j] -= f * g[i] * g[j];
+  }
+}
+
+//-----------------------------------------------------------------------------
+template<int P>
+void Taquart::EventSession::Normal<P>::Shift(const double a[], double du) {
+  for (int i = 1; i <= P; i++)
+    B[i] += a[i] * du;
+  if (!Valid)
+    return;
+  for (int i = 1; i <= P; i++)
+    for (int j = 1; j <= P; j++)
+      X[i] += Inv[i][j] * a[j] * du;
+}
+
+//-----------------------------------------------------------------------------
+template<int P>
+bool Taquart::EventSession::Normal<P>::Refactor(void) {
+  Taquart::UsmtCore::SymmetricSolver<P> S;
+  Valid = S.Factor(N);
+  if (!Valid)
+    return false;
+  double e[P + 1], c[P + 1];
+  for (int j = 1; j <= P; j++) {
+    for (int i = 1; i <= P; i++)
+      e[i] = i == j ? 1.0 : 0.0;
+    S.Solve(e, c);
+    for (int i = 1; i <= P; i++)
+      Inv[i][j] = c[i];
+  }
+  S.Solve(B, X);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//---- EventSession class.
+//-----------------------------------------------------------------------------
+Taquart::EventSession::EventSession(const Taquart::InversionOptions &AOptions) :
+    Options(AOptions), Active(0), Updates(0) {
+  Options.Norm = Taquart::ntL2;
+  Full.Clear();
+  Deviatoric.Clear();
+}
+
+//-----------------------------------------------------------------------------
+int Taquart::EventSession::Add(const Taquart::SMTInputLine &Line) {
+  Channel c;
+  c.Line = Line;
+  KernelRows(Line, c.a, c.h);
+  c.u = Line.Displacement * USMT_UPSCALE;
+  c.Active = true;
+  int Handle = int(Channels.size());
+  if (Free.empty())
+    Channels.push_back(c);
+  else {
+    Handle = Free.back();
+    Free.pop_back();
+    Channels[Handle] = c;
+  }
+  Active++;
+  Full.Update(c.a, c.u, 1.0);
+  Deviatoric.Update(c.h, c.u, 1.0);
+  Resync();
+  return Handle;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::EventSession::Remove(int Handle) {
+  if (Handle < 0 || Handle >= int(Channels.size())
+      || !Channels[Handle].Active)
+    return false;
+  Channel &c = Channels[Handle];
+  c.Active = false;
+  Free.push_back(Handle);
+  Active--;
+  Full.Update(c.a, c.u, -1.0);
+  Deviatoric.Update(c.h, c.u, -1.0);
+  Resync();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::EventSession::SetDisplacement(int Handle, double Displacement) {
+  if (Handle < 0 || Handle >= int(Channels.size())
+      || !Channels[Handle].Active)
+    return false;
+  Channel &c = Channels[Handle];
+  const double u = Displacement * USMT_UPSCALE;
+  Full.Shift(c.a, u - c.u);
+  Deviatoric.Shift(c.h, u - c.u);
+  c.u = u;
+  c.Line.Displacement = Displacement;
+  Resync();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+int Taquart::EventSession::Find(const Taquart::String &Name,
+    const Taquart::String &Component) const {
+  for (unsigned int i = 0; i < Channels.size(); i++) {
+    const Channel &c = Channels[i];
+    if (c.Active && c.Line.Name == Name && c.Line.Component == Component)
+      return int(i);
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+const Taquart::SMTInputLine & Taquart::EventSession::Line(int Handle) const {
+  return Channels[Handle].Line;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Taquart::EventSession::Count(void) const {
+  return Active;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::EventSession::Tensor(double M[6], double MD[6]) const {
+  if (Active < FOCIMT_MIN_ALLOWED_CHANNELS || !Full.Valid
+      || !Deviatoric.Valid)
+    return false;
+  for (int i = 0; i < 6; i++)
+    M[i] = Full.X[i + 1];
+  for (int i = 0; i < 5; i++)
+    MD[i] = Deviatoric.X[i + 1];
+  MD[5] = -MD[0] - MD[3];
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::EventSession::Solve(
+    std::vector<Taquart::FaultSolutions> &FSList) {
+  double M[6], MD[6];
+  if (!Tensor(M, MD))
+    return false;
+
+  // Channels in the order of their handles, keyed as in Invert().
+  Taquart::SMTInputData InputData;
+  std::shared_ptr<std::vector<Taquart::String> > Names = std::make_shared<
+      std::vector<Taquart::String> >();
+  for (unsigned int i = 0; i < Channels.size(); i++) {
+    if (!Channels[i].Active)
+      continue;
+    Taquart::SMTInputLine InputLine = Channels[i].Line;
+    InputLine.Key = Names->size();
+    Names->push_back(InputLine.Name);
+    InputData.Add(InputLine);
+  }
+  const bool Residuals = Taquart::UsmtCore::RESIDUALS;
+  Taquart::UsmtCore::RESIDUALS = Options.Residuals;
+  if (Options.Residuals)
+    Taquart::UsmtCore::NAMES = Names;
+
+  for (int i = 1; i <= 6; i++) {
+    Taquart::UsmtCore::GIVENRM[i][1] = M[i - 1];
+    Taquart::UsmtCore::GIVENRM[i][2] = MD[i - 1];
+  }
+  Taquart::UsmtCore::GIVENL2 = true;
+  const bool Result = MTInversion(Taquart::ntL2, Options.QualityType,
+      InputData, 0, 'N', FSList);
+  Taquart::UsmtCore::GIVENL2 = false;
+  Taquart::UsmtCore::RESIDUALS = Residuals;
+  Taquart::UsmtCore::NAMES.reset();
+  return Result;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::EventSession::Clear(void) {
+  Channels.clear();
+  Free.clear();
+  Active = 0;
+  Updates = 0;
+  Full.Clear();
+  Deviatoric.Clear();
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::EventSession::Resync(void) {
+  const bool Due = ++Updates >= RESYNC;
+  if (Active < FOCIMT_MIN_ALLOWED_CHANNELS)
+    return;
+  if (Due || !Full.Valid || !Deviatoric.Valid) {
+    Updates = 0;
+    Full.Refactor();
+    Deviatoric.Refactor();
+  }
+}
@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// Source: session.h
+// Module: focimt
+// Incremental L2 inversion of a single event (event sessions).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SESSION_H_
+#define SESSION_H_
+//-----------------------------------------------------------------------------
+#include <vector>
+#include "focimtlib.h"
+
+namespace Taquart {
+
+  //! L2 inversion of an event whose picks are added or revised one by one.
+  /*! The session keeps the kernel row and the amplitude of every channel,
+   *  the normal equations of the full and trace-null solutions, their
+   *  inverses and the current solutions. Adding or removing a channel is a
+   *  rank-one (Sherman-Morrison) update of the inverses and the solutions,
+   *  a changed amplitude only shifts the solutions, so an update costs a
+   *  few hundred floating point operations and does not touch UsmtCore.
+   *  The inverses are refactored from the normal equations every 64
+   *  updates (to bound rounding), and whenever the equations become
+   *  regular again after having too few channels.
+   *
+   *  Solve() passes the current solutions to UsmtCore (see GIVENL2), which
+   *  then only computes the decomposition, the covariance, the quality and
+   *  the double-couple refinement. Its solution equals that of Invert()
+   *  with the same channels and the L2 norm, up to rounding.
+   */
+  class EventSession {
+    public:
+      //! Constructor.
+      /*! \param AOptions Inversion options (the norm is always L2, tests
+       *    are not run).
+       */
+      EventSession(const Taquart::InversionOptions &AOptions =
+          Taquart::InversionOptions());
+
+      //! Adds a channel.
+      /*! \param Line Station data (see StationLine()).
+       *  \return Handle of the channel (handles of removed channels are
+       *    reused).
+       */
+      int Add(const Taquart::SMTInputLine &Line);
+
+      //! Removes a channel.
+      /*! \return \p false if the handle is not a channel of the session.
+       */
+      bool Remove(int Handle);
+
+      //! Revises the amplitude of a channel.
+      /*! \param Handle Channel handle.
+       *  \param Displacement New displacement (SMTInputLine::Displacement).
+       *  \return \p false if the handle is not a channel of the session.
+       */
+      bool SetDisplacement(int Handle, double Displacement);
+
+      //! Finds the channel of a station component.
+      /*! \return Channel handle or -1.
+       */
+      int Find(const Taquart::String &Name,
+          const Taquart::String &Component) const;
+
+      //! Station data of a channel.
+      const Taquart::SMTInputLine & Line(int Handle) const;
+
+      //! Number of channels.
+      unsigned int Count(void) const;
+
+      //! Current L2 solutions.
+      /*! \param Full Full moment tensor M11, M12, M13, M22, M23, M33.
+       *  \param TraceNull Trace-null moment tensor, in the same order.
+       *  \return \p false if there are less than
+       *    FOCIMT_MIN_ALLOWED_CHANNELS channels or the equations are
+       *    singular.
+       */
+      bool Tensor(double Full[6], double TraceNull[6]) const;
+
+      //! Decomposes the current solutions.
+      /*! \param FSList Solutions (type 'N') are appended to this list.
+       *  \return \p false if Tensor() fails or the inversion failed.
+       */
+      bool Solve(std::vector<Taquart::FaultSolutions> &FSList);
+
+      //! Removes all channels.
+      void Clear(void);
+
+    private:
+      //! Normal equations of P parameters with their inverse and solution.
+      template<int P>
+      class Normal {
+        public:
+          double N[P + 1][P + 1]; /*!< Normal matrix. */
+          double B[P + 1]; /*!< Right hand side. */
+          double Inv[P + 1][P + 1]; /*!< Inverse of N (if Valid). */
+          double X[P + 1]; /*!< Solution (if Valid). */
+          bool Valid;
+
+          void Clear(void);
+
+          //! Adds (Sign 1) or removes (Sign -1) the row a with datum u.
+          void Update(const double a[], double u, double Sign);
+
+          //! Changes the datum of the row a by du.
+          void Shift(const double a[], double du);
+
+          //! Inverts N and solves for X again.
+          bool Refactor(void);
+      };
+
+      //! Channel of the session.
+      class Channel {
+        public:
+          Taquart::SMTInputLine Line;
+          double a[6 + 1]; /*!< Kernel row of the full solution. */
+          double h[5 + 1]; /*!< Kernel row of the trace-null solution. */
+          double u; /*!< Displacement (upscaled as in UsmtCore). */
+          bool Active;
+      };
+
+      Taquart::InversionOptions Options;
+      std::vector<Channel> Channels;
+      std::vector<int> Free; /*!< Handles of removed channels. */
+      unsigned int Active;
+      int Updates;
+      Normal<6> Full;
+      Normal<5> Deviatoric;
+
+      //! Refactors both systems when they are due to.
+      void Resync(void);
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* SESSION_H_ */
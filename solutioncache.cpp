@@ -0,0 +1,398 @@
+//-----------------------------------------------------------------------------
+// Source: solutioncache.cpp
+// Module: focimt
+// Persistent cache of moment tensor inversion results.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "solutioncache.h"
+//-----------------------------------------------------------------------------
+
+// File signature. Change the version number whenever the layout of
+// the FaultSolution or FaultSolutions classes changes.
+#define SOLUTIONCACHE_MAGIC "FOCIMTS4"
+
+//-----------------------------------------------------------------------------
+//---- FNVHash class.
+//-----------------------------------------------------------------------------
+Taquart::FNVHash::FNVHash(void) {
+  h = 14695981039346656037ULL;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::FNVHash::Add(const void *Data, size_t Size) {
+  const unsigned char *p = (const unsigned char *) Data;
+  for (size_t i = 0; i < Size; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::FNVHash::Add(double Value) {
+  Add(&Value, sizeof(Value));
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::FNVHash::Add(int Value) {
+  Add(&Value, sizeof(Value));
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::FNVHash::Add(Taquart::String Value) {
+  // Terminating zero separates consecutive strings.
+  Add(Value.c_str(), Value.Length() + 1);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::FNVHash::Add(Taquart::SMTInputData &InputData) {
+  // All fields of the station lines used by the inversion.
+  Add(int(InputData.Count()));
+  for (unsigned int i = 0; i < InputData.Count(); i++) {
+    Taquart::SMTInputLine il;
+    InputData.Get(i, il);
+    Add(il.Name);
+    Add(int(il.Id));
+    Add(il.Component);
+    Add(il.MarkerType);
+    Add(il.Start);
+    Add(il.End);
+    Add(il.Duration);
+    Add(il.Displacement);
+    Add(il.Incidence);
+    Add(il.Azimuth);
+    Add(il.TakeOff);
+    Add(il.Distance);
+    Add(il.Density);
+    Add(il.Velocity);
+    Add(int(il.PickActive));
+    Add(int(il.ChannelActive));
+  }
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long Taquart::FNVHash::Value(void) {
+  return h;
+}
+
+//-----------------------------------------------------------------------------
+Taquart::String Taquart::FNVHash::Hex(void) {
+  char key[32];
+  sprintf(key, "%016llx", h);
+  return Taquart::String(key);
+}
+
+//-----------------------------------------------------------------------------
+//---- Serialization of solutions.
+//-----------------------------------------------------------------------------
+namespace {
+
+  //---------------------------------------------------------------------------
+  void Put(std::vector<char> &Buffer, const void *Data, size_t Size) {
+    const char *p = (const char *) Data;
+    Buffer.insert(Buffer.end(), p, p + Size);
+  }
+
+  //---------------------------------------------------------------------------
+  void PutString(std::vector<char> &Buffer, Taquart::String Value) {
+    int n = Value.Length();
+    Put(Buffer, &n, sizeof(n));
+    Put(Buffer, Value.c_str(), n);
+  }
+
+  //---------------------------------------------------------------------------
+  // Reader of the memory-mapped file with bounds checking.
+  class Cursor {
+    public:
+      Cursor(const char *AData, size_t ASize) :
+          Data(AData), Size(ASize), Pos(0) {
+      }
+      bool Get(void *Dest, size_t n) {
+        if (Pos + n > Size)
+          return false;
+        memcpy(Dest, Data + Pos, n);
+        Pos += n;
+        return true;
+      }
+      bool GetString(Taquart::String &Value) {
+        int n;
+        if (!Get(&n, sizeof(n)) || n < 0 || Pos + n > Size)
+          return false;
+        Value = Taquart::String(std::string(Data + Pos, n));
+        Pos += n;
+        return true;
+      }
+      size_t Left(void) const {
+        return Size - Pos;
+      }
+    private:
+      const char *Data;
+      size_t Size;
+      size_t Pos;
+  };
+
+  //---------------------------------------------------------------------------
+  // Pointers to the scalar fields of the solution, in the file order.
+  void Scalars(Taquart::FaultSolution &s, double *v[]) {
+    double *f[] = { &s.T0, &s.M0, &s.MT, &s.ERR, &s.EXPL, &s.CLVD, &s.DBCP,
+        &s.EXPL_VAC, &s.CLVD_VAC, &s.DBCP_VAC, &s.FIA, &s.DLA, &s.RAKEA,
+        &s.FIB, &s.DLB, &s.RAKEB, &s.PXTR, &s.PXPL, &s.PXAM, &s.TXTR, &s.TXPL,
+        &s.TXAM, &s.BXTR, &s.BXPL, &s.BXAM, &s.QI, &s.MAGN, &s.UERR, &s.E[0],
+        &s.E[1], &s.E[2] };
+    for (int i = 0; i < 31; i++)
+      v[i] = f[i];
+  }
+
+  //---------------------------------------------------------------------------
+  void PutSolution(std::vector<char> &Buffer, Taquart::FaultSolution &s) {
+    double *v[31];
+    Scalars(s, v);
+    Put(Buffer, s.M, sizeof(s.M));
+    for (int i = 0; i < 31; i++)
+      Put(Buffer, v[i], sizeof(double));
+    Put(Buffer, s.Covariance, sizeof(s.Covariance));
+    PutString(Buffer, s.Type);
+    Put(Buffer, &s.ROUNDS, sizeof(s.ROUNDS));
+  }
+
+  //---------------------------------------------------------------------------
+  // Channel amplitudes shared by the solutions of an entry (n = -1 if none).
+  void PutAmplitudes(std::vector<char> &Buffer,
+      const Taquart::ChannelAmplitudes *a) {
+    int n = a ? int(a->Measured.size()) : -1;
+    Put(Buffer, &n, sizeof(n));
+    if (n <= 0)
+      return;
+    Put(Buffer, &a->Station[0], n * sizeof(int));
+    Put(Buffer, &a->Measured[0], n * sizeof(double));
+    for (int q = 0; q < 3; q++)
+      Put(Buffer, &a->Theoretical[q][0], n * sizeof(double));
+    int Influence = a->Leverage[0].size() > 0 ? 1 : 0;
+    Put(Buffer, &Influence, sizeof(Influence));
+    for (int q = 0; q < 3 && Influence; q++) {
+      Put(Buffer, &a->Leverage[q][0], n * sizeof(double));
+      Put(Buffer, &a->Cook[q][0], n * sizeof(double));
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  bool GetSolution(Cursor &c, Taquart::FaultSolution &s) {
+    double *v[31];
+    Scalars(s, v);
+    if (!c.Get(s.M, sizeof(s.M)))
+      return false;
+    for (int i = 0; i < 31; i++)
+      if (!c.Get(v[i], sizeof(double)))
+        return false;
+    if (!c.Get(s.Covariance, sizeof(s.Covariance)) || !c.GetString(s.Type)
+        || !c.Get(&s.ROUNDS, sizeof(s.ROUNDS)))
+      return false;
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  bool GetAmplitudes(Cursor &c, Taquart::FaultSolutions &fs,
+      const std::shared_ptr<const std::vector<Taquart::String> > &Names) {
+    int n;
+    if (!c.Get(&n, sizeof(n)) || n < -1
+        || (n > 0 && size_t(n) > c.Left() / (4 * sizeof(double) + sizeof(int))))
+      return false;
+    std::shared_ptr<Taquart::ChannelAmplitudes> a;
+    if (n >= 0) {
+      a = std::make_shared<Taquart::ChannelAmplitudes>();
+      a->Names = Names;
+      a->Station.resize(n);
+      a->Measured.resize(n);
+      for (int q = 0; q < 3; q++)
+        a->Theoretical[q].resize(n);
+      if (n > 0) {
+        if (!c.Get(&a->Station[0], n * sizeof(int))
+            || !c.Get(&a->Measured[0], n * sizeof(double)))
+          return false;
+        for (int q = 0; q < 3; q++)
+          if (!c.Get(&a->Theoretical[q][0], n * sizeof(double)))
+            return false;
+        int Influence;
+        if (!c.Get(&Influence, sizeof(Influence)) || Influence < 0
+            || Influence > 1)
+          return false;
+        for (int q = 0; q < 3 && Influence; q++) {
+          a->Leverage[q].resize(n);
+          a->Cook[q].resize(n);
+          if (!c.Get(&a->Leverage[q][0], n * sizeof(double))
+              || !c.Get(&a->Cook[q][0], n * sizeof(double)))
+            return false;
+        }
+      }
+      for (int i = 0; i < n; i++)
+        if (a->Station[i] < 0 || a->Station[i] >= int(Names->size()))
+          return false;
+    }
+    Taquart::FaultSolution *s[3] = { &fs.FullSolution, &fs.TraceNullSolution,
+        &fs.DoubleCoupleSolution };
+    for (int q = 0; q < 3; q++) {
+      s[q]->Amplitudes = a;
+      s[q]->Column = q;
+      s[q]->U_n = n > 0 ? n : 0;
+    }
+    return true;
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+//---- SolutionCache class.
+//-----------------------------------------------------------------------------
+Taquart::SolutionCache::SolutionCache(Taquart::String ADirectory) {
+  Directory = ADirectory;
+}
+
+//-----------------------------------------------------------------------------
+Taquart::String Taquart::SolutionCache::Filename(Taquart::String Key) {
+  return Directory + Taquart::String("/") + Key + ".fsc";
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::SolutionCache::Decode(const char *Data, size_t Size,
+    std::vector<FaultSolutions> &FSList) {
+  // Entries are decoded into a temporary list, so that damaged data
+  // leaves FSList untouched.
+  std::vector<FaultSolutions> List;
+  Cursor c(Data, Size);
+  char magic[8];
+  int count = 0;
+  int nnames = 0;
+  std::shared_ptr<std::vector<Taquart::String> > Names = std::make_shared<
+      std::vector<Taquart::String> >();
+  bool ok = c.Get(magic, 8) && memcmp(magic, SOLUTIONCACHE_MAGIC, 8) == 0
+      && c.Get(&count, sizeof(count)) && count >= 0
+      && c.Get(&nnames, sizeof(nnames)) && nnames >= 0
+      && size_t(nnames) <= c.Left() / sizeof(int);
+  if (ok)
+    Names->resize(nnames);
+  for (int i = 0; ok && i < nnames; i++)
+    ok = c.GetString((*Names)[i]);
+  for (int i = 0; ok && i < count; i++) {
+    FaultSolutions fs;
+    ok = c.Get(&fs.Type, sizeof(fs.Type))
+        && c.Get(&fs.Channel, sizeof(fs.Channel))
+        && GetSolution(c, fs.FullSolution)
+        && GetSolution(c, fs.TraceNullSolution)
+        && GetSolution(c, fs.DoubleCoupleSolution)
+        && GetAmplitudes(c, fs, Names);
+    if (ok)
+      List.push_back(std::move(fs));
+  }
+
+  if (ok)
+    FSList.insert(FSList.end(), List.begin(), List.end());
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::SolutionCache::Encode(std::vector<FaultSolutions> &FSList,
+    std::vector<char> &Buffer) {
+  int count = FSList.size();
+  Put(Buffer, SOLUTIONCACHE_MAGIC, 8);
+  Put(Buffer, &count, sizeof(count));
+
+  // Station names are written once; all entries must refer to one table.
+  const std::vector<Taquart::String> *Names = NULL;
+  for (unsigned int i = 0; i < FSList.size(); i++) {
+    const Taquart::ChannelAmplitudes *a =
+        FSList[i].FullSolution.Amplitudes.get();
+    if (a && Names == NULL)
+      Names = a->Names.get();
+    if (a && a->Names.get() != Names)
+      return false;
+  }
+  int nnames = Names ? Names->size() : 0;
+  Put(Buffer, &nnames, sizeof(nnames));
+  for (int i = 0; i < nnames; i++)
+    PutString(Buffer, (*Names)[i]);
+
+  for (unsigned int i = 0; i < FSList.size(); i++) {
+    Put(Buffer, &FSList[i].Type, sizeof(FSList[i].Type));
+    Put(Buffer, &FSList[i].Channel, sizeof(FSList[i].Channel));
+    PutSolution(Buffer, FSList[i].FullSolution);
+    PutSolution(Buffer, FSList[i].TraceNullSolution);
+    PutSolution(Buffer, FSList[i].DoubleCoupleSolution);
+    PutAmplitudes(Buffer, FSList[i].FullSolution.Amplitudes.get());
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::SolutionCache::Load(Taquart::String Key,
+    std::vector<FaultSolutions> &FSList) {
+  int fd = open(Filename(Key).c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 12) {
+    close(fd);
+    return false;
+  }
+  const size_t size = st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  bool ok = Decode((const char *) map, size, FSList);
+  munmap(map, size);
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::SolutionCache::Store(Taquart::String Key,
+    std::vector<FaultSolutions> &FSList) {
+  std::vector<char> Buffer;
+  if (!Encode(FSList, Buffer))
+    return false;
+
+  // Write to a temporary file and rename it, so that readers never see
+  // a partially written entry.
+  char suffix[32];
+  sprintf(suffix, ".%d.tmp", int(getpid()));
+  Taquart::String TempFile = Filename(Key) + Taquart::String(suffix);
+  FILE *f = fopen(TempFile.c_str(), "wb");
+  if (f == NULL)
+    return false;
+  bool ok = fwrite(&Buffer[0], 1, Buffer.size(), f) == Buffer.size();
+  ok = fclose(f) == 0 && ok;
+  if (ok)
+    ok = rename(TempFile.c_str(), Filename(Key).c_str()) == 0;
+  if (!ok)
+    remove(TempFile.c_str());
+  return ok;
+}
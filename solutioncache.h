@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// Source: solutioncache.h
+// Module: focimt
+// Persistent cache of moment tensor inversion results.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SOLUTIONCACHE_H_
+#define SOLUTIONCACHE_H_
+//-----------------------------------------------------------------------------
+#include "faultsolution.h"
+#include "inputdata.h"
+
+namespace Taquart {
+
+  //! 64-bit FNV-1a hash.
+  /*! Used to build content-addressed keys of cache entries.
+   */
+  class FNVHash {
+    public:
+      FNVHash(void);
+      void Add(const void *Data, size_t Size);
+      void Add(double Value);
+      void Add(int Value);
+      void Add(Taquart::String Value);
+      void Add(Taquart::SMTInputData &InputData);
+      unsigned long long Value(void);
+      Taquart::String Hex(void);
+    private:
+      unsigned long long h;
+  };
+
+  //! Persistent cache of inversion results.
+  /*! Each entry holds the complete list of FaultSolutions computed for a
+   *  single event and is stored in a separate binary file named after the
+   *  key (a hash of the input data and all inversion options). Files are
+   *  memory-mapped while reading.
+   */
+  class SolutionCache {
+    public:
+      //! Constructor.
+      /*! \param ADirectory Existing directory where cache files are kept.
+       */
+      SolutionCache(Taquart::String ADirectory);
+
+      //! Load solutions from the cache.
+      /*! \param Key Cache key.
+       *  \param FSList Solutions are appended to this list.
+       *  \return True if the entry was found and is valid.
+       */
+      bool Load(Taquart::String Key, std::vector<FaultSolutions> &FSList);
+
+      //! Store solutions in the cache.
+      /*! \param Key Cache key.
+       *  \param FSList List of solutions to store.
+       *  \return True on success.
+       */
+      bool Store(Taquart::String Key, std::vector<FaultSolutions> &FSList);
+
+      //! Encodes solutions in the format of the cache files.
+      /*! \param FSList List of solutions (sharing one station name table).
+       *  \param Buffer The encoded entry is appended to this buffer.
+       *  \return True on success.
+       */
+      static bool Encode(std::vector<FaultSolutions> &FSList,
+          std::vector<char> &Buffer);
+
+      //! Decodes solutions encoded by Encode().
+      /*! \param Data Encoded entry.
+       *  \param Size Size of Data in bytes.
+       *  \param FSList Solutions are appended to this list.
+       *  \return True if the entry is valid.
+       */
+      static bool Decode(const char *Data, size_t Size,
+          std::vector<FaultSolutions> &FSList);
+
+    private:
+      Taquart::String Directory;
+      Taquart::String Filename(Taquart::String Key);
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* SOLUTIONCACHE_H_ */
@@ -0,0 +1,232 @@
+//-----------------------------------------------------------------------------
+// Source: solutionring.cpp
+// Module: focimt
+// Shared-memory ring of published solutions (option -sr).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "solutionring.h"
+#include "focimtlib.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  const unsigned int RingMagic = 0x52544d46; // "FMTR"
+  const unsigned int RingVersion = 1;
+
+  //! Ring header, followed by the slots.
+  struct RingHeader {
+      unsigned int Magic;
+      unsigned int Version;
+      unsigned int Slots;
+      unsigned int RecordSize;
+      unsigned long long Head; // Number of records published.
+      char Pad[40];
+  };
+
+  //! A single slot. Seq is 2n+1 while record n is written, 2n+2 after.
+  struct RingSlot {
+      unsigned long long Seq;
+      focimt_ring_record Record;
+  };
+
+  inline RingSlot * SlotAt(void * Base, unsigned int Slots,
+      unsigned long long n) {
+    return (RingSlot *) ((char *) Base + sizeof(RingHeader))
+        + (size_t) (n % Slots);
+  }
+
+  inline unsigned long RingSize(unsigned int Slots) {
+    return sizeof(RingHeader) + (unsigned long) Slots * sizeof(RingSlot);
+  }
+}
+
+//-----------------------------------------------------------------------------
+Taquart::SolutionRing::SolutionRing(void) :
+    Base(NULL), Size(0), Fd(-1) {
+}
+
+//-----------------------------------------------------------------------------
+Taquart::SolutionRing::~SolutionRing(void) {
+  if (Base)
+    munmap(Base, Size);
+  if (Fd >= 0)
+    close(Fd);
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::SolutionRing::Open(const char * Name, unsigned int Slots) {
+  if (Base || Slots == 0)
+    return false;
+  int fd = shm_open(Name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return false;
+
+  // Single writer: the lock is held (with the descriptor open) until the
+  // ring is destroyed.
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    return false;
+  }
+  Size = RingSize(Slots);
+  struct stat st;
+  bool Resize = fstat(fd, &st) != 0 || (unsigned long) st.st_size != Size;
+  if (Resize && ftruncate(fd, Size) != 0) {
+    close(fd);
+    return false;
+  }
+  Base = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (Base == MAP_FAILED) {
+    close(fd);
+    Base = NULL;
+    return false;
+  }
+  Fd = fd;
+
+  RingHeader * h = (RingHeader *) Base;
+  if (Resize || h->Magic != RingMagic || h->Version != RingVersion
+      || h->Slots != Slots || h->RecordSize != sizeof(focimt_ring_record)) {
+    // New ring: readers check the magic, so it is written last.
+    __atomic_store_n(&h->Magic, 0, __ATOMIC_RELEASE);
+    memset((char *) Base + sizeof(unsigned int), 0,
+        Size - sizeof(unsigned int));
+    h->Version = RingVersion;
+    h->Slots = Slots;
+    h->RecordSize = sizeof(focimt_ring_record);
+    __atomic_store_n(&h->Magic, RingMagic, __ATOMIC_RELEASE);
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::SolutionRing::Publish(const char * Event,
+    const Taquart::FaultSolutions &fs) {
+  if (!Base)
+    return;
+  RingHeader * h = (RingHeader *) Base;
+  unsigned long long n = h->Head;
+  RingSlot * s = SlotAt(Base, h->Slots, n);
+
+  __atomic_store_n(&s->Seq, 2 * n + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  s->Record.sequence = n;
+  strncpy(s->Record.event, Event, sizeof(s->Record.event) - 1);
+  s->Record.event[sizeof(s->Record.event) - 1] = 0;
+  Taquart::ExportSolutions(fs, s->Record.result);
+  __atomic_store_n(&s->Seq, 2 * n + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(&h->Head, n + 1, __ATOMIC_RELEASE);
+}
+
+//-----------------------------------------------------------------------------
+struct focimt_ring {
+    void * Base;
+    unsigned long Size;
+    unsigned int Slots;
+    unsigned long long Next;
+};
+
+//-----------------------------------------------------------------------------
+focimt_ring * focimt_ring_open(const char * name, int from_oldest) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  void * Base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (unsigned long) st.st_size >= sizeof(RingHeader))
+    Base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (Base == MAP_FAILED)
+    return NULL;
+
+  RingHeader * h = (RingHeader *) Base;
+  if (__atomic_load_n(&h->Magic, __ATOMIC_ACQUIRE) != RingMagic
+      || h->Version != RingVersion
+      || h->RecordSize != sizeof(focimt_ring_record) || h->Slots == 0
+      || RingSize(h->Slots) > (unsigned long) st.st_size) {
+    munmap(Base, st.st_size);
+    return NULL;
+  }
+
+  focimt_ring * r = (focimt_ring *) malloc(sizeof(focimt_ring));
+  if (!r) {
+    munmap(Base, st.st_size);
+    return NULL;
+  }
+  r->Base = Base;
+  r->Size = st.st_size;
+  r->Slots = h->Slots;
+  unsigned long long Head = __atomic_load_n(&h->Head, __ATOMIC_ACQUIRE);
+  r->Next = Head;
+  if (from_oldest)
+    r->Next = Head > r->Slots ? Head - r->Slots : 0;
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+int focimt_ring_read(focimt_ring * ring, focimt_ring_record * record) {
+  if (!ring || !record)
+    return 0;
+  RingHeader * h = (RingHeader *) ring->Base;
+  unsigned long long Head = __atomic_load_n(&h->Head, __ATOMIC_ACQUIRE);
+  if (ring->Next >= Head)
+    return 0;
+  if (Head - ring->Next > ring->Slots) {
+    ring->Next = Head - ring->Slots;
+    return -1;
+  }
+
+  unsigned long long n = ring->Next;
+  RingSlot * s = SlotAt(ring->Base, ring->Slots, n);
+  unsigned long long s1 = __atomic_load_n(&s->Seq, __ATOMIC_ACQUIRE);
+  if (s1 == 2 * n + 2) {
+    memcpy(record, &s->Record, sizeof(focimt_ring_record));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&s->Seq, __ATOMIC_RELAXED) == s1) {
+      ring->Next = n + 1;
+      return 1;
+    }
+  }
+
+  // The slot was reused by the writer while this reader lagged behind.
+  Head = __atomic_load_n(&h->Head, __ATOMIC_ACQUIRE);
+  ring->Next = Head + 1 > ring->Slots ? Head + 1 - ring->Slots : n + 1;
+  if (ring->Next <= n)
+    ring->Next = n + 1;
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+void focimt_ring_close(focimt_ring * ring) {
+  if (!ring)
+    return;
+  munmap(ring->Base, ring->Size);
+  free(ring);
+}
@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// Source: solutionring.h
+// Module: focimt
+// Shared-memory ring of published solutions (option -sr).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SOLUTIONRING_H_
+#define SOLUTIONRING_H_
+/*---------------------------------------------------------------------------*/
+#include "focimtlib_c.h"
+
+/*! Solutions are published into a ring of fixed-size slots in POSIX shared
+ *  memory (shm_open name, e.g. "/focimt"). There is a single writer (focimt)
+ *  and any number of readers, none of which take locks: every slot carries
+ *  a sequence number that is odd while the slot is written, and a reader
+ *  that finds the sequence changed under it knows the record was
+ *  overwritten. A reader that falls more than a ring behind loses the
+ *  oldest records and is told so. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! A published record: solutions of a single inversion of an event. */
+typedef struct focimt_ring_record {
+  unsigned long long sequence; /*!< Record number since the ring creation. */
+  char event[64]; /*!< Event id (fileid), truncated. */
+  focimt_result result; /*!< Type, channel and the three solutions. */
+} focimt_ring_record;
+
+/*! Reader handle. */
+typedef struct focimt_ring focimt_ring;
+
+/*! Opens the ring name for reading. With from_oldest set the reader starts
+ *  at the oldest record still in the ring, otherwise at the next published
+ *  one. Returns NULL if the ring does not exist. */
+focimt_ring * focimt_ring_open(const char * name, int from_oldest);
+
+/*! Reads the next record without blocking. Returns 1 if a record was
+ *  copied to record, 0 if there is no new record and -1 if records were
+ *  overwritten before they could be read (the reader skips to the oldest
+ *  record still available; call again). */
+int focimt_ring_read(focimt_ring * ring, focimt_ring_record * record);
+
+/*! Closes the reader. */
+void focimt_ring_close(focimt_ring * ring);
+
+#ifdef __cplusplus
+}
+
+namespace Taquart {
+  class FaultSolutions;
+
+  //! Writer of the shared-memory solution ring.
+  /*! A single publisher per ring. A ring of the same name and size left
+   *  by a previous run is continued, so sequence numbers stay monotonic
+   *  for running readers.
+   */
+  class SolutionRing {
+    public:
+      //! Constructor.
+      SolutionRing(void);
+
+      //! Destructor, unmaps the ring and releases the writer lock (the
+      //! shared memory object is kept).
+      ~SolutionRing(void);
+
+      //! Creates or attaches the ring.
+      /*! Takes an exclusive lock (flock) on the shared memory object, so
+       *  the ring fails to open while another writer holds it.
+       *  \param Name Shared memory object name.
+       *  \param Slots Number of records kept in the ring.
+       *  \return \p true on success.
+       */
+      bool Open(const char * Name, unsigned int Slots);
+
+      //! Publishes solutions of a single inversion.
+      /*! \param Event Event id.
+       *  \param fs Solutions.
+       */
+      void Publish(const char * Event, const Taquart::FaultSolutions &fs);
+
+    private:
+      void * Base;
+      unsigned long Size;
+      int Fd; // Shared memory object, locked by the writer.
+      SolutionRing(const SolutionRing &);
+      SolutionRing & operator=(const SolutionRing &);
+  };
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+#endif /* SOLUTIONRING_H_ */
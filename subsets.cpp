@@ -0,0 +1,418 @@
+//-----------------------------------------------------------------------------
+// Source: subsets.cpp
+// Module: focimt
+// Leave-k-out and azimuth sector station robustness tests (L2).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "subsets.h"
+#include "usmtcore.h"
+#include "symsolve.h"
+#include "resamplingstats.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  //! Rebuild the normal equations after this many moves.
+  const int RESYNC = 1024;
+
+  //! Trend and plunge [deg] of an axis (x north, y east, z down).
+  Taquart::AXIS Axis(const double v[3]) {
+    double s = v[2] < 0.0 ? -1.0 : 1.0;
+    Taquart::AXIS a;
+    a.str = Taquart::zero_360(atan2(s * v[1], s * v[0]) * 180.0 / M_PI);
+    a.dip = asin(std::min(1.0, fabs(v[2]))) * 180.0 / M_PI;
+    return a;
+  }
+
+  //! Visits the k-subsets of 0..n-1 in revolving-door order (or in reverse),
+  //! each extended by the elements in Set.
+  template<class F>
+  void Door(int n, int k, bool Reverse, std::vector<int> &Set, F &Visit) {
+    if (k == 0) {
+      Visit(Set);
+      return;
+    }
+    if (k == n) {
+      for (int i = 0; i < n; i++)
+        Set.push_back(i);
+      Visit(Set);
+      Set.resize(Set.size() - n);
+      return;
+    }
+    if (!Reverse) {
+      Door(n - 1, k, false, Set, Visit);
+      Set.push_back(n - 1);
+      Door(n - 1, k - 1, true, Set, Visit);
+      Set.pop_back();
+    }
+    else {
+      Set.push_back(n - 1);
+      Door(n - 1, k - 1, false, Set, Visit);
+      Set.pop_back();
+      Door(n - 1, k, true, Set, Visit);
+    }
+  }
+
+  //! Number of k-subsets of n elements.
+  double Binomial(int n, int k) {
+    double c = 1.0;
+    for (int i = 1; i <= k; i++)
+      c = c * (n - k + i) / i;
+    return c;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//---- Walker: normal equations of the current subset.
+//-----------------------------------------------------------------------------
+class Taquart::StationSubsets::Walker {
+  public:
+    Walker(const Taquart::StationSubsets &AOwner) :
+        Owner(AOwner), Moves(0) {
+      Reset(std::vector<int>());
+    }
+
+    //! Normal equations with the sorted Removed stations left out.
+    void Reset(const std::vector<int> &Removed) {
+      for (int i = 0; i <= 6; i++) {
+        B6[i] = 0.0;
+        for (int j = 0; j <= 6; j++)
+          N6[i][j] = 0.0;
+      }
+      for (int i = 0; i <= 5; i++) {
+        B5[i] = 0.0;
+        for (int j = 0; j <= 5; j++)
+          N5[i][j] = 0.0;
+      }
+      Current.clear();
+      for (int s = 0; s < Owner.N; s++)
+        Update(s, 1.0);
+      for (size_t i = 0; i < Removed.size(); i++)
+        Update(Removed[i], -1.0);
+      Current = Removed;
+      Moves = 0;
+    }
+
+    //! Moves to the sorted Removed stations.
+    void Move(const std::vector<int> &Removed) {
+      if (++Moves >= RESYNC) {
+        Reset(Removed);
+        return;
+      }
+      size_t i = 0, j = 0;
+      while (i < Current.size() || j < Removed.size()) {
+        if (j == Removed.size()
+            || (i < Current.size() && Current[i] < Removed[j]))
+          Update(Current[i++], 1.0); // Back in.
+        else if (i == Current.size() || Removed[j] < Current[i])
+          Update(Removed[j++], -1.0); // Left out.
+        else {
+          i++;
+          j++;
+        }
+      }
+      Current = Removed;
+    }
+
+    //! Solves the normal equations of the current subset.
+    void Solve(Taquart::StationSubsets::Summary &s) const {
+      using namespace Taquart::UsmtCore;
+      s.Valid = false;
+      if (Owner.N - int(Current.size()) < FOCIMT_MIN_ALLOWED_CHANNELS)
+        return;
+
+      // Full solution.
+      SymmetricSolver<6> S6;
+      SymmetricSolver<5> S5;
+      if (!S6.Factor(N6) || !S5.Factor(N5))
+        return;
+      double x[6 + 1], E[3 + 1], MT, Dum;
+      S6.Solve(B6, x);
+      EIG3(x, 0, E);
+      SCALARMOMENT(E, s.M0Full, MT);
+      EIGGEN(E[1], E[2], E[3], s.EXPL, s.CLVD, s.DBCP, Dum, Dum, Dum);
+
+      // Trace-null solution and its principal axes.
+      S5.Solve(B5, x);
+      x[6] = -x[1] - x[4];
+      EIG3(x, 0, E);
+      SCALARMOMENT(E, s.M0, MT);
+      double M[3][3] = { { x[1], x[2], x[3] }, { x[2], x[4], x[5] }, { x[3],
+          x[5], x[6] } };
+      double V[3][3], L[3];
+      SymmetricEigen3(M, L, V);
+      int t = 0, p = 0;
+      for (int i = 1; i < 3; i++) {
+        if (L[i] > L[t])
+          t = i;
+        if (L[i] < L[p])
+          p = i;
+      }
+      for (int i = 0; i < 3; i++) {
+        s.T[i] = V[i][t];
+        s.P[i] = V[i][p];
+      }
+      Taquart::nodal_plane NP1, NP2;
+      Taquart::axe2dc(Axis(s.T), Axis(s.P), &NP1, &NP2);
+      s.Strike = NP1.str;
+      s.Dip = NP1.dip;
+      s.Rake = NP1.rake;
+      s.Rotation =
+          Owner.Reference.Valid ?
+              Taquart::RotationAngle(Owner.Reference.T, Owner.Reference.P,
+                  s.T, s.P) :
+              0.0;
+      s.Valid = true;
+    }
+
+  private:
+    const Taquart::StationSubsets &Owner;
+    double N6[6 + 1][6 + 1], B6[6 + 1];
+    double N5[5 + 1][5 + 1], B5[5 + 1];
+    std::vector<int> Current;
+    int Moves;
+
+    //! Adds (Sign 1) or removes (Sign -1) the row of a station.
+    void Update(int Station, double Sign) {
+      const double * a = &Owner.Rows[6 * Station] - 1;
+      const double h[5 + 1] = { 0.0, a[1] - a[6], a[2], a[3], a[4] - a[6],
+          a[5] };
+      const double u = Sign * Owner.Data[Station];
+      for (int i = 1; i <= 6; i++) {
+        B6[i] += a[i] * u;
+        for (int j = 1; j <= 6; j++)
+          N6[i][j] += Sign * a[i] * a[j];
+      }
+      for (int i = 1; i <= 5; i++) {
+        B5[i] += h[i] * u;
+        for (int j = 1; j <= 5; j++)
+          N5[i][j] += Sign * h[i] * h[j];
+      }
+    }
+};
+
+//-----------------------------------------------------------------------------
+//---- Worst: largest deviations from the reference.
+//-----------------------------------------------------------------------------
+class Taquart::StationSubsets::Worst {
+  public:
+    double Value[3];
+    std::vector<int> Subset[3];
+
+    Worst(void) {
+      Value[0] = Value[1] = Value[2] = -1.0;
+    }
+
+    void Add(const Taquart::StationSubsets::Summary &Ref,
+        const Taquart::StationSubsets::Summary &s,
+        const std::vector<int> &Removed) {
+      if (!s.Valid)
+        return;
+      const double v[3] = { s.Rotation,
+          Ref.M0 > 0.0 ? 100.0 * fabs(s.M0 / Ref.M0 - 1.0) : 0.0, fabs(
+              s.DBCP - Ref.DBCP) };
+      for (int i = 0; i < 3; i++)
+        if (v[i] > Value[i]) {
+          Value[i] = v[i];
+          Subset[i] = Removed;
+        }
+    }
+
+    void Merge(const Worst &w) {
+      for (int i = 0; i < 3; i++)
+        if (w.Value[i] > Value[i]) {
+          Value[i] = w.Value[i];
+          Subset[i] = w.Subset[i];
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+//---- StationSubsets class.
+//-----------------------------------------------------------------------------
+Taquart::StationSubsets::StationSubsets(Taquart::SMTInputData &InputData) {
+  using namespace Taquart::UsmtCore;
+  RDINP(InputData);
+  N = ANGGA() ? Taquart::UsmtCore::N : 0;
+  if (N > 0)
+    KERNEL();
+  Rows.resize(6 * N);
+  Data.resize(N);
+  Azimuth.resize(N);
+  Names.resize(N);
+  for (int i = 1; i <= N; i++) {
+    for (int j = 1; j <= 6; j++)
+      Rows[6 * (i - 1) + j - 1] = A[i][j];
+    Data[i - 1] = U[i] * USMT_UPSCALE;
+    Azimuth[i - 1] = AZM[i];
+    Taquart::SMTInputLine Line;
+    InputData.Get(i - 1, Line);
+    Names[i - 1] = Line.Name.c_str();
+  }
+  Reference.Valid = false;
+  Walker w(*this);
+  w.Solve(Reference);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::StationSubsets::Write(std::ostream &Out,
+    const std::vector<int> &Removed, const Summary &s) const {
+  for (size_t i = 0; i < Removed.size(); i++)
+    Out << (i ? "," : "") << Names[Removed[i]];
+  if (!s.Valid) {
+    Out << FOCIMT_SEP << "SKIP" << std::endl;
+    return;
+  }
+  char txt[256];
+  sprintf(txt, "%s%.2f%s%g%s%.2f%s%.2f%s%.2f%s%g%s%.1f%s%.1f%s%.1f",
+      FOCIMT_SEP, s.Rotation, FOCIMT_SEP, s.M0Full, FOCIMT_SEP, s.EXPL,
+      FOCIMT_SEP, s.CLVD, FOCIMT_SEP, s.DBCP, FOCIMT_SEP, s.M0, FOCIMT_SEP,
+      s.Strike, FOCIMT_SEP, s.Dip, FOCIMT_SEP, s.Rake);
+  Out << txt << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::StationSubsets::Write(std::ostream &Out, const Worst &w) const {
+  const char * Labels[3] = { "ROTATION", "M0", "DBCP" };
+  for (int i = 0; i < 3; i++) {
+    Out << "WORST" << FOCIMT_SEP << Labels[i] << FOCIMT_SEP << w.Value[i]
+        << FOCIMT_SEP;
+    for (size_t j = 0; j < w.Subset[i].size(); j++)
+      Out << (j ? "," : "") << Names[w.Subset[i][j]];
+    Out << std::endl;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::StationSubsets::LeaveOut(std::ostream &Out,
+    Taquart::String EventId, int K, int Threads) {
+  if (K < 1 || K > N)
+    return;
+  Out << EventId.c_str() << FOCIMT_SEP << "K" << K << FOCIMT_SEP
+      << (unsigned long long) (Binomial(N, K) + 0.5) << std::endl;
+
+  // Block m holds the subsets whose last station is m; blocks are taken in
+  // ascending order and written as soon as all previous ones are done.
+  const int Blocks = N - K + 1;
+  std::vector<std::string> Text(Blocks);
+  std::vector<bool> Ready(Blocks, false);
+  std::atomic<int> Next(0);
+  std::mutex Lock;
+  int Flushed = 0;
+  Worst Total;
+
+  auto Work = [&]() {
+    Walker w(*this);
+    Worst Local;
+    Summary s;
+    for (int b = Next++; b < Blocks; b = Next++) {
+      const int m = K - 1 + b;
+      std::ostringstream Block;
+      bool First = true;
+      std::vector<int> Sorted;
+      auto Visit = [&](const std::vector<int> &Set) {
+        Sorted = Set;
+        std::sort(Sorted.begin(), Sorted.end());
+        if (First)
+          w.Reset(Sorted);
+        else
+          w.Move(Sorted);
+        First = false;
+        w.Solve(s);
+        Write(Block, Sorted, s);
+        Local.Add(Reference, s, Sorted);
+      };
+      std::vector<int> Set(1, m);
+      Door(m, K - 1, true, Set, Visit);
+
+      std::lock_guard<std::mutex> Guard(Lock);
+      Text[b] = Block.str();
+      Ready[b] = true;
+      while (Flushed < Blocks && Ready[Flushed]) {
+        Out << Text[Flushed];
+        std::string().swap(Text[Flushed]);
+        Flushed++;
+      }
+    }
+    std::lock_guard<std::mutex> Guard(Lock);
+    Total.Merge(Local);
+  };
+
+  if (Threads <= 0)
+    Threads = std::thread::hardware_concurrency();
+  std::vector<std::thread> Pool;
+  for (int t = 1; t < std::max(1, Threads); t++)
+    Pool.push_back(std::thread(Work));
+  Work();
+  for (size_t t = 0; t < Pool.size(); t++)
+    Pool[t].join();
+  Write(Out, Total);
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::StationSubsets::Sectors(std::ostream &Out,
+    Taquart::String EventId, double Width) {
+  if (N == 0 || Width <= 0.0)
+    return;
+  Out << EventId.c_str() << FOCIMT_SEP << "S" << Width << FOCIMT_SEP << N
+      << std::endl;
+
+  // Sectors in the order of their starting azimuth, so that neighbours
+  // differ by the few stations entering or leaving the window.
+  std::vector<int> Order(N);
+  for (int i = 0; i < N; i++)
+    Order[i] = i;
+  std::sort(Order.begin(), Order.end(), [this](int a, int b) {
+    return Azimuth[a] < Azimuth[b];
+  });
+
+  Walker w(*this);
+  Worst Total;
+  Summary s;
+  std::vector<int> Removed;
+  for (int i = 0; i < N; i++) {
+    const double a = Azimuth[Order[i]];
+    Removed.clear();
+    for (int j = 0; j < N; j++) {
+      double d = fmod(Azimuth[j] - a + 720.0, 360.0);
+      if (d < Width)
+        Removed.push_back(j);
+    }
+    w.Move(Removed);
+    w.Solve(s);
+    char txt[32];
+    sprintf(txt, "%.1f%s", a, FOCIMT_SEP);
+    Out << txt;
+    Write(Out, Removed, s);
+    Total.Add(Reference, s, Removed);
+  }
+  Write(Out, Total);
+}
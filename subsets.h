@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+// Source: subsets.h
+// Module: focimt
+// Leave-k-out and azimuth sector station robustness tests (L2).
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SUBSETS_H_
+#define SUBSETS_H_
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include <vector>
+#include "inputdata.h"
+
+namespace Taquart {
+
+  //! L2 solutions of an event with subsets of its stations removed.
+  /*! The kernel rows of all stations are computed once by UsmtCore; the
+   *  subsets are then solved from the normal equations only, which are
+   *  updated by the rows of the stations entering or leaving the removed
+   *  set between consecutive subsets (and rebuilt every 1024 subsets to
+   *  bound rounding). Solving does not touch the UsmtCore state, so the
+   *  leave-k-out enumeration runs on several threads.
+   *
+   *  Output (tab-separated): a header 'fileid type count', a line per
+   *  subset with the removed stations (comma-separated), the rotation
+   *  angle of the DC of the trace-null solution to the reference [deg],
+   *  M0, EXPL, CLVD and DBCP of the full solution, M0 of the trace-null
+   *  solution and strike, dip and rake of its DC (or SKIP if less than
+   *  FOCIMT_MIN_ALLOWED_CHANNELS stations remain or the equations are
+   *  singular), and WORST lines with the largest rotation, relative change
+   *  of the trace-null M0 [%] and change of DBCP [%] with their subsets.
+   */
+  class StationSubsets {
+    public:
+      //! Summary of the solutions of one subset.
+      class Summary {
+        public:
+          bool Valid;
+          double M0Full; /*!< Scalar moment, full solution. */
+          double EXPL, CLVD, DBCP; /*!< Decomposition, full solution. */
+          double M0; /*!< Scalar moment, trace-null solution. */
+          double T[3], P[3]; /*!< Axes of the trace-null solution. */
+          double Strike, Dip, Rake; /*!< First nodal plane of its DC. */
+          double Rotation; /*!< DC rotation to the reference [deg]. */
+      };
+
+      //! Constructor.
+      /*! Uses the UsmtCore state (not reentrant).
+       *  \param InputData Station data of the event.
+       */
+      StationSubsets(Taquart::SMTInputData &InputData);
+
+      //! Writes every subset with K stations removed.
+      /*! Subsets are visited in revolving-door order, split by their last
+       *  station between Threads threads (0 - one per processor); the
+       *  output keeps this order.
+       */
+      void LeaveOut(std::ostream &Out, Taquart::String EventId, int K,
+          int Threads);
+
+      //! Writes every azimuth sector of Width degrees removed.
+      /*! Each sector starts at a station azimuth, [a, a + Width), and its
+       *  line starts with a.
+       */
+      void Sectors(std::ostream &Out, Taquart::String EventId, double Width);
+
+      //! Number of stations.
+      int Count(void) const {
+        return N;
+      }
+
+    private:
+      class Walker;
+      class Worst;
+      friend class Walker;
+
+      int N;
+      std::vector<double> Rows; //!< Kernel rows, 6 per station.
+      std::vector<double> Data; //!< Upscaled amplitudes.
+      std::vector<double> Azimuth;
+      std::vector<std::string> Names;
+      Summary Reference;
+
+      void Write(std::ostream &Out, const std::vector<int> &Removed,
+          const Summary &s) const;
+      void Write(std::ostream &Out, const Worst &w) const;
+  };
+}
+
+//-----------------------------------------------------------------------------
+#endif /* SUBSETS_H_ */
@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Source: symsolve.h
+// Module: focimt
+// Fixed-size LDL^T solver for small symmetric systems.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef SYMSOLVE_H_
+#define SYMSOLVE_H_
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <algorithm>
+
+namespace Taquart {
+  namespace UsmtCore {
+
+    //! LDL^T factorization and solution of a symmetric DIM x DIM system.
+    /*! Replaces INVMAT for the normal equations of MOM2 (DIM 5 and 6) and
+     *  the constrained system of BETTER (DIM 8). The latter is indefinite,
+     *  but the zero diagonal of its two constraint rows comes last, so no
+     *  pivoting is needed: the first six pivots are positive and the last
+     *  two negative. Arrays are indexed from 1, as in the rest of USMT.
+     *  The size is known at compile time, so the loops are unrolled.
+     */
+    template<int DIM>
+    class SymmetricSolver {
+      public:
+        //! Factors the lower triangle of A (rows and columns 1..DIM).
+        /*! \return False if a pivot vanishes (relative to the diagonal);
+         *  the caller falls back to INVMAT.
+         */
+        template<int LD>
+        bool Factor(const double A[][LD]) {
+          double scale = 0.0;
+          for (int i = 1; i <= DIM; i++)
+            scale = std::max(scale, fabs(A[i][i]));
+          if (scale == 0.0)
+            return false;
+          for (int j = 1; j <= DIM; j++) {
+            double d = A[j][j];
+            for (int k = 1; k < j; k++)
+              d -= L[j][k] * L[j][k] * D[k];
+            if (fabs(d) <= 1.0e-14 * scale)
+              return false;
+            D[j] = d;
+            L[j][j] = 1.0;
+            for (int i = j + 1; i <= DIM; i++) {
+              double s = A[i][j];
+              for (int k = 1; k < j; k++)
+                s -= L[i][k] * L[j][k] * D[k];
+              L[i][j] = s / d;
+            }
+          }
+          return true;
+        }
+
+        //! Solves A x = b with the factors. b and x may be the same array.
+        void Solve(const double b[], double x[]) const {
+          double y[DIM + 1];
+          for (int i = 1; i <= DIM; i++) {
+            double s = b[i];
+            for (int k = 1; k < i; k++)
+              s -= L[i][k] * y[k];
+            y[i] = s;
+          }
+          for (int i = 1; i <= DIM; i++)
+            y[i] /= D[i];
+          for (int i = DIM; i >= 1; i--) {
+            double s = y[i];
+            for (int k = i + 1; k <= DIM; k++)
+              s -= L[k][i] * y[k];
+            y[i] = s;
+          }
+          for (int i = 1; i <= DIM; i++)
+            x[i] = y[i];
+        }
+
+      private:
+        double L[DIM + 1][DIM + 1];
+        double D[DIM + 1];
+    };
+
+    //! Eigenvalues E and eigenvectors (columns of V) of a symmetric 3x3
+    //! matrix M (cyclic Jacobi, M is destroyed). Indexed from 0.
+    inline void SymmetricEigen3(double M[3][3], double E[3], double V[3][3]) {
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+          V[i][j] = i == j ? 1.0 : 0.0;
+      for (int Sweep = 0; Sweep < 50; Sweep++) {
+        double Off = fabs(M[0][1]) + fabs(M[0][2]) + fabs(M[1][2]);
+        double Diag = fabs(M[0][0]) + fabs(M[1][1]) + fabs(M[2][2]);
+        if (Off <= 1.0e-15 * Diag || Off == 0.0)
+          break;
+        for (int p = 0; p < 2; p++)
+          for (int q = p + 1; q < 3; q++) {
+            if (M[p][q] == 0.0)
+              continue;
+            double Theta = (M[q][q] - M[p][p]) / (2.0 * M[p][q]);
+            double t = (Theta >= 0.0 ? 1.0 : -1.0)
+                / (fabs(Theta) + sqrt(Theta * Theta + 1.0));
+            double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+            for (int k = 0; k < 3; k++) {
+              double mkp = M[k][p], mkq = M[k][q];
+              M[k][p] = c * mkp - s * mkq;
+              M[k][q] = s * mkp + c * mkq;
+            }
+            for (int k = 0; k < 3; k++) {
+              double mpk = M[p][k], mqk = M[q][k];
+              M[p][k] = c * mpk - s * mqk;
+              M[q][k] = s * mpk + c * mqk;
+            }
+            for (int k = 0; k < 3; k++) {
+              double vkp = V[k][p], vkq = V[k][q];
+              V[k][p] = c * vkp - s * vkq;
+              V[k][q] = s * vkp + c * vkq;
+            }
+          }
+      }
+      for (int i = 0; i < 3; i++)
+        E[i] = M[i][i];
+    }
+
+  }
+}
+
+//-----------------------------------------------------------------------------
+#endif /* SYMSOLVE_H_ */
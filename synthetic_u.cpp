@@ -880,18 +880,18 @@ int main(int argc, char* argv[]) {
                             if (DumpOrder[i] == 'U' && ExportU) {
                                 OutFile2 << FOCIMT_SEP << Solution.U_n << std::endl;
                                 for (int r = 0; r < Solution.U_n; r++) {
-                                    OutFile2 << Solution.Station[r].c_str() << FOCIMT_SEP
-                                    << Solution.U_measured[r] << FOCIMT_SEP
-                                    << Solution.U_th[r] << std::endl;
+                                    OutFile2 << Solution.Station(r).c_str() << FOCIMT_SEP
+                                    << Solution.U_measured(r) << FOCIMT_SEP
+                                    << Solution.U_th(r) << std::endl;
                                 }
                             }
                             else if (DumpOrder[i] == 'u' && ExportU) {
                                 OutFile2 << FOCIMT_SEP2 << Solution.U_n << std::endl;
                                 for (int r = 0; r < Solution.U_n; r++) {
                                     sprintf(txtb, "%5s%s%13.5e%s%13.5e",
-                                            Solution.Station[r].c_str(),
-                                            FOCIMT_SEP2, Solution.U_measured[r], FOCIMT_SEP2,
-                                            Solution.U_th[r]);
+                                            Solution.Station(r).c_str(),
+                                            FOCIMT_SEP2, Solution.U_measured(r), FOCIMT_SEP2,
+                                            Solution.U_th(r));
                                     OutFile2 << txtb << std::endl;
                                 }
                             }
@@ -0,0 +1,277 @@
+/*
+ * tricairo.h
+ *
+ *  Drawing part of trinity_library (needs Cairo). Kept out of
+ *  trinity_library.h so that the inversion core and libfocimt do not
+ *  depend on the Cairo headers.
+ */
+
+#ifndef TRICAIRO_H_
+#define TRICAIRO_H_
+
+#include <cairo/cairo.h>
+//#include <cairo/cairo-win32.h>
+#include <cairo/cairo-svg.h>
+#include <cairo/cairo-pdf.h>
+#include <cairo/cairo-ps.h>
+#include "trinity_library.h"
+
+//! \defgroup tricairo Interface to CAIRO library.
+
+namespace Taquart {
+
+  //! Type of line joint
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_LineJoin {
+    ljMiter, ljBevel, ljRound
+  };
+
+  //! Type of line cap.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_LineCap {
+    lcButt, lcRound, lcSquare
+  };
+
+  //! Type of output canvas.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_CanvasType {
+    ctBitmap, ctSurface, ctSVG, ctPDF, ctPS
+  };
+
+  //! Font style.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_FontStyle {
+    fsNormal, fsItalic, fsOblique, fsNormalBold, fsItalicBold, fsObliqueBold
+  };
+
+  //! Horizontal alignment of text.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_HorizontalAlignment {
+    haLeft, haCenter, haRight
+  };
+
+  //! Vertical alignment of text.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_VerticalAlignment {
+    vaTop, vaMiddle, vaBottom
+  };
+
+  //! Base class wrapping the interface between BDS2006 and Cairo library.
+  /*! \ingroup tricairo
+   */
+  class TriCairo {
+    public:
+      TriCairo(unsigned int width, unsigned int height,
+          Taquart::TriCairo_CanvasType canvastype,
+          Taquart::String Filename = "");
+      virtual ~TriCairo(void);
+      virtual void Save(Taquart::String filename);
+      //Graphics::TBitmap * GetBitmap(void);
+      //Graphics::TBitmap * CreateBitmap(void);
+      //void DrawCanvas(TCanvas * Canvas, int Left = 0, int Top = 0);
+
+      // Drawing functions.
+      void Color(Taquart::TriCairo_Color Color);
+      void ColorD(double r, double g, double b, double a = 1.0);
+      void ColorB(unsigned int r, unsigned int g, unsigned int b,
+          unsigned int a = 255);
+      void Clear(double r, double g, double b, double a = 1.0);
+      void Clear(Taquart::TriCairo_Color Color);
+      void MoveTo(double x, double y);
+      void LineTo(double x, double y);
+      void LineToRel(double x, double y);
+      void LineWidth(double w);
+      void LineCap(TriCairo_LineCap lc);
+      void LineJoin(TriCairo_LineJoin lj);
+      void Font(Taquart::String Name, double Size, TriCairo_FontStyle fs);
+      void Text(double x, double y, Taquart::String Text,
+          TriCairo_HorizontalAlignment ha = haLeft,
+          TriCairo_VerticalAlignment va = vaTop);
+      void Stroke(void);
+      void StrokePreserve(void);
+      void Fill(void);
+      void FillPreserve(void);
+      void Arc(double x, double y, double r, double start = 0.0,
+          double end = 2 * M_PI);
+      void Rectangle(double x, double y, double w, double h);
+      void Circle(double x, double y, double r);
+      void ClosePath(void);
+
+      Taquart::String Filename;
+    private:
+      //Graphics::TBitmap * Bitmap;
+
+    protected:
+      cairo_surface_t * CreateSurface(TriCairo_CanvasType CanvasType);
+
+      // Additional functions.
+      TriCairo_CanvasType CanvasType;
+      const unsigned int Width;
+      const unsigned int Height;
+      cairo_surface_t * surface;
+      cairo_t * cr;
+  };
+
+}
+
+//=============================================================================
+//=============================================================================
+//=============================================================================
+
+namespace Taquart {
+  typedef int GMT_LONG;
+
+  //! Hemisphere projection.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_Hemisphere {
+    heLower = 0, heUpper = 1
+  };
+
+  //! Type of station marker.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_MarkerType {
+    mtCircle = 0, mtSquare = 1, mtPlusMinus = 2, mtBWCircle = 3
+  };
+
+  //! Type of network projection.
+  /*! \ingroup tricairo
+   */
+  enum TriCairo_Projection {
+    prWulff = 0, prSchmidt = 1
+  };
+
+  //! Structure stores information about plunge and trend of axis.
+  /*! \ingroup tricairo
+   */
+
+  //! Structure stores information about strike, dip and rake of a fault.
+  /*! \ingroup tricairo
+   */
+
+  /*
+   typedef struct DLL_EXP TriCairo_NodalPlane
+   {
+   double str;
+   double dip;
+   double rake;
+   } nodal_plane;
+   */
+  //! Structure stores information moment tensor.
+  /*! The corresponding matrix elements correspond to the moment tensor
+   *  components according to CMT convention.
+   *  \ingroup tricairo
+   */
+  typedef struct TriCairo_MomentTensor {
+      double f[6]; /* mrr mtt mff mrt mrf mtf in 10**expo dynes-cm */
+      TriCairo_MomentTensor(void) {
+        for (int i = 0; i < 6; i++)
+          f[i] = 0;
+      }
+  } M_TENSOR;
+
+  //! Class for producing the graphical representation of moment tensor component.
+  /*! This class is capable to produce a graphical representation of the seismic
+   *   moment tensor (so called beach balls).
+   *  \ingroup tricairo
+   */
+  class TriCairo_Meca: public TriCairo {
+    public:
+      // Constructor.
+      TriCairo_Meca(unsigned int width, unsigned int height,
+          TriCairo_CanvasType type, Taquart::String filename = "");
+      // Destructor.
+      virtual ~TriCairo_Meca(void);
+      //void Draw(double M11, double M12, double M13, double M22, double M23, double M33,
+      //  double s1, double d1, double r1, double s2, double d2, double r2);
+
+      // Public variables.
+      bool DrawCross;
+      bool DrawDC;
+
+      TriCairo_Hemisphere Hemisphere;
+      unsigned int Margin; // Margin size.
+      unsigned int BWidth;
+      unsigned int BHeight;
+      unsigned int BRadius;
+      unsigned int BXo;
+      unsigned int BYo;
+      double BOutlineWidth;
+      TCColor BOutlineColor;
+      TCColor BPlusColor; // For compressional part.
+      TCColor BMinusColor; // For dilatational part.
+      TCColor BTensorOutline;
+      TCColor BDCColor;
+      double BDCWidth;
+      double BTolerance; // Max. outline error (device units), 0 - automatic.
+
+      bool DrawAxis;
+      double AxisFontSize;
+      Taquart::String AxisFontFace;
+
+      bool DrawStations;
+      bool DrawStationName;
+      double StationMarkerSize;
+      double StationFontSize;
+      TCColor StationPlusColor;
+      TCColor StationMinusColor;
+      TriCairo_MarkerType StationMarkerType;
+      Taquart::String StationFontFace;
+      TCColor StationTextColor;
+
+      TriCairo_Projection Projection;
+
+      // Main drawing routines.
+      void Station(double Azimuth, double Takeoff, double Disp,
+          Taquart::String Label, double &mx, double &my, double error = 0.0);
+      void Tensor(AXIS T, AXIS N, AXIS P);
+      void Axis(AXIS A, Taquart::String Text);
+      void DoubleCouple(double Strike, double Dip);
+      void DrawStationMarker(double x, double y, double disp,
+          Taquart::String Label);
+      void CenterCross(void);
+      void GMT_momten2axe(M_TENSOR mt, AXIS *T, AXIS *N, AXIS *P);
+      void Station(double GA[], double Disp, Taquart::String Label, double &mx,
+          double &my, double error = 0.0);
+
+    protected:
+
+      // Upper or lower hemisphere projection routines.
+      void Project(double &X, double &Y);
+      void Project(double * X, double * Y, unsigned int npoints);
+
+    private:
+      // Additional routines.
+      double squared(double v);
+      void axe2dc(AXIS T, AXIS P, nodal_plane *NP1, nodal_plane *NP2);
+      double proj_radius2(double str1, double dip1, double str);
+      void ps_circle(double x0, double y0, double radius_size, TCColor fc);
+      void Polygon(double xp1[], double yp1[], int npoints, TCColor oc,
+          bool fill, TCColor fc = TCColor(), double OutlineWidth = 1.0);
+
+      // Tessellation of the tensor outline.
+      unsigned int TessellationSteps(void);
+      void TessellationTables(unsigned int nsteps);
+      void RimArc(std::vector<double> &x, std::vector<double> &y, double from,
+          double to, double step);
+      std::vector<double> SinTable;
+      std::vector<double> CosTable;
+
+      GMT_LONG GMT_jacobi(double *a, GMT_LONG *n, GMT_LONG *m, double *d,
+          double *v, double *b, double *z, GMT_LONG *nrots);
+
+      void * GMT_memory(void *prev_addr, GMT_LONG nelem, size_t size);
+      void GMT_free(void *addr);
+
+  };
+// class TriCairo_Meca
+}
+
+#endif /* TRICAIRO_H_ */
@@ -7,6 +7,9 @@
 
 #include <stdlib.h>
 #include "trinity_library.h"
+#ifndef FOCIMT_NO_CAIRO
+#include "tricairo.h"
+#endif
 using namespace Taquart;
 
 //=============================================================================
@@ -313,8 +316,7 @@ double Taquart::datan2(double y, double x) {
 //=============================================================================
 //=============================================================================
 
-double Taquart::mean(double * X, unsigned int Size)
-    throw (Taquart::TriENullPointer, Taquart::TriEOutOfRange) {
+double Taquart::mean(double * X, unsigned int Size) {
   if (X == 0L)
     throw Taquart::TriENullPointer("Trinity:mean(): Input pointer is NULL.");
   else if (Size == 0)
@@ -329,8 +331,7 @@ double Taquart::mean(double * X, unsigned int Size)
 }
 
 //---------------------------------------------------------------------------
-double Taquart::std(double * X, unsigned int Size)
-    throw (Taquart::TriENullPointer, Taquart::TriEOutOfRange) {
+double Taquart::std(double * X, unsigned int Size) {
   if (X == 0L)
     throw Taquart::TriENullPointer("Trinity:std(): Input pointer is NULL.");
   else if (Size == 0)
@@ -397,6 +398,7 @@ void TriCairo_Color::Dispatch(double &r, double &g, double &b, double &a) {
 //=============================================================================
 //=============================================================================
 
+#ifndef FOCIMT_NO_CAIRO
 TriCairo::TriCairo(unsigned int width, unsigned int height,
     TriCairo_CanvasType canvastype, String filename) :
     Width(width), Height(height) {
@@ -676,6 +678,7 @@ void TriCairo::Save(String filename) {
     cairo_surface_write_to_png(surface, filename.c_str());
   }
 }
+#endif /* FOCIMT_NO_CAIRO */
 
 //=============================================================================
 //=============================================================================
@@ -1245,6 +1248,7 @@ void Taquart::axe2dc(AXIS T, AXIS P, nodal_plane *NP1, nodal_plane *NP2) {
 //=============================================================================
 //=============================================================================
 
+#ifndef FOCIMT_NO_CAIRO
 #define RAD2DEG (180.0/M_PI)
 #define EPSIL 0.0001
 #define NP (4) // ????
@@ -1274,6 +1278,7 @@ Taquart::TriCairo_Meca::TriCairo_Meca(unsigned int width, unsigned int height,
   BTensorOutline = TCColor(0.5, 0.5, 0.5);
   BDCColor = TCColor(0.0, 0.0, 0.0);
   BDCWidth = double(BRadius) / 130.0;
+  BTolerance = 0.0;
 
   AxisFontFace = "Arial";
   AxisFontSize = double(BRadius) / 6.0;
@@ -1581,22 +1586,22 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
   double radius_size = BRadius;
 
   int d, b = 1, m;
-  int i, ii, n = 0, j = 1, j2 = 0, j3 = 0;
+  int i, n = 0;
   GMT_LONG npoints;
   TCColor rgb1, rgb2;
   int big_iso = 0;
 
   double a[3], p[3], v[3];
   double vi, iso, f;
-  double fir, s2alphan, alphan;
+  double s2alphan;
   double cfi, sfi, can, san;
   double cpd, spd, cpb, spb, cpm, spm;
   double cad, sad, cab, sab, cam, sam;
-  double xz, xn, xe;
+  double xz, xn, xe, xh;
   double az = 0., azp = 0., takeoff, r;
   double azi[3][2];
-  double x[400], y[400], x2[400], y2[400], x3[400], y3[400];
-  double xp1[800], yp1[800], xp2[800], yp2[800];
+  std::vector<double> x, y, x2, y2, x3, y3;
+  std::vector<double> xp1, yp1, xp2, yp2;
   double si, co;
   int jp_flag;
   int djp, mjp;
@@ -1606,22 +1611,23 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
   DebugFile << "File start" << std::endl;
 #endif
 
-  // Cleanup points.
-  for (int i = 0; i < 400; i++) {
-    x[i] = 0.0;
-    y[i] = 0.0;
-    x2[i] = 0.0;
-    y2[i] = 0.0;
-    x3[i] = 0.0;
-    y3[i] = 0.0;
-  }
-
-  for (int i = 0; i < 800; i++) {
-    xp1[i] = 0.0;
-    yp1[i] = 0.0;
-    xp2[i] = 0.0;
-    yp2[i] = 0.0;
-  }
+  // Number of tessellation steps along the nodal lines and the outer rim.
+  // The angular step is chosen so that the chord error on the beach ball rim
+  // does not exceed BTolerance (in device units).
+  const unsigned int nsteps = TessellationSteps();
+  const double step = 2.0 * M_PI / double(nsteps);
+  TessellationTables(nsteps);
+
+  x.reserve(nsteps + 1);
+  y.reserve(nsteps + 1);
+  x2.reserve(nsteps + 1);
+  y2.reserve(nsteps + 1);
+  x3.reserve(nsteps + 1);
+  y3.reserve(nsteps + 1);
+  xp1.reserve(3 * nsteps + 3);
+  yp1.reserve(3 * nsteps + 3);
+  xp2.reserve(2 * nsteps + 2);
+  yp2.reserve(2 * nsteps + 2);
 
   a[0] = T.str;
   a[1] = N.str;
@@ -1694,9 +1700,12 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
 #ifdef DEBUG_MODE
   DebugFile << "Through angles" << std::endl;
 #endif
-  for (i = 0; i < 360; i++) {
-    fir = (double) i * DEG2RAD;
-    s2alphan = (2. + 2. * iso) / (3. + (1. - 2. * f) * cos(2. * fir));
+  for (i = 0; i < int(nsteps); i++) {
+    // sin(fir), cos(fir) and cos(2 * fir) are taken from the tables.
+    sfi = SinTable[i];
+    cfi = CosTable[i];
+    s2alphan = (2. + 2. * iso)
+        / (3. + (1. - 2. * f) * CosTable[(2 * i) % nsteps]);
 
     if (s2alphan > 1.) {
       big_iso++;
@@ -1719,176 +1728,100 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
 
       f = -v[1] / v[d];
       iso = vi / v[d];
-      s2alphan = (2. + 2. * iso) / (3. + (1. - 2. * f) * cos(2. * fir));
+      s2alphan = (2. + 2. * iso)
+          / (3. + (1. - 2. * f) * CosTable[(2 * i) % nsteps]);
       sincosd(p[d], &spd, &cpd);
       sincosd(p[b], &spb, &cpb);
       sincosd(p[m], &spm, &cpm);
       sincosd(a[d], &sad, &cad);
       sincosd(a[b], &sab, &cab);
       sincosd(a[m], &sam, &cam);
+      // END: Modification according to J. Pesicek
+    }
 
-      alphan = asin(sqrt(s2alphan));
-      sincos(fir, &sfi, &cfi);
-      sincos(alphan, &san, &can);
-
-      xz = can * spd + san * sfi * spb + san * cfi * spm;
-      xn = can * cpd * cad + san * sfi * cpb * cab + san * cfi * cpm * cam;
-      xe = can * cpd * sad + san * sfi * cpb * sab + san * cfi * cpm * sam;
+    // alphan = asin(sqrt(s2alphan)), hence sin(alphan) and cos(alphan)
+    // follow directly without calling trigonometric functions.
+    san = sqrt(s2alphan);
+    can = sqrt(fabs(1.0 - s2alphan));
 
-      if (fabs(xn) < EPSIL && fabs(xe) < EPSIL) {
-        takeoff = 0.;
-        az = 0.;
-      }
-      else {
-        az = atan2(xe, xn);
-        if (az < 0.)
-          az += M_PI * 2.;
-        takeoff = acos(xz / sqrt(xz * xz + xn * xn + xe * xe));
-      }
-      if (takeoff > M_PI_2) {
-        takeoff = M_PI - takeoff;
-        az += M_PI;
-        if (az > M_PI * 2.)
-          az -= M_PI * 2.;
-      }
+    xz = can * spd + san * sfi * spb + san * cfi * spm;
+    xn = can * cpd * cad + san * sfi * cpb * cab + san * cfi * cpm * cam;
+    xe = can * cpd * sad + san * sfi * cpb * sab + san * cfi * cpm * sam;
 
-      //r = M_SQRT2 * sin(takeoff / 2.); /// PROJECTION????
-      //---- Projection to Schmidt or Wullf net?
-      switch (Projection) {
-        case prWulff:
-          r = tan(takeoff / 2.);
-          break;
-        case prSchmidt:
-          r = M_SQRT2 * sin(takeoff / 2.); // Schmidt
-          break;
-        default:
-          r = 0.0;
-          break;
-      }
-      //---- END: Projection to Schmidt or Wullf net?
-
-      sincos(az, &si, &co);
-      if (i == 0) {
-        azi[i][0] = az;
-        x[i] = x0 + radius_size * r * si;
-        y[i] = y0 + radius_size * r * co;
-        azp = az;
-      }
-      else {
-        if (fabs(fabs(az - azp) - M_PI) < DEG2RAD * 10.) {
-          azi[n][1] = azp;
-          azi[++n][0] = az;
-        }
-        if (fabs(fabs(az - azp) - M_PI * 2.) < DEG2RAD * 2.) {
-          if (azp < az)
-            azi[n][0] += M_PI * 2.;
-          else
-            azi[n][0] -= M_PI * 2.;
-        }
-        switch (n) {
-          case 0:
-            x[j] = x0 + radius_size * r * si;
-            y[j] = y0 + radius_size * r * co;
-            j++;
-            break;
-          case 1:
-            x2[j2] = x0 + radius_size * r * si;
-            y2[j2] = y0 + radius_size * r * co;
-            j2++;
-            break;
-          case 2:
-            x3[j3] = x0 + radius_size * r * si;
-            y3[j3] = y0 + radius_size * r * co;
-            j3++;
-            break;
-        }
-        azp = az;
-      }
+    if (fabs(xn) < EPSIL && fabs(xe) < EPSIL) {
+      takeoff = 0.;
+      az = 0.;
+      si = 0.;
+      co = 1.;
     }
-
-    // END: Modification according to J. Pesicek
     else {
-      alphan = asin(sqrt(s2alphan));
-      sincos(fir, &sfi, &cfi);
-      sincos(alphan, &san, &can);
+      az = atan2(xe, xn);
+      if (az < 0.)
+        az += M_PI * 2.;
+      takeoff = acos(xz / sqrt(xz * xz + xn * xn + xe * xe));
+      xh = sqrt(xn * xn + xe * xe);
+      si = xe / xh;
+      co = xn / xh;
+    }
 
-      xz = can * spd + san * sfi * spb + san * cfi * spm;
-      xn = can * cpd * cad + san * sfi * cpb * cab + san * cfi * cpm * cam;
-      xe = can * cpd * sad + san * sfi * cpb * sab + san * cfi * cpm * sam;
+    if (takeoff > M_PI_2) {
+      takeoff = M_PI - takeoff;
+      az += M_PI;
+      if (az > M_PI * 2.)
+        az -= M_PI * 2.;
+      si = -si;
+      co = -co;
+    }
 
-      if (fabs(xn) < EPSIL && fabs(xe) < EPSIL) {
-        takeoff = 0.;
-        az = 0.;
-      }
-      else {
-        az = atan2(xe, xn);
-        if (az < 0.)
-          az += M_PI * 2.;
-        takeoff = acos(xz / sqrt(xz * xz + xn * xn + xe * xe));
-      }
+    //---- Projection to Schmidt or Wullf net?
+    switch (Projection) {
+      case prWulff:
+        r = tan(takeoff / 2.);
+        break;
+      case prSchmidt:
+        r = M_SQRT2 * sin(takeoff / 2.); // Schmidt
+        break;
+      default:
+        r = 0.0;
+        break;
+    }
+    //---- END: Projection to Schmidt or Wullf net?
 
-      if (takeoff > M_PI_2) {
-        takeoff = M_PI - takeoff;
-        az += M_PI;
-        if (az > M_PI * 2.)
-          az -= M_PI * 2.;
+    if (i == 0) {
+      azi[i][0] = az;
+      x.push_back(x0 + radius_size * r * si);
+      y.push_back(y0 + radius_size * r * co);
+      azp = az;
+    }
+    else {
+      // Jumps across the horizon (by ~180 deg) or across north (by ~360 deg).
+      // Both thresholds scale with the tessellation step (10 deg at the
+      // original 1 deg step for the horizon).
+      if (fabs(fabs(az - azp) - M_PI) < 10. * step) {
+        azi[n][1] = azp;
+        azi[++n][0] = az;
       }
-
-      //---- Projection to Schmidt or Wullf net?
-      switch (Projection) {
-        case prWulff:
-          r = tan(takeoff / 2.);
+      if (fabs(fabs(az - azp) - M_PI * 2.) < 2. * step) {
+        if (azp < az)
+          azi[n][0] += M_PI * 2.;
+        else
+          azi[n][0] -= M_PI * 2.;
+      }
+      switch (n) {
+        case 0:
+          x.push_back(x0 + radius_size * r * si);
+          y.push_back(y0 + radius_size * r * co);
           break;
-        case prSchmidt:
-          r = M_SQRT2 * sin(takeoff / 2.); // Schmidt
+        case 1:
+          x2.push_back(x0 + radius_size * r * si);
+          y2.push_back(y0 + radius_size * r * co);
           break;
-        default:
-          r = 0.0;
+        case 2:
+          x3.push_back(x0 + radius_size * r * si);
+          y3.push_back(y0 + radius_size * r * co);
           break;
       }
-      //---- END: Projection to Schmidt or Wullf net?
-
-      sincos(az, &si, &co);
-      if (i == 0) {
-        azi[i][0] = az;
-        x[i] = x0 + radius_size * r * si;
-        //y[i] = Height - (y0 + radius_size * r * co);
-        y[i] = (y0 + radius_size * r * co);
-        azp = az;
-      }
-      else {
-        if (fabs(fabs(az - azp) - M_PI) < DEG2RAD * 10.) {
-          azi[n][1] = azp;
-          azi[++n][0] = az;
-        }
-        if (fabs(fabs(az - azp) - M_PI * 2.) < DEG2RAD * 2.) {
-          if (azp < az)
-            azi[n][0] += M_PI * 2.;
-          else
-            azi[n][0] -= M_PI * 2.;
-        }
-        switch (n) {
-          case 0:
-            x[j] = x0 + radius_size * r * si;
-            //y[j] = Height - (y0 + radius_size * r * co);
-            y[j] = (y0 + radius_size * r * co);
-            j++;
-            break;
-          case 1:
-            x2[j2] = x0 + radius_size * r * si;
-            //y2[j2] = Height - (y0 + radius_size * r * co);
-            y2[j2] = (y0 + radius_size * r * co);
-            j2++;
-            break;
-          case 2:
-            x3[j3] = x0 + radius_size * r * si;
-            //y3[j3] = Height - (y0 + radius_size * r * co);
-            y3[j3] = (y0 + radius_size * r * co);
-            j3++;
-            break;
-        }
-        azp = az;
-      }
+      azp = az;
     }
   } // for loop
 
@@ -1920,18 +1853,13 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
     rgb2 = BMinusColor;
     rgb1 = BPlusColor;
   }
-  //ps_circle(x0, y0, radius_size, rgb2);
 
-  //return;
-  //GMT_setfill (GMT, F1, false);
   switch (n) {
     case 0:
-      for (i = 0; i < 360; i++) {
-        xp1[i] = x[i];
-        yp1[i] = y[i];
-      }
-      npoints = i;
-      Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);
+      xp1 = x;
+      yp1 = y;
+      npoints = xp1.size();
+      Polygon(&xp1[0], &yp1[0], npoints, BTensorOutline, true, rgb1);
 #ifdef DEBUG_MODE
       DebugFile << "A Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);" << std::endl;
       for(int kk=0; kk<npoints; kk++) {
@@ -1942,36 +1870,17 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
       break;
 
     case 1:
-      for (i = 0; i < j; i++) {
-        xp1[i] = x[i];
-        yp1[i] = y[i];
-      }
+      xp1 = x;
+      yp1 = y;
 
       if (azi[0][0] - azi[0][1] > M_PI)
         azi[0][0] -= M_PI * 2.;
       else if (azi[0][1] - azi[0][0] > M_PI)
         azi[0][0] += M_PI * 2.;
 
-      if (azi[0][0] < azi[0][1]) {
-        for (az = azi[0][1] - DEG2RAD; az > azi[0][0]; az -= DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp1[i] = x0 + radius_size * si;
-          //yp1[i++] = Height - (y0 + radius_size * co);
-          yp1[i++] = (y0 + radius_size * co);
-        }
-      }
-      else {
-        for (az = azi[0][1] + DEG2RAD; az < azi[0][0]; az += DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp1[i] = x0 + radius_size * si;
-          //yp1[i++] = Height - (y0 + radius_size * co);
-          yp1[i++] = (y0 + radius_size * co);
-        }
-      }
-      npoints = i;
-      Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);
+      RimArc(xp1, yp1, azi[0][1], azi[0][0], step);
+      npoints = xp1.size();
+      Polygon(&xp1[0], &yp1[0], npoints, BTensorOutline, true, rgb1);
 #ifdef DEBUG_MODE
       DebugFile << "B Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);" << std::endl;
       for(int kk=0; kk<npoints; kk++) {
@@ -1979,36 +1888,18 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
       }
 #endif
 
-      for (i = 0; i < j2; i++) {
-        xp2[i] = x2[i];
-        yp2[i] = y2[i];
-      }
+      xp2 = x2;
+      yp2 = y2;
 
       if (azi[1][0] - azi[1][1] > M_PI)
         azi[1][0] -= M_PI * 2.;
       else if (azi[1][1] - azi[1][0] > M_PI)
         azi[1][0] += M_PI * 2.;
 
-      if (azi[1][0] < azi[1][1]) {
-        for (az = azi[1][1] - DEG2RAD; az > azi[1][0]; az -= DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp2[i] = x0 + radius_size * si;
-          //yp2[i++] = Height - (y0 + radius_size * co);
-          yp2[i++] = (y0 + radius_size * co);
-        }
-      }
-      else {
-        for (az = azi[1][1] + DEG2RAD; az < azi[1][0]; az += DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp2[i] = x0 + radius_size * si;
-          //yp2[i++] = Height - (y0 + radius_size * co);
-          yp2[i++] = (y0 + radius_size * co);
-        }
-      }
-      npoints = i;
-      Polygon(xp2, yp2, npoints, BTensorOutline, true, rgb1);
+      RimArc(xp2, yp2, azi[1][1], azi[1][0], step);
+      npoints = xp2.size();
+      if (npoints > 0)
+        Polygon(&xp2[0], &yp2[0], npoints, BTensorOutline, true, rgb1);
 #ifdef DEBUG_MODE
       DebugFile << "C Polygon(xp2, yp2, npoints, BTensorOutline, true, rgb1);" << std::endl;
       for(int kk=0; kk<npoints; kk++) {
@@ -2018,14 +1909,10 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
       break;
 
     case 2:
-      for (i = 0; i < j3; i++) {
-        xp1[i] = x3[i];
-        yp1[i] = y3[i];
-      }
-      for (ii = 0; ii < j; ii++) {
-        xp1[i] = x[ii];
-        yp1[i++] = y[ii];
-      }
+      xp1 = x3;
+      yp1 = y3;
+      xp1.insert(xp1.end(), x.begin(), x.end());
+      yp1.insert(yp1.end(), y.begin(), y.end());
 
       /* Removed by Jeremy Pesicek
        if(big_iso)
@@ -2045,56 +1932,27 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
       else if (azi[0][1] - azi[2][0] > M_PI)
         azi[2][0] += M_PI * 2.;
 
-      if (azi[2][0] < azi[0][1])
-        for (az = azi[0][1] - DEG2RAD; az > azi[2][0]; az -= DEG2RAD) {
-          sincos(az, &si, &co);
-          xp1[i] = x0 + radius_size * si;
-          //yp1[i++] = Height - (y0 + radius_size * co);
-          yp1[i++] = (y0 + radius_size * co);
-        }
-      else
-        for (az = azi[0][1] + DEG2RAD; az < azi[2][0]; az += DEG2RAD) {
-          sincos(az, &si, &co);
-          xp1[i] = x0 + radius_size * si;
-          //yp1[i++] = Height - (y0 + radius_size * co);
-          yp1[i++] = (y0 + radius_size * co);
-        }
-      npoints = i;
-      Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);
+      RimArc(xp1, yp1, azi[0][1], azi[2][0], step);
+      npoints = xp1.size();
+      Polygon(&xp1[0], &yp1[0], npoints, BTensorOutline, true, rgb1);
 #ifdef DEBUG_MODE
       DebugFile << "D Polygon(xp1, yp1, npoints, BTensorOutline, true, rgb1);" << std::endl;
       for(int kk=0; kk<npoints; kk++) {
         DebugFile << xp1[kk] << " " << yp1[kk] << std::endl;
       }
 #endif
-      for (i = 0; i < j2; i++) {
-        xp2[i] = x2[i];
-        yp2[i] = y2[i];
-      }
+      xp2 = x2;
+      yp2 = y2;
 
       if (azi[1][0] - azi[1][1] > M_PI)
         azi[1][0] -= M_PI * 2.;
       else if (azi[1][1] - azi[1][0] > M_PI)
         azi[1][0] += M_PI * 2.;
 
-      if (azi[1][0] < azi[1][1])
-        for (az = azi[1][1] - DEG2RAD; az > azi[1][0]; az -= DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp2[i] = x0 + radius_size * si;
-          //yp2[i++] = Height - (y0 + radius_size * co);
-          yp2[i++] = (y0 + radius_size * co);
-        }
-      else
-        for (az = azi[1][1] + DEG2RAD; az < azi[1][0]; az += DEG2RAD)
-        {
-          sincos(az, &si, &co);
-          xp2[i] = x0 + radius_size * si;
-          //yp2[i++] = Height - (y0 + radius_size * co);
-          yp2[i++] = (y0 + radius_size * co);
-        }
-      npoints = i;
-      Polygon(xp2, yp2, npoints, BTensorOutline, true, rgb1);
+      RimArc(xp2, yp2, azi[1][1], azi[1][0], step);
+      npoints = xp2.size();
+      if (npoints > 0)
+        Polygon(&xp2[0], &yp2[0], npoints, BTensorOutline, true, rgb1);
 #ifdef DEBUG_MODE
       DebugFile << "E Polygon(xp2, yp2, npoints, BTensorOutline, true, rgb1);" << std::endl;
       for(int kk=0; kk<npoints; kk++) {
@@ -2105,6 +1963,59 @@ void Taquart::TriCairo_Meca::Tensor(AXIS T, AXIS N, AXIS P) {
   }
 }
 
+//---------------------------------------------------------------------------
+unsigned int Taquart::TriCairo_Meca::TessellationSteps(void) {
+  // Angular step for which the chord deviates from the circle of radius
+  // BRadius by at most BTolerance: R * (1 - cos(step/2)) <= tolerance.
+  double tolerance = BTolerance;
+  if (tolerance <= 0.0)
+    tolerance = CanvasType == ctSurface ? 0.1 : 0.025;
+  if (BRadius == 0 || tolerance >= double(BRadius))
+    return MECA_TESSELLATION_MIN;
+
+  double step = 2.0 * acos(1.0 - tolerance / double(BRadius));
+  double steps = ceil(2.0 * M_PI / step);
+  if (steps < MECA_TESSELLATION_MIN)
+    return MECA_TESSELLATION_MIN;
+  if (steps > MECA_TESSELLATION_MAX)
+    return MECA_TESSELLATION_MAX;
+  return (unsigned int) steps;
+}
+
+//---------------------------------------------------------------------------
+void Taquart::TriCairo_Meca::TessellationTables(unsigned int nsteps) {
+  // Tables are kept between calls (e.g. several tensors on one canvas).
+  if (SinTable.size() == nsteps)
+    return;
+  SinTable.resize(nsteps);
+  CosTable.resize(nsteps);
+  const double step = 2.0 * M_PI / double(nsteps);
+  for (unsigned int i = 0; i < nsteps; i++)
+    sincos(double(i) * step, &SinTable[i], &CosTable[i]);
+}
+
+//---------------------------------------------------------------------------
+void Taquart::TriCairo_Meca::RimArc(std::vector<double> &x,
+    std::vector<double> &y, double from, double to, double step) {
+  // Append points of the beach ball rim lying strictly between azimuths
+  // 'from' and 'to'. The point is rotated by a constant angle, so only one
+  // sincos() call is required for the whole arc.
+  double si, co, sstep, cstep, temp;
+  double dir = to < from ? -1.0 : 1.0;
+  int k, n = int(ceil(fabs(to - from) / step)) - 1;
+  if (n <= 0)
+    return;
+  sincos(from + dir * step, &si, &co);
+  sincos(dir * step, &sstep, &cstep);
+  for (k = 0; k < n; k++) {
+    x.push_back(BXo + BRadius * si);
+    y.push_back(BYo + BRadius * co);
+    temp = si * cstep + co * sstep;
+    co = co * cstep - si * sstep;
+    si = temp;
+  }
+}
+
 //---------------------------------------------------------------------------
 void Taquart::TriCairo_Meca::Project(double &X, double &Y) {
   if (Hemisphere == heUpper) {
@@ -2566,6 +2477,7 @@ void * Taquart::TriCairo_Meca::GMT_memory(void *prev_addr, GMT_LONG nelem,
 void Taquart::TriCairo_Meca::GMT_free(void *addr) {
   free(addr);
 }
+#endif /* FOCIMT_NO_CAIRO */
 
 //=============================================================================
 //=============================================================================
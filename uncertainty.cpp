@@ -0,0 +1,215 @@
+//-----------------------------------------------------------------------------
+// Source: uncertainty.cpp
+// Module: focimt
+// Linearised uncertainty of the fault solution parameters.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <math.h>
+#include <algorithm>
+#include "uncertainty.h"
+#include "usmtcore.h"
+#include "symsolve.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  const double R2D = 180.0 / M_PI;
+
+  //! Number of propagated parameters, in the order of SolutionUncertainty.
+  const int NPAR = 17;
+
+  //! Parameters given in degrees modulo 360 (strikes, rakes and trends).
+  const bool Cyclic[NPAR] = { true, false, true, true, false, true, true,
+      false, true, false, true, false, false, false, false, false, false };
+
+  //! Orientation of the solution followed by the perturbed tensors.
+  class Frame {
+    public:
+      double Axes[3][3]; //!< P, B and T eigenvectors.
+      double Flip[2]; //!< Sign of the normal of each nodal plane.
+  };
+
+  //! Strike, dip and rake [deg] of a plane with normal n and slip d.
+  void Plane(const double n[3], const double d[3], double p[3]) {
+    const double sd = sqrt(n[0] * n[0] + n[1] * n[1]);
+    const double f = atan2(-n[0], n[1]);
+    p[0] = f * R2D;
+    p[1] = atan2(sd, -n[2]) * R2D;
+    p[2] = atan2(-d[2], sd * (d[0] * cos(f) + d[1] * sin(f))) * R2D;
+  }
+
+  //! Trend and plunge [deg] of an axis (x north, y east, z down).
+  void Axis(const double v[3], double p[2]) {
+    p[0] = atan2(v[1], v[0]) * R2D;
+    p[1] = asin(std::max(-1.0, std::min(1.0, v[2]))) * R2D;
+  }
+
+  //! Parameters p of the tensor m (M11, M12, M13, M22, M23, M33).
+  /*! With Reference set the orientation of the solution is stored in f,
+   *  otherwise the eigenvectors and plane normals are oriented as in f, so
+   *  that the parameters change continuously with m.
+   */
+  void Parameters(const double m[6], bool Reference, Frame &f,
+      double p[NPAR]) {
+    using namespace Taquart::UsmtCore;
+    double M[3][3] = { { m[0], m[1], m[2] }, { m[1], m[3], m[4] }, { m[2],
+        m[4], m[5] } };
+    double L[3], V[3][3];
+    SymmetricEigen3(M, L, V);
+
+    // Eigenvectors in the order P, B, T.
+    int o[3] = { 0, 1, 2 };
+    for (int i = 0; i < 2; i++)
+      for (int j = i + 1; j < 3; j++)
+        if (L[o[j]] < L[o[i]])
+          std::swap(o[i], o[j]);
+    double a[3][3];
+    for (int j = 0; j < 3; j++) {
+      double s = 0.0;
+      for (int k = 0; k < 3; k++) {
+        a[j][k] = V[k][o[j]];
+        s += Reference ? 0.0 : a[j][k] * f.Axes[j][k];
+      }
+      if (Reference ? a[j][2] < 0.0 : s < 0.0)
+        for (int k = 0; k < 3; k++)
+          a[j][k] = -a[j][k];
+      if (Reference)
+        for (int k = 0; k < 3; k++)
+          f.Axes[j][k] = a[j][k];
+    }
+    Axis(a[0], &p[6]);
+    Axis(a[2], &p[8]);
+    Axis(a[1], &p[10]);
+
+    // Nodal planes, normals and slips are the bisectors of T and P.
+    for (int i = 0; i < 2; i++) {
+      double n[3], d[3];
+      for (int k = 0; k < 3; k++) {
+        n[k] = (a[2][k] + (i == 0 ? -a[0][k] : a[0][k])) / M_SQRT2;
+        d[k] = (a[2][k] + (i == 0 ? a[0][k] : -a[0][k])) / M_SQRT2;
+      }
+      if (Reference)
+        f.Flip[i] = n[2] > 0.0 ? -1.0 : 1.0;
+      for (int k = 0; k < 3; k++) {
+        n[k] *= f.Flip[i];
+        d[k] *= f.Flip[i];
+      }
+      Plane(n, d, &p[3 * i]);
+    }
+
+    // Decomposition and scalar moment.
+    double E[3 + 1] = { 0.0, L[o[0]], L[o[1]], L[o[2]] }, MT, Dum;
+    EIGGEN(E[1], E[2], E[3], p[12], p[13], p[14], Dum, Dum, Dum);
+    SCALARMOMENT(E, p[15], MT);
+    p[16] = mw(p[15]);
+  }
+}
+
+//-----------------------------------------------------------------------------
+Taquart::SolutionUncertainty::SolutionUncertainty(void) {
+  FIA = DLA = RAKEA = FIB = DLB = RAKEB = 0.0;
+  PXTR = PXPL = TXTR = TXPL = BXTR = BXPL = 0.0;
+  EXPL = CLVD = DBCP = M0 = MAGN = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::PropagateUncertainty(const Taquart::FaultSolution &s,
+    Taquart::SolutionUncertainty &u) {
+  u = Taquart::SolutionUncertainty();
+  const int r[6] = { 1, 1, 1, 2, 2, 3 };
+  const int c[6] = { 1, 2, 3, 2, 3, 3 };
+  double m[6], Scale = 0.0;
+  for (int k = 0; k < 6; k++) {
+    m[k] = s.M[r[k]][c[k]];
+    Scale = std::max(Scale, fabs(m[k]));
+  }
+  if (Scale == 0.0)
+    return false;
+
+  // Orientation of the solution; its first plane is matched to FIA/DLA.
+  Frame f;
+  double p[NPAR];
+  Parameters(m, true, f, p);
+  const double sf = sin(s.FIA / R2D), cf = cos(s.FIA / R2D);
+  const double sd = sin(s.DLA / R2D), cd = cos(s.DLA / R2D);
+  double na[3] = { -sd * sf, sd * cf, -cd }, Dot[2] = { 0.0, 0.0 };
+  for (int i = 0; i < 2; i++) {
+    double d[3];
+    for (int k = 0; k < 3; k++) {
+      const double t = f.Axes[2][k], q = f.Axes[0][k];
+      d[k] = (i == 0 ? t - q : t + q) / M_SQRT2;
+      Dot[i] += d[k] * na[k];
+    }
+  }
+  const bool Swap = fabs(Dot[1]) > fabs(Dot[0]);
+
+  // Jacobian by central differences.
+  const double h = 1.0e-6 * Scale;
+  double J[NPAR][6];
+  for (int k = 0; k < 6; k++) {
+    double mp[6], mm[6], pp[NPAR], pm[NPAR];
+    for (int j = 0; j < 6; j++)
+      mp[j] = mm[j] = m[j];
+    mp[k] += h;
+    mm[k] -= h;
+    Parameters(mp, false, f, pp);
+    Parameters(mm, false, f, pm);
+    for (int i = 0; i < NPAR; i++) {
+      double d = pp[i] - pm[i];
+      if (Cyclic[i])
+        d = d - 360.0 * floor(d / 360.0 + 0.5);
+      J[i][k] = d / (2.0 * h);
+    }
+  }
+
+  // Variances J C J^T.
+  double Sigma[NPAR];
+  for (int i = 0; i < NPAR; i++) {
+    double v = 0.0;
+    for (int k = 0; k < 6; k++)
+      for (int l = 0; l < 6; l++)
+        v += J[i][k] * s.Covariance[k + 1][l + 1] * J[i][l];
+    Sigma[i] = sqrt(std::max(v, 0.0));
+  }
+  const int a = Swap ? 3 : 0, b = Swap ? 0 : 3;
+  u.FIA = Sigma[a];
+  u.DLA = Sigma[a + 1];
+  u.RAKEA = Sigma[a + 2];
+  u.FIB = Sigma[b];
+  u.DLB = Sigma[b + 1];
+  u.RAKEB = Sigma[b + 2];
+  u.PXTR = Sigma[6];
+  u.PXPL = Sigma[7];
+  u.TXTR = Sigma[8];
+  u.TXPL = Sigma[9];
+  u.BXTR = Sigma[10];
+  u.BXPL = Sigma[11];
+  u.EXPL = Sigma[12];
+  u.CLVD = Sigma[13];
+  u.DBCP = Sigma[14];
+  u.M0 = Sigma[15];
+  u.MAGN = Sigma[16];
+  return true;
+}
@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// Source: uncertainty.h
+// Module: focimt
+// Linearised uncertainty of the fault solution parameters.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef UNCERTAINTY_H_
+#define UNCERTAINTY_H_
+//-----------------------------------------------------------------------------
+#include "faultsolution.h"
+
+namespace Taquart {
+
+  //! Standard deviations of the parameters of a fault solution.
+  /*! Fields are named after the corresponding FaultSolution members.
+   */
+  class SolutionUncertainty {
+    public:
+      double FIA, DLA, RAKEA; /*!< First nodal plane [deg]. */
+      double FIB, DLB, RAKEB; /*!< Second nodal plane [deg]. */
+      double PXTR, PXPL; /*!< P-axis trend and plunge [deg]. */
+      double TXTR, TXPL; /*!< T-axis trend and plunge [deg]. */
+      double BXTR, BXPL; /*!< B-axis trend and plunge [deg]. */
+      double EXPL, CLVD, DBCP; /*!< Decomposition [%]. */
+      double M0; /*!< Scalar seismic moment [Nm]. */
+      double MAGN; /*!< Moment magnitude. */
+
+      //! Default constructor, all deviations zero.
+      SolutionUncertainty(void);
+  };
+
+  //! Propagates the covariance of the moment tensor to its parameters.
+  /*! The parameters are derived from the eigenvalues and eigenvectors of
+   *  the moment tensor as in XTRINF: axes from the eigenvectors, nodal
+   *  planes from their bisectors, the decomposition from the eigenvalues
+   *  (EIGGEN) and M0 from SCALARMOMENT. Their Jacobian with respect to
+   *  M11, M12, M13, M22, M23, M33 is evaluated at the solution by central
+   *  differences, with eigenvectors kept continuous with those of the
+   *  solution, and the standard deviations follow from J C J^T with C the
+   *  Covariance of the solution. This is a first-order estimate: it is
+   *  poor where the parameters are not smooth in the tensor (two nearly
+   *  equal eigenvalues, nearly horizontal planes or vertical axes) and
+   *  zero for the L1 norm, which provides no covariance.
+   *  \param s Fault solution.
+   *  \param u Standard deviations.
+   *  \return \p false if the tensor vanishes.
+   */
+  bool PropagateUncertainty(const Taquart::FaultSolution &s,
+      Taquart::SolutionUncertainty &u);
+}
+
+//-----------------------------------------------------------------------------
+#endif /* UNCERTAINTY_H_ */
@@ -32,31 +32,39 @@
 // DEALINGS IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 #include "usmtcore.h"
+#include "gridsearch.h"
+#include "symsolve.h"
 #include <fstream>
+#include <algorithm>
+#include <vector>
 //-----------------------------------------------------------------------------
 
-#define USMT_UPSCALE (1.0e+12)
-#define USMT_DOWNSCALE (1.0e-12)
-
 using namespace Taquart::UsmtCore;
 using namespace Taquart;
 
 namespace Taquart {
   namespace UsmtCore {
     int NDAE[10] = { 0, 36, 36, 32, 32, 24, 24, 16, 8, 4 };
-    double U[FOCIMT_MAXCHANNEL + 1];
-    double AZM[FOCIMT_MAXCHANNEL + 1];
-    double TKF[FOCIMT_MAXCHANNEL + 1];
-    double GA[FOCIMT_MAXCHANNEL + 1][3 + 1];
-    double A[FOCIMT_MAXCHANNEL + 1][6 + 1];
-    double FIJ[3 + 1][3 + 1][FOCIMT_MAXCHANNEL + 1];
+    int NCAP = 0;
+    double * U = 0;
+    double * AZM = 0;
+    double * TKF = 0;
+    double (*GA)[3 + 1] = 0;
+    double (*A)[6 + 1] = 0;
+    double * FIJ[3 + 1][3 + 1];
     double RM[6 + 1][3 + 1];
     double COV[6 + 1][6 + 1][3 + 1];
-    int RO[FOCIMT_MAXCHANNEL + 1];
-    int VEL[FOCIMT_MAXCHANNEL + 1];
-    int R[FOCIMT_MAXCHANNEL + 1];
-    double UTH[FOCIMT_MAXCHANNEL + 1][3 + 1];
-    Taquart::String Station[FOCIMT_MAXCHANNEL + 1];
+    int * RO = 0;
+    int * VEL = 0;
+    int * R = 0;
+    double (*UTH)[3 + 1] = 0;
+    double (*LEV)[3 + 1] = 0;
+    double (*COOK)[3 + 1] = 0;
+    double * GSPREFIX[6 + 1];
+    int * KEY = 0;
+    bool RESIDUALS = true;
+    std::shared_ptr<const std::vector<Taquart::String> > NAMES;
+    std::vector<Taquart::String> Station;
     int N = 0;
     double TROZ = 0.0;
     double QSD = 0.0;
@@ -65,10 +73,84 @@ namespace Taquart {
     int ICOND = 0;
     Taquart::FaultSolution Solution[4];
     int ISTA = 1;
+    double GSTOLX = 0.0;
+    double GSTOLF = 0.0;
+    int GSCOARSE = 0;
+    bool DCSDR = false;
+    double WSRADIUS = 0.0;
+    bool WARMSTART = false;
+    double WARMX[6 + 1][3 + 1];
+    double WARMR[6 + 1][3 + 1];
+    bool GIVENL2 = false;
+    double GIVENRM[6 + 1][2 + 1];
   //int * ThreadProgress;
   }// namespace UsmtCore
 } // namespace Foci
 
+//---------------------------------------------------------------------------
+namespace {
+  // Nodes per block of the radiation table of GSOLDC.
+  const int DCBLOCK = 32;
+
+  // Scratch arrays of MOM1, MOM2, BETTER, DCMISFIT and GSOLDC (see CHANNELS).
+  double (*WAA)[6 + 1] = 0;
+  double (*WH)[5 + 1] = 0;
+  int * WIW = 0;
+  double * WAM0 = 0;
+  double * WC[6 + 1];
+  double * WDU = 0;
+  double * WR = 0;
+  std::pair<double, double> * WT = 0;
+  double * WRAD = 0;
+
+  //! Storage of all channel arrays.
+  std::vector<char> Workspace;
+  const size_t CacheLine = 64;
+
+  //! Takes n elements of T at Pos of the workspace Base, starting at a
+  //! cache line. With Base null only Pos is advanced.
+  template<class T> T * Carve(char * Base, size_t &Pos, size_t n) {
+    Pos = (Pos + CacheLine - 1) / CacheLine * CacheLine;
+    T * p = Base ? (T *) (Base + Pos) : 0;
+    Pos += n * sizeof(T);
+    return p;
+  }
+
+  //! Places the channel arrays for Cap channels at Base and returns the
+  //! size of the workspace.
+  size_t Layout(char * Base, int Cap) {
+    size_t Pos = 0, n = Cap + 1;
+    U = Carve<double>(Base, Pos, n);
+    AZM = Carve<double>(Base, Pos, n);
+    TKF = Carve<double>(Base, Pos, n);
+    GA = Carve<double[3 + 1]>(Base, Pos, n);
+    A = Carve<double[6 + 1]>(Base, Pos, n);
+    for (int i = 0; i <= 3; i++)
+      for (int j = 0; j <= 3; j++)
+        FIJ[i][j] = Carve<double>(Base, Pos, n);
+    RO = Carve<int>(Base, Pos, n);
+    VEL = Carve<int>(Base, Pos, n);
+    R = Carve<int>(Base, Pos, n);
+    UTH = Carve<double[3 + 1]>(Base, Pos, n);
+    LEV = Carve<double[3 + 1]>(Base, Pos, n);
+    COOK = Carve<double[3 + 1]>(Base, Pos, n);
+    KEY = Carve<int>(Base, Pos, n);
+    for (int i = 0; i <= 6; i++)
+      GSPREFIX[i] = Carve<double>(Base, Pos, n);
+    WAA = Carve<double[6 + 1]>(Base, Pos, n);
+    WH = Carve<double[5 + 1]>(Base, Pos, n);
+    WIW = Carve<int>(Base, Pos, n);
+    WAM0 = Carve<double>(Base, Pos, n);
+    for (int i = 0; i <= 6; i++)
+      WC[i] = Carve<double>(Base, Pos, n);
+    WDU = Carve<double>(Base, Pos, n);
+    WR = Carve<double>(Base, Pos, n);
+    WT = Carve<std::pair<double, double> >(Base, Pos, n);
+    WRAD = Carve<double>(Base, Pos, n * DCBLOCK);
+    return Pos;
+  }
+}
+
 //---------------------------------------------------------------------------
 void TransferSolution(Taquart::SolutionType AType,
     std::list<Taquart::FaultSolution> &ASolution) {
@@ -97,7 +179,7 @@ double Taquart::UsmtCore::mw(double m0) {
 
 //---------------------------------------------------------------------------
 void USMTCore(Taquart::NormType ANormType, int QualityType,
-    Taquart::SMTInputData &InputData) {
+    Taquart::SMTInputData &InputData, const Taquart::FaultSolutions * Start) {
   int IEXP = 0;
   //ThreadProgress = AThreadProgress;
   PROGRESS(0, 350);
@@ -108,6 +190,7 @@ void USMTCore(Taquart::NormType ANormType, int QualityType,
     case Taquart::ntL1:
       MOM2(false, QualityType);
       SIZEMM(IEXP);
+      WARMSET(Start);
       MOM1(IEXP, QualityType);
       break;
     case Taquart::ntL2:
@@ -132,8 +215,8 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   //      COMMON/PDATA/ A(80,6)
   //      DIMENSION EQM(3),AA(80,6),B(6),H(5),IW(80),PA(3),BB(6)
   //      REAL RM0(3),RMT(3),PCLVD(2),PDBCP(2)
-  double AA[FOCIMT_MAXCHANNEL + 1][6 + 1];
-  unsigned int IW[FOCIMT_MAXCHANNEL + 1];
+  double (*AA)[6 + 1] = WAA;
+  int * IW = WIW;
   double PA[3 + 1];
   Zero(PA, 4);
   double EQM[3 + 1];
@@ -167,6 +250,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   double PEXPLO = 0.0;
   double RMAG = 0.0;
   double MAGN[4];
+  int ROUNDS[4] = { 0, 0, 0, 0 };
 
   const double PI = 4.0 * atan(1.0);
 
@@ -274,7 +358,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   }
 
   //---- Full solution calculation.
-  GSOL(B, IEXP);
+  ROUNDS[1] = GSOL(B, IEXP);
   EIG3(B, 0, EQM);
 
   double EQQ1 = EQM[1];
@@ -373,7 +457,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   PEXPL[1] = PEXPLO;
 
   //---- Trace-null solution calculation.
-  GSOL5(H, IEXP);
+  ROUNDS[2] = GSOL5(H, IEXP);
 
   for (int i = 1; i <= 5; i++)
     RM[i][2] = H[i];
@@ -475,7 +559,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   PEXPL[2] = 0.0;
 
   //---- Double-couple solution calculation.
-  GSOLA(H, IEXP);
+  ROUNDS[3] = DCSDR ? GSOLDC(H, IEXP) : GSOLA(H, IEXP);
   for (int i = 1; i <= 5; i++)
     RM[i][3] = H[i];
   RM[6][3] = -RM[1][3] - RM[4][3];
@@ -562,20 +646,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
   PDBCP_VAC[3] = 100.0;
 
   // Transfer data to output structure
-  for (int i = 1; i <= N; i++) {
-    Solution[1].U_n = N;
-    Solution[2].U_n = N;
-    Solution[3].U_n = N;
-    Solution[1].U_th[i - 1] = UTH[i][1];
-    Solution[2].U_th[i - 1] = UTH[i][2];
-    Solution[3].U_th[i - 1] = UTH[i][3];
-    Solution[1].U_measured[i - 1] = U[i];
-    Solution[2].U_measured[i - 1] = U[i];
-    Solution[3].U_measured[i - 1] = U[i];
-    Solution[1].Station[i - 1] = Station[i];
-    Solution[2].Station[i - 1] = Station[i];
-    Solution[3].Station[i - 1] = Station[i];
-  }
+  CHANNELOUT(false);
 
   //std::ofstream file("file.txt",std::ofstream::out | std::ofstream::app);
   for (int q = 1; q <= 3; q++) {
@@ -613,6 +684,7 @@ void Taquart::UsmtCore::MOM1(int &IEXP, int QualityType) {
     Solution[i].CLVD_VAC = PCLVD_VAC[i];
     Solution[i].DBCP_VAC = PDBCP_VAC[i];
     Solution[i].MAGN = MAGN[i];
+    Solution[i].ROUNDS = ROUNDS[i];
     for (int m = 1; m <= 6; m++)
       for (int n = 1; n <= 6; n++)
         Solution[i].Covariance[m][n] = 0.0;
@@ -1207,65 +1279,27 @@ void Taquart::UsmtCore::XTRINF(int &ICOND, int LNORM, double Moment0[],
 //-----------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
-void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
-  //      SUBROUTINE MOM2(REALLY)
-  //      CHARACTER PS(80),TITLE*40
-  //      REAL U(80),ARR(80),AZM(80),TKF(80),A(80,6),ATA(6,6),
-  //     $ATAINV(6,6),B(6),EQM(3),AA(80,6),Z1(9,9),Z2(9,9),H(80,5),
-  //     $IW(80),PA(3),BB(6),RM0(3),RMT(3),PCLVD(2),PDBCP(2),LLA(3),HA(2)
-  //      INTEGER RO(80),VEL(80),R(80)
-  //      COMMON/MDATA/ PS,U,ARR,AZM,TKF,RO,VEL,R,TITLE,N,TROZ
-  //      COMMON/GAGAGA/ GA(80,3)
-  //      COMMON/MOMNT/ RM(6,3)
-  //      COMMON/RESTEX/ RESULT
-  //      CHARACTER*56 RESULT(34)
-  //      DOUBLE PRECISION COV(6,6,3),SAI22
-  //      COMMON/VCOVAR/ COV
-  //      LOGICAL REALLY
+void Taquart::UsmtCore::SCALARMOMENT(const double E[], double &RM0,
+    double &RMT) {
+  double EQM[3 + 1];
+  EQM[1] = fabs(E[1]) * USMT_DOWNSCALE;
+  EQM[2] = fabs(E[2]) * USMT_DOWNSCALE;
+  EQM[3] = fabs(E[3]) * USMT_DOWNSCALE;
+  double HELP1 = fabs(EQM[1] - EQM[2]);
+  double HELP2 = fabs(EQM[1] - EQM[3]);
+  double HELP3 = fabs(EQM[2] - EQM[3]);
+  double EU = sqrt(0.5 * (EQM[1] * EQM[1] + EQM[2] * EQM[2] + EQM[3] * EQM[3]));
+  double EC = amax1(HELP1, HELP2);
+  EC = amax1(EC, HELP3);
+  RMT = amax1(EC, EU) * USMT_UPSCALE;
+  RM0 = amin1(EC, EU) * USMT_UPSCALE;
+}
 
-  //      PI=4.*ATAN(1.)
-  double PI = 4.0 * atan(1.0);
-  int IW[FOCIMT_MAXCHANNEL + 1];
+//-----------------------------------------------------------------------------
+void Taquart::UsmtCore::KERNEL(void) {
+  int * IW = WIW;
   double PA[3 + 1];
   Zero(&PA[0], 4);
-  double ATA[6 + 1][6 + 1];
-  Zero(&ATA[0][0], 49);
-  double ATAINV[6 + 1][6 + 1];
-  Zero(&ATAINV[0][0], 49);
-  double Z1[9 + 1][9 + 1];
-  Zero(&Z1[0][0], 100);
-  double Z2[9 + 1][9 + 1];
-  Zero(&Z2[0][0], 100);
-  double BB[6 + 1];
-  Zero(&BB[0], 7);
-  double B[6 + 1];
-  Zero(&B[0], 7);
-  double EQM[3 + 1];
-  Zero(EQM, 4);
-  double EQQ1 = 0.0, EQQ2 = 0.0, EQQ3 = 0.0;
-  double HELP1 = 0.0, HELP2 = 0.0, HELP3 = 0.0;
-  double EU = 0.0, EC = 0.0;
-  double RM0[3 + 1];
-  Zero(RM0, 4);
-  double RMT[3 + 1];
-  Zero(RMT, 4);
-  double RMERR[3 + 1];
-  Zero(RMERR, 4);
-  double EPS = 0.0;
-  double SAI22 = 0.0;
-  double SIG = 0.0;
-  double AA[FOCIMT_MAXCHANNEL + 1][6 + 1];
-  Zero(&AA[0][0], (FOCIMT_MAXCHANNEL + 1) * 7);
-  double DUM = 0.0;
-  double H[FOCIMT_MAXCHANNEL + 1][5 + 1];
-  Zero(&H[0][0], (FOCIMT_MAXCHANNEL + 1) * 6);
-  double RMX = 0.0, RMY = 0.0, RMZ = 0.0;
-  double RMAG = 0.0;
-  double PEXPL[4], PCLVD[3 + 1], PDBCP[3 + 1];
-  double PEXPL_VAC[4], PCLVD_VAC[3 + 1], PDBCP_VAC[3 + 1];
-  double ALF = 0.0;
-  double MAGN[4];
-  double HELP = 0.0;
   double LLA[4];
   Zero(LLA, 4);
   double HA[4];
@@ -1280,30 +1314,11 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
     //if(PS[i] == 'S' || PS[i] == 's') IW[i] = 1;
     //if(PS[i] == 'H' || PS[i] == 'h') IW[i] = 2;
 
-    //      ALF=FLOAT(VEL(I))
-    //      HELP=4.*PI*FLOAT(RO(I))*ALF*ALF*ALF*FLOAT(R(I))*TROZ*1.E-12
-    ALF = VEL[i];
-
-    /* DONE  5 -c2.4.14 : Problem z kalibracjï¿½ (USMTCORE) */
-    HELP = 4.0 * PI
-        * double(RO[i]) * ALF * ALF * ALF * double(R[i]) * USMT_DOWNSCALE;
-
     //      IF(IW(I).NE.0) GO TO 5
     if (IW[i] == 0) {
       //C     For P:
-      //      A(I,1)=GA(I,1)*GA(I,1)/HELP
-      //      A(I,2)=2.*GA(I,1)*GA(I,2)/HELP
-      //      A(I,3)=2.*GA(I,1)*GA(I,3)/HELP
-      //      A(I,4)=GA(I,2)*GA(I,2)/HELP
-      //      A(I,5)=2.*GA(I,2)*GA(I,3)/HELP
-      //      A(I,6)=GA(I,3)*GA(I,3)/HELP
       //      GO TO 3
-      A[i][1] = GA[i][1] * GA[i][1] / HELP;
-      A[i][2] = 2.0 * GA[i][1] * GA[i][2] / HELP;
-      A[i][3] = 2.0 * GA[i][1] * GA[i][3] / HELP;
-      A[i][4] = GA[i][2] * GA[i][2] / HELP;
-      A[i][5] = 2. * GA[i][2] * GA[i][3] / HELP;
-      A[i][6] = GA[i][3] * GA[i][3] / HELP;
+      KERNELROW(GA[i], RO[i], VEL[i], R[i], A[i]);
     }
     /* Code for SV and SH is switched off by default. */
     /*
@@ -1374,42 +1389,141 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
      */
   }
   //    3 CONTINUE
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::UsmtCore::KERNELROW(const double G[], int RO, int VEL, int R,
+    double A[]) {
+  const double PI = 4.0 * atan(1.0);
+
+  //      ALF=FLOAT(VEL(I))
+  //      HELP=4.*PI*FLOAT(RO(I))*ALF*ALF*ALF*FLOAT(R(I))*TROZ*1.E-12
+  const double ALF = VEL;
+
+  /* DONE  5 -c2.4.14 : Problem z kalibracjï¿½ (USMTCORE) */
+  const double HELP = 4.0 * PI
+      * double(RO) * ALF * ALF * ALF * double(R) * USMT_DOWNSCALE;
+
+  //      A(I,1)=GA(I,1)*GA(I,1)/HELP
+  //      A(I,2)=2.*GA(I,1)*GA(I,2)/HELP
+  //      A(I,3)=2.*GA(I,1)*GA(I,3)/HELP
+  //      A(I,4)=GA(I,2)*GA(I,2)/HELP
+  //      A(I,5)=2.*GA(I,2)*GA(I,3)/HELP
+  //      A(I,6)=GA(I,3)*GA(I,3)/HELP
+  A[1] = G[1] * G[1] / HELP;
+  A[2] = 2.0 * G[1] * G[2] / HELP;
+  A[3] = 2.0 * G[1] * G[3] / HELP;
+  A[4] = G[2] * G[2] / HELP;
+  A[5] = 2. * G[2] * G[3] / HELP;
+  A[6] = G[3] * G[3] / HELP;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
+  //      SUBROUTINE MOM2(REALLY)
+  //      CHARACTER PS(80),TITLE*40
+  //      REAL U(80),ARR(80),AZM(80),TKF(80),A(80,6),ATA(6,6),
+  //     $ATAINV(6,6),B(6),EQM(3),AA(80,6),Z1(9,9),Z2(9,9),H(80,5),
+  //     $IW(80),PA(3),BB(6),RM0(3),RMT(3),PCLVD(2),PDBCP(2),LLA(3),HA(2)
+  //      INTEGER RO(80),VEL(80),R(80)
+  //      COMMON/MDATA/ PS,U,ARR,AZM,TKF,RO,VEL,R,TITLE,N,TROZ
+  //      COMMON/GAGAGA/ GA(80,3)
+  //      COMMON/MOMNT/ RM(6,3)
+  //      COMMON/RESTEX/ RESULT
+  //      CHARACTER*56 RESULT(34)
+  //      DOUBLE PRECISION COV(6,6,3),SAI22
+  //      COMMON/VCOVAR/ COV
+  //      LOGICAL REALLY
+
+  double ATA[6 + 1][6 + 1];
+  Zero(&ATA[0][0], 49);
+  double ATAINV[6 + 1][6 + 1];
+  Zero(&ATAINV[0][0], 49);
+  double Z1[9 + 1][9 + 1];
+  Zero(&Z1[0][0], 100);
+  double Z2[9 + 1][9 + 1];
+  Zero(&Z2[0][0], 100);
+  double BB[6 + 1];
+  Zero(&BB[0], 7);
+  double B[6 + 1];
+  Zero(&B[0], 7);
+  double EQM[3 + 1];
+  Zero(EQM, 4);
+  double EQQ1 = 0.0, EQQ2 = 0.0, EQQ3 = 0.0;
+  double RM0[3 + 1];
+  Zero(RM0, 4);
+  double RMT[3 + 1];
+  Zero(RMT, 4);
+  double RMERR[3 + 1];
+  Zero(RMERR, 4);
+  double EPS = 0.0;
+  double SAI22 = 0.0;
+  double SIG = 0.0;
+  double (*AA)[6 + 1] = WAA;
+  Zero(&AA[0][0], (N + 1) * 7);
+  double DUM = 0.0;
+  double (*H)[5 + 1] = WH;
+  Zero(&H[0][0], (N + 1) * 6);
+  double RMX = 0.0, RMY = 0.0, RMZ = 0.0;
+  double RMAG = 0.0;
+  double PEXPL[4], PCLVD[3 + 1], PDBCP[3 + 1];
+  double PEXPL_VAC[4], PCLVD_VAC[3 + 1], PDBCP_VAC[3 + 1];
+  double MAGN[4];
+
+  KERNEL();
 
   // Full moment tensor.
   if (REALLY) {
-    for (int i = 1; i <= 6; i++) {
-      for (int j = 1; j <= 6; j++) {
-        ATA[i][j] = 0.0;
-        for (int k = 1; k <= N; k++)
-          ATA[i][j] = ATA[i][j] + A[k][j] * A[k][i];
-      }
+    // Normal equations are solved without inverting ATA, unless they are
+    // (nearly) singular. An event session (session.h) gives its own
+    // solution instead.
+    if (GIVENL2) {
+      for (int i = 1; i <= 6; i++)
+        RM[i][1] = GIVENRM[i][1];
     }
-
-    for (int i = 1; i <= 6; i++) {
-      for (int j = 1; j <= 6; j++) {
-        Z1[i][j] = ATA[i][j];
+    else {
+      for (int i = 1; i <= 6; i++) {
+        for (int j = 1; j <= 6; j++) {
+          ATA[i][j] = 0.0;
+          for (int k = 1; k <= N; k++)
+            ATA[i][j] = ATA[i][j] + A[k][j] * A[k][i];
+        }
       }
-    }
 
-    INVMAT(Z1, Z2, 6);
-
-    for (int i = 1; i <= 6; i++) {
-      for (int j = 1; j <= 6; j++) {
-        ATAINV[i][j] = Z2[i][j];
+      for (int i = 1; i <= 6; i++) {
+        B[i] = 0.0;
+        for (int j = 1; j <= N; j++) {
+          B[i] = B[i] + A[j][i] * U[j] * USMT_UPSCALE;
+        }
       }
-    }
 
-    for (int i = 1; i <= 6; i++) {
-      B[i] = 0.0;
-      for (int j = 1; j <= N; j++) {
-        B[i] = B[i] + A[j][i] * U[j] * USMT_UPSCALE;
+      SymmetricSolver<6> NE6;
+      if (NE6.Factor(ATA)) {
+        NE6.Solve(B, BB);
+        for (int i = 1; i <= 6; i++)
+          RM[i][1] = BB[i];
       }
-    }
+      else {
+        for (int i = 1; i <= 6; i++) {
+          for (int j = 1; j <= 6; j++) {
+            Z1[i][j] = ATA[i][j];
+          }
+        }
 
-    for (int i = 1; i <= 6; i++) {
-      RM[i][1] = 0.0;
-      for (int j = 1; j <= 6; j++) {
-        RM[i][1] = RM[i][1] + ATAINV[i][j] * B[j];
+        INVMAT(Z1, Z2, 6);
+
+        for (int i = 1; i <= 6; i++) {
+          for (int j = 1; j <= 6; j++) {
+            ATAINV[i][j] = Z2[i][j];
+          }
+        }
+
+        for (int i = 1; i <= 6; i++) {
+          RM[i][1] = 0.0;
+          for (int j = 1; j <= 6; j++) {
+            RM[i][1] = RM[i][1] + ATAINV[i][j] * B[j];
+          }
+        }
       }
     }
 
@@ -1422,17 +1536,7 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
     EQQ1 = EQM[1];
     EQQ2 = EQM[2];
     EQQ3 = EQM[3];
-    EQM[1] = fabs(EQM[1]) * USMT_DOWNSCALE;
-    EQM[2] = fabs(EQM[2]) * USMT_DOWNSCALE;
-    EQM[3] = fabs(EQM[3]) * USMT_DOWNSCALE;
-    HELP1 = fabs(EQM[1] - EQM[2]);
-    HELP2 = fabs(EQM[1] - EQM[3]);
-    HELP3 = fabs(EQM[2] - EQM[3]);
-    EU = sqrt(0.5 * (EQM[1] * EQM[1] + EQM[2] * EQM[2] + EQM[3] * EQM[3]));
-    EC = amax1(HELP1, HELP2);
-    EC = amax1(EC, HELP3);
-    RMT[1] = amax1(EC, EU) * USMT_UPSCALE;
-    RM0[1] = amin1(EC, EU) * USMT_UPSCALE;
+    SCALARMOMENT(EQM, RM0[1], RMT[1]);
 
     // Covariance calculation.
     for (int i = 1; i <= N; i++) {
@@ -1519,39 +1623,53 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
   }
 
   // Solve equation HM=U for M:
-  for (int i = 1; i <= 5; i++) {
-    for (int j = 1; j <= 5; j++) {
-      ATA[i][j] = 0.0;
-      for (int k = 1; k <= N; k++)
-        ATA[i][j] = ATA[i][j] + H[k][j] * H[k][i];
-    }
+  if (GIVENL2) {
+    for (int i = 1; i <= 5; i++)
+      RM[i][2] = GIVENRM[i][2];
   }
-
-  for (int i = 1; i <= 5; i++) {
-    for (int j = 1; j <= 5; j++) {
-      Z1[i][j] = ATA[i][j];
+  else {
+    for (int i = 1; i <= 5; i++) {
+      for (int j = 1; j <= 5; j++) {
+        ATA[i][j] = 0.0;
+        for (int k = 1; k <= N; k++)
+          ATA[i][j] = ATA[i][j] + H[k][j] * H[k][i];
+      }
     }
-  }
 
-  INVMAT(Z1, Z2, 5);
-
-  for (int i = 1; i <= 5; i++) {
-    for (int j = 1; j <= 5; j++) {
-      ATAINV[i][j] = Z2[i][j];
+    for (int i = 1; i <= 5; i++) {
+      B[i] = 0.0;
+      for (int j = 1; j <= N; j++) {
+        B[i] = B[i] + H[j][i] * U[j] * USMT_UPSCALE;
+      }
     }
-  }
 
-  for (int i = 1; i <= 5; i++) {
-    B[i] = 0.0;
-    for (int j = 1; j <= N; j++) {
-      B[i] = B[i] + H[j][i] * U[j] * USMT_UPSCALE;
+    SymmetricSolver<5> NE5;
+    if (NE5.Factor(ATA)) {
+      NE5.Solve(B, BB);
+      for (int i = 1; i <= 5; i++)
+        RM[i][2] = BB[i];
     }
-  }
+    else {
+      for (int i = 1; i <= 5; i++) {
+        for (int j = 1; j <= 5; j++) {
+          Z1[i][j] = ATA[i][j];
+        }
+      }
+
+      INVMAT(Z1, Z2, 5);
 
-  for (int i = 1; i <= 5; i++) {
-    RM[i][2] = 0.0;
-    for (int j = 1; j <= 5; j++) {
-      RM[i][2] = RM[i][2] + ATAINV[i][j] * B[j];
+      for (int i = 1; i <= 5; i++) {
+        for (int j = 1; j <= 5; j++) {
+          ATAINV[i][j] = Z2[i][j];
+        }
+      }
+
+      for (int i = 1; i <= 5; i++) {
+        RM[i][2] = 0.0;
+        for (int j = 1; j <= 5; j++) {
+          RM[i][2] = RM[i][2] + ATAINV[i][j] * B[j];
+        }
+      }
     }
   }
 
@@ -1565,17 +1683,7 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
   EQQ1 = EQM[1];
   EQQ2 = EQM[2];
   EQQ3 = EQM[3];
-  EQM[1] = fabs(EQM[1]) * USMT_DOWNSCALE;
-  EQM[2] = fabs(EQM[2]) * USMT_DOWNSCALE;
-  EQM[3] = fabs(EQM[3]) * USMT_DOWNSCALE;
-  HELP1 = fabs(EQM[1] - EQM[2]);
-  HELP2 = fabs(EQM[1] - EQM[3]);
-  HELP3 = fabs(EQM[2] - EQM[3]);
-  EU = sqrt(0.5 * (EQM[1] * EQM[1] + EQM[2] * EQM[2] + EQM[3] * EQM[3]));
-  EC = amax1(HELP1, HELP2);
-  EC = amax1(EC, HELP3);
-  RMT[2] = amax1(EC, EU) * USMT_UPSCALE;
-  RM0[2] = amin1(EC, EU) * USMT_UPSCALE;
+  SCALARMOMENT(EQM, RM0[2], RMT[2]);
 
   for (int i = 1; i <= N; i++) {
     EPS = U[i];
@@ -1771,20 +1879,8 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
 #endif
 
   // Transfer data to output structure
-  for (int i = 1; i <= N; i++) {
-    Solution[1].U_n = N;
-    Solution[2].U_n = N;
-    Solution[3].U_n = N;
-    Solution[1].U_th[i - 1] = UTH[i][1];
-    Solution[2].U_th[i - 1] = UTH[i][2];
-    Solution[3].U_th[i - 1] = UTH[i][3];
-    Solution[1].U_measured[i - 1] = U[i];
-    Solution[2].U_measured[i - 1] = U[i];
-    Solution[3].U_measured[i - 1] = U[i];
-    Solution[1].Station[i - 1] = Station[i];
-    Solution[2].Station[i - 1] = Station[i];
-    Solution[3].Station[i - 1] = Station[i];
-  }
+  INFLUENCE();
+  CHANNELOUT(true);
 
   //std::ofstream file("file.txt",std::ofstream::out | std::ofstream::app);
   for (int q = 1; q <= 3; q++) {
@@ -1821,6 +1917,7 @@ void Taquart::UsmtCore::MOM2(bool REALLY, int QualityType) {
     Solution[i].CLVD_VAC = PCLVD_VAC[i];
     Solution[i].DBCP_VAC = PDBCP_VAC[i];
     Solution[i].MAGN = MAGN[i];
+    Solution[i].ROUNDS = 0;
 
     for (int m = 1; m <= 6; m++)
       for (int n = 1; n <= 6; n++)
@@ -2005,15 +2102,16 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
   Zero(VN, 4);
   double VE[3 + 1];
   Zero(VE, 4);
-  double AM0[FOCIMT_MAXCHANNEL + 1];
-  Zero(AM0, FOCIMT_MAXCHANNEL + 1);
+  double * AM0 = WAM0;
+  Zero(AM0, N + 1);
   double DD[6 + 1];
   Zero(DD, 7);
   double EQM[3 + 1];
   Zero(EQM, 4);
   double EC = 0.0;
-  double C[6 + 1][FOCIMT_MAXCHANNEL + 1];
-  Zero(&C[0][0], 7 * (FOCIMT_MAXCHANNEL + 1));
+  double * const * C = WC;
+  for (int i = 0; i <= 6; i++)
+    Zero(C[i], N + 1);
   double BB[8 + 1][8 + 1];
   Zero(&BB[0][0], 81);
   double BBINV[8 + 1][8 + 1];
@@ -2024,8 +2122,8 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
   Zero(&Z2[0][0], 100);
   double DE[3 + 1];
   Zero(DE, 4);
-  double DU[FOCIMT_MAXCHANNEL + 1];
-  Zero(DU, FOCIMT_MAXCHANNEL + 1);
+  double * DU = WDU;
+  Zero(DU, N + 1);
   double DN[3 + 1];
   Zero(DN, 4);
   double CTDU[8 + 1];
@@ -2141,17 +2239,24 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
     BB[i][8] = BB[8][i];
   }
 
-  for (int i = 1; i <= 8; i++) {
-    for (int j = 1; j <= 8; j++) {
-      Z1[i][j] = BB[i][j];
+  // BB does not change during the iteration: it is factored once and each
+  // iteration takes a solution with the factors. INVMAT is left for the
+  // (nearly) singular case.
+  SymmetricSolver<8> KKT;
+  const bool FACTORED = KKT.Factor(BB);
+  if (!FACTORED) {
+    for (int i = 1; i <= 8; i++) {
+      for (int j = 1; j <= 8; j++) {
+        Z1[i][j] = BB[i][j];
+      }
     }
-  }
 
-  INVMAT(Z1, Z2, 8);
+    INVMAT(Z1, Z2, 8);
 
-  for (int i = 1; i <= 8; i++) {
-    for (int j = 1; j <= 8; j++) {
-      BBINV[i][j] = Z2[i][j];
+    for (int i = 1; i <= 8; i++) {
+      for (int j = 1; j <= 8; j++) {
+        BBINV[i][j] = Z2[i][j];
+      }
     }
   }
 
@@ -2173,6 +2278,9 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
 
   double EPS = 1.0e-06;
   int ITER = 1;
+  double OMEGA = 1.0;
+  double STEP = 0.0;
+  double STEPPREV = 0.0;
 
   p3012: for (int i = 1; i <= N; i++) {
     DU[i] = 0.0;
@@ -2195,11 +2303,14 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
   CTDU[7] = 0.0;
   CTDU[8] = 0.0;
 
-  for (int i = 1; i <= 8; i++) {
-    X[i] = 0.0;
-    for (int j = 1; j <= 8; j++)
-      X[i] = X[i] + BBINV[i][j] * CTDU[j];
-  }
+  if (FACTORED)
+    KKT.Solve(CTDU, X);
+  else
+    for (int i = 1; i <= 8; i++) {
+      X[i] = 0.0;
+      for (int j = 1; j <= 8; j++)
+        X[i] = X[i] + BBINV[i][j] * CTDU[j];
+    }
 
   if (ITER == 1000)
     goto p3418;
@@ -2226,12 +2337,29 @@ void Taquart::UsmtCore::BETTER(double &RMY, double &RMZ, double &RM0,
   }
   goto p3017;
 
+  // Damped update: whenever the step grows instead of shrinking, only a
+  // fraction OMEGA of it is taken (halved down to 1/64). Converging
+  // iterations keep OMEGA = 1 and the original full update.
   p3014: DHELP1 = 0.0;
   DHELP2 = 0.0;
 
+  STEP = 0.0;
+  for (int i = 1; i <= 3; i++)
+    STEP = STEP + (X[i + 3] - DE[i]) * (X[i + 3] - DE[i])
+        + (X[i] - DN[i]) * (X[i] - DN[i]);
+  if (ITER > 1 && STEP > STEPPREV && OMEGA > 1.0 / 64.0)
+    OMEGA = 0.5 * OMEGA;
+  STEPPREV = STEP;
+
   for (int i = 1; i <= 3; i++) {
-    DE[i] = X[i + 3];
-    DN[i] = X[i];
+    if (OMEGA == 1.0) {
+      DE[i] = X[i + 3];
+      DN[i] = X[i];
+    }
+    else {
+      DE[i] = DE[i] + OMEGA * (X[i + 3] - DE[i]);
+      DN[i] = DN[i] + OMEGA * (X[i] - DN[i]);
+    }
     DHELP1 = DHELP1 + DE[i] * DE[i];
     DHELP2 = DHELP2 + DN[i] * DN[i];
   }
@@ -2465,16 +2593,9 @@ void Taquart::UsmtCore::ORT(double VE[], double VN[], double DE[],
 
 //-----------------------------------------------------------------------------
 bool Taquart::UsmtCore::ANGGA(void) {
-  const double DETOPI = 4.0 * atan(1.0) / 180.0;
   if (N >= FOCIMT_MIN_ALLOWED_CHANNELS) {
     for (int i = 1; i <= N; i++) {
-      double HELP = TKF[i];
-      if (HELP == 90.0)
-        HELP = 89.75; // Not clear why this constrain is here.
-      GA[i][3] = cos(HELP * DETOPI);
-      HELP = sqrt(1.0 - GA[i][3] * GA[i][3]);
-      GA[i][1] = cos(AZM[i] * DETOPI) * HELP;
-      GA[i][2] = sin(AZM[i] * DETOPI) * HELP;
+      RAYGA(AZM[i], TKF[i], GA[i]);
     }
     return true;
   }
@@ -2483,6 +2604,18 @@ bool Taquart::UsmtCore::ANGGA(void) {
   }
 }
 
+//-----------------------------------------------------------------------------
+void Taquart::UsmtCore::RAYGA(double Azimuth, double TakeOff, double G[]) {
+  const double DETOPI = 4.0 * atan(1.0) / 180.0;
+  double HELP = TakeOff;
+  if (HELP == 90.0)
+    HELP = 89.75; // Not clear why this constrain is here.
+  G[3] = cos(HELP * DETOPI);
+  HELP = sqrt(1.0 - G[3] * G[3]);
+  G[1] = cos(Azimuth * DETOPI) * HELP;
+  G[2] = sin(Azimuth * DETOPI) * HELP;
+}
+
 //-----------------------------------------------------------------------------
 bool Taquart::UsmtCore::JEZ(void) {
   //      SUBROUTINE JEZ(IOK)
@@ -2633,136 +2766,286 @@ void Taquart::UsmtCore::PROGRESS(double Progress, double Max) {
 }
 
 //-----------------------------------------------------------------------------
-void Taquart::UsmtCore::GSOL(double x[], int &iexp) {
-  //      subroutine gsol(x,iexp)
-  //      dimension x(6),ix(6)
-  //      double precision xlo(6),xhi(6),xstep(6),six,size,xtry(6),
-  //     $val,try
-  //      DATA six,METH/6.D+00,1/
-  int ix[6 + 1]; //dimension
-  double xlo[6 + 1];
-  Zero(xlo, 7);
-  double xhi[6 + 1];
-  Zero(xhi, 7);
-  double xstep[6 + 1];
-  Zero(xstep, 7);
-  double six = 6.0e+00;
-  double xtry[6 + 1];
-  double val = 0.0;
-  double tryy = 0.0;
-  //int METH = 1;
-  //double size = 0.0;
+namespace {
+  using namespace Taquart::UsmtCore;
+
+  //! Misfit of the full moment tensor (GSOL), six free parameters.
+  struct FullMisfit {
+      static const int NX = 6;
+      static const bool ABORT = false;
+      double xtry[6 + 1];
+      int Index[6 + 1];
+      int Prefix;
+      FullMisfit(void) :
+          Prefix(5) {
+        for (int i = 0; i <= 6; i++) {
+          xtry[i] = 0.0;
+          Index[i] = i;
+        }
+      }
+      void Round(void) {
+      }
+      template<class E> void Point(E &Engine, const double G[]) {
+        double tryy = 0.0;
+        F1INC(G, xtry[6], tryy);
+        Engine.Offer(tryy);
+      }
+  };
+
+  //! Misfit of the trace-null moment tensor (GSOL5), M33 = -M11 - M22.
+  struct TraceNullMisfit {
+      static const int NX = 5;
+      static const bool ABORT = false;
+      double xtry[5 + 1];
+      int Index[5 + 1];
+      int Prefix;
+      TraceNullMisfit(void) :
+          Prefix(4) {
+        for (int i = 0; i <= 5; i++) {
+          xtry[i] = 0.0;
+          Index[i] = i;
+        }
+      }
+      void Round(void) {
+      }
+      template<class E> void Point(E &Engine, const double G[]) {
+        double tryy = 0.0;
+        F2INC(G, 5, xtry, tryy);
+        Engine.Offer(tryy);
+      }
+  };
 
-  //      IF((IEXP.LT.10).OR.(IEXP.GT.30)) IEXP=20
-  if (iexp < 10 || iexp > 30)
-    iexp = 20;
+  //! Misfit of the double-couple (GSOLA). Four parameters are searched,
+  //! the fifth (element 6 - Pass of xtry) follows from det(M) = 0.
+  /*! xtry is shared by all five passes: the fifth pass sets xtry[2] twice
+   *  and never sets xtry[4], which keeps its value from the fourth pass.
+   */
+  struct DoubleCoupleMisfit {
+      static const int NX = 5;
+      static const bool ABORT = true;
+      double xtry[5 + 1];
+      int Index[4 + 1];
+      int Prefix;
+      int Pass;
+      DoubleCoupleMisfit(void) :
+          Prefix(0), Pass(0) {
+        for (int i = 0; i <= 5; i++)
+          xtry[i] = 0.0;
+        for (int i = 0; i <= 4; i++)
+          Index[i] = 0;
+      }
+      void SetPass(int APass) {
+        static const int Map[5 + 1][4 + 1] = { { 0, 0, 0, 0, 0 }, { 0, 1, 2,
+            3, 4 }, { 0, 1, 2, 3, 5 }, { 0, 1, 2, 4, 5 }, { 0, 1, 3, 4, 5 }, {
+            0, 2, 2, 3, 5 } };
+        Pass = APass;
+        for (int i = 1; i <= 4; i++)
+          Index[i] = Map[Pass][i];
+        // Grid levels below the solved element; their partial sums keep
+        // F2INC identical to f2.
+        Prefix = 5 - Pass;
+      }
+      void Round(void) {
+        xtry[6 - Pass] = 0.0;
+      }
+      template<class E> void Point(E &Engine, const double G[]) {
+        switch (Pass) {
+          case 1:
+            Pass1(Engine, G);
+            break;
+          case 2:
+            Pass2(Engine, G);
+            break;
+          case 3:
+            Pass3(Engine, G);
+            break;
+          case 4:
+            Pass4(Engine, G);
+            break;
+          case 5:
+            Pass5(Engine, G);
+            break;
+        }
+      }
 
-  //      iter=0
-  //      jter=1
-  //      val=1.d+30
-  int iter = 0;
-  //int jter = 1;
-  val = 1.0e+30;
-
-  //      do 1 i=1,6
-  //      xlo(i)=DBLE(-1.*10.**IEXP)
-  //      xhi(i)=DBLE(10.**IEXP)
-  //    1 ix(i)=0
-  for (int i = 1; i <= 6; i++) {
-    xlo[i] = -1.0 * pow(10.0, iexp);
-    xhi[i] = pow(10.0, iexp);
-    ix[i] = 0;
-  }
+    private:
+      //! Evaluates xtry[K] = Y * 1e10 and offers it to the engine.
+      template<class E> void Try(E &Engine, const double G[], int K,
+          double Y) {
+        double tryy = 0.0;
+        xtry[K] = Y * 1.0e+10;
+        F2INC(G, K, xtry, tryy);
+        Engine.Offer(tryy);
+      }
 
-  //      DO 8 L=1,50
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l, 350);
-    //      do 2 i=1,6
-    //    2 xstep(i)=(xhi(i)-xlo(i))/SIX
-    for (int i = 1; i <= 6; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / six;
+      //! Search for X1,X2,X3,X4; X5 is calculated.
+      template<class E> void Pass1(E &Engine, const double G[]) {
+        const double FOUR = 4.0, TWO = 2.0, ZERO = 0.0;
+        double y[5 + 1], DEL = 0.0;
+        if (fabs(xtry[1]) >= 1.0e-6) {
+          for (int i = 1; i <= 5; i++)
+            y[i] = xtry[i] * 1.0e-10;
+          DEL = pow(TWO * y[2] * y[3], 2.0)
+              + FOUR * y[1]
+                  * (y[4]
+                      * (-pow(y[1], 2.0) - y[1] * y[4] - pow(y[3], 2.0)
+                          + pow(y[2], 2.0)) + pow(y[2], 2.0) * y[1]);
+          if (DEL < ZERO)
+            return;
+          DEL = sqrt(DEL);
+          Try(Engine, G, 5, (TWO * y[2] * y[3] + DEL) / TWO / y[1]);
+          Try(Engine, G, 5, (TWO * y[2] * y[3] - DEL) / TWO / y[1]);
+          return;
+        }
+        if (fabs(xtry[2]) < 1.0e-6 || fabs(xtry[3]) < 1.0e-6)
+          return;
+        for (int i = 1; i <= 5; i++)
+          y[i] = xtry[i] * 1.0e-10;
+        DEL = y[4]
+            * (-pow(y[1], 2.0) - y[1] * y[4] - pow(y[3], 2.0)
+                + pow(y[2], 2.0)) + pow(y[2], 2.0) * y[1];
+        Try(Engine, G, 5, -DEL / TWO / y[3] / y[2]);
+      }
 
-    //      size=xhi(1)-xlo(1)
-    //      iter=iter+1
-    //size = xhi[1] - xlo[1];
-    iter = iter + 1;
+      //! Search for X1,X2,X3,X5; X4 is calculated.
+      template<class E> void Pass2(E &Engine, const double G[]) {
+        const double FOUR = 4.0, TWO = 2.0, ZERO = 0.0;
+        double y[5 + 1], DEL = 0.0, help = 0.0;
+        if (fabs(xtry[1]) >= 1.0e-06) {
+          for (int i = 1; i <= 5; i++)
+            y[i] = xtry[i] * 1.0e-10;
+          DEL = pow(-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0), 2.0)
+              + FOUR * y[1]
+                  * (TWO * y[2] * y[3] * y[5] - y[1] * pow(y[5], 2.0)
+                      + y[1] * pow(y[2], 2.0));
+          if (DEL < ZERO)
+            return;
+          DEL = sqrt(DEL);
+          Try(Engine, G, 4,
+              (-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0) + DEL) / TWO
+                  / y[1]);
+          Try(Engine, G, 4,
+              (-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0) - DEL) / TWO
+                  / y[1]);
+          return;
+        }
+        for (int i = 1; i <= 5; i++)
+          y[i] = xtry[i] * 1.0e-10;
+        help = -pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0);
+        if (fabs(help) < 1.0e-20)
+          return;
+        DEL = TWO * y[2] * y[3] * y[5] - y[5] * y[5] * y[1]
+            + y[2] * y[2] * y[1];
+        Try(Engine, G, 4, -DEL / help);
+      }
 
-    //      do 3 j1=1,7
-    for (int j1 = 1; j1 <= 7; j1++) {
-      //      xtry(1)=xlo(1)+DBLE(j1-1)*xstep(1)
-      //      CALL POSTEP(METH,JTER,J1)
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      //POSTEP(METH,jter,j1);
-
-      //      do 3 j2=1,7
-      for (int j2 = 1; j2 <= 7; j2++) {
-        //      xtry(2)=xlo(2)+DBLE(j2-1)*xstep(2)
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-
-        //      do 3 j3=1,7
-        for (int j3 = 1; j3 <= 7; j3++) {
-          //      xtry(3)=xlo(3)+DBLE(j3-1)*xstep(3)
-          xtry[3] = xlo[3] + double(j3 - 1) * xstep[3];
-
-          //      do 3 j4=1,7
-          for (int j4 = 1; j4 <= 7; j4++) {
-            //      xtry(4)=xlo(4)+DBLE(j4-1)*xstep(4)
-            xtry[4] = xlo[4] + double(j4 - 1) * xstep[4];
-
-            //      do 3 j5=1,7
-            for (int j5 = 1; j5 <= 7; j5++) {
-              //      xtry(5)=xlo(5)+DBLE(j5-1)*xstep(5)
-              xtry[5] = xlo[5] + double(j5 - 1) * xstep[5];
-
-              //      do 3 j6=1,7
-              for (int j6 = 1; j6 <= 7; j6++) {
-                //      xtry(6)=xlo(6)+DBLE(j6-1)*xstep(6)
-                xtry[6] = xlo[6] + double(j6 - 1) * xstep[6];
-                //      call f1(xtry,try)
-                f1(xtry, tryy);
-
-                //      if(try.gt.val) go to 3
-                if (tryy > val)
-                  continue;
-
-                //      val=try
-                //      ix(1)=j1
-                //      ix(2)=j2
-                //      ix(3)=j3
-                //      ix(4)=j4
-                //      ix(5)=j5
-                //      ix(6)=j6
-                val = tryy;
-                ix[1] = j1;
-                ix[2] = j2;
-                ix[3] = j3;
-                ix[4] = j4;
-                ix[5] = j5;
-                ix[6] = j6;
-
-                //      do 12 i=1,6
-                //   12 x(i)=SNGL(xtry(i))
-                for (int i = 1; i <= 6; i++)
-                  x[i] = xtry[i];
-              }
-            }
-          }
+      //! Search for X1,X2,X4,X5; X3 is calculated.
+      template<class E> void Pass3(E &Engine, const double G[]) {
+        const double FOUR = 4.0, TWO = 2.0, ZERO = 0.0;
+        double y[5 + 1], DEL = 0.0;
+        if (fabs(xtry[4]) >= 1.0e-06) {
+          for (int i = 1; i <= 5; i++)
+            y[i] = xtry[i] * 1.0e-10;
+          DEL = pow(TWO * y[2] * y[5], 2.0)
+              + FOUR * y[4]
+                  * (-y[1] * y[1] * y[4] - y[1] * y[4] * y[4]
+                      - y[5] * y[5] * y[1] + y[2] * y[2] * y[1]
+                      + y[2] * y[2] * y[4]);
+          if (DEL < ZERO)
+            return;
+          DEL = sqrt(DEL);
+          Try(Engine, G, 3, (TWO * y[2] * y[5] + DEL) / TWO / y[4]);
+          Try(Engine, G, 3, (TWO * y[2] * y[5] - DEL) / TWO / y[4]);
+          return;
         }
+        if (fabs(xtry[2]) < 1.0e-6 || fabs(xtry[5]) < 1.0e-06)
+          return;
+        for (int i = 1; i <= 5; i++)
+          y[i] = xtry[i] * 1.0e-10;
+        DEL = -y[1] * y[1] * y[4] - y[1] * y[4] * y[4] - y[5] * y[5] * y[1]
+            + y[2] * y[2] * (y[1] + y[4]);
+        Try(Engine, G, 3, -DEL / TWO / y[2] / y[5]);
       }
-    }
-    //    3 CONTINUE
 
-    //      DO 4 I=1,6
-    //      xhi(i)=xlo(i)+DBLE(ix(i)+1)*xstep(i)
-    //    4 xlo(i)=xlo(i)+DBLE(ix(i)-3)*xstep(i)
+      //! Search for X1,X3,X4,X5; X2 is calculated.
+      template<class E> void Pass4(E &Engine, const double G[]) {
+        const double FOUR = 4.0, TWO = 2.0, ZERO = 0.0;
+        double y[5 + 1], DEL = 0.0;
+        if (fabs(xtry[4] + xtry[1]) >= 1.0e-06) {
+          for (int i = 1; i <= 5; i++)
+            y[i] = xtry[i] * 1.0e-10;
+          DEL = pow(TWO * y[3] * y[5], 2.0)
+              - FOUR * (y[1] + y[4])
+                  * (-y[1] * y[1] * y[4] - y[1] * y[4] * y[4]
+                      - y[5] * y[5] * y[1] - y[3] * y[3] * y[4]);
+          if (DEL < ZERO)
+            return;
+          DEL = sqrt(DEL);
+          Try(Engine, G, 2, (-TWO * y[3] * y[5] - DEL) / TWO / (y[1] + y[4]));
+          Try(Engine, G, 2, (-TWO * y[3] * y[5] + DEL) / TWO / (y[1] + y[4]));
+          return;
+        }
+        if (fabs(xtry[3]) < 1.0e-06 || fabs(xtry[5]) < 1.0e-06)
+          return;
+        for (int i = 1; i <= 5; i++)
+          y[i] = xtry[i] * 1.0e-10;
+        DEL = -y[1] * y[1] * y[4] - y[1] * y[4] * y[4] - y[5] * y[5] * y[1]
+            - y[3] * y[3] * y[4];
+        Try(Engine, G, 2, -DEL / TWO / y[3] / y[5]);
+      }
+
+      //! Search for X2,X3,X5 (X4 as left by the previous pass); X1 is
+      //! calculated.
+      template<class E> void Pass5(E &Engine, const double G[]) {
+        const double FOUR = 4.0, TWO = 2.0, ZERO = 0.0;
+        double y[5 + 1], DEL = 0.0, help = 0.0;
+        if (fabs(xtry[4]) >= 1.0e-06) {
+          for (int i = 1; i <= 5; i++)
+            y[i] = xtry[i] * 1.0e-10;
+          DEL = pow(-y[4] * y[4] - y[5] * y[5] + y[2] * y[2], 2.0)
+              + FOUR * y[4]
+                  * (TWO * y[2] * y[3] * y[5] - y[4] * y[3] * y[3]
+                      + y[4] * y[2] * y[2]);
+          if (DEL < ZERO)
+            return;
+          DEL = sqrt(DEL);
+          Try(Engine, G, 1,
+              (-y[4] * y[4] - y[5] * y[5] + y[2] * y[2] + DEL) / TWO / y[4]);
+          Try(Engine, G, 1,
+              (-y[4] * y[4] - y[5] * y[5] + y[2] * y[2] - DEL) / TWO / y[4]);
+          return;
+        }
+        for (int i = 1; i <= 5; i++)
+          y[i] = xtry[i] * 1.0e-10;
+        help = -pow(y[4], 2.0) - pow(y[5], 2.0) + pow(y[2], 2.0);
+        if (fabs(help) < 1.0e-20)
+          return;
+        DEL = TWO * y[2] * y[3] * y[5] - y[3] * y[3] * y[4]
+            + y[2] * y[2] * y[4];
+        Try(Engine, G, 1, -DEL / help);
+      }
+  };
+}
+
+//-----------------------------------------------------------------------------
+int Taquart::UsmtCore::GSOL(double x[], int &iexp) {
+  //      subroutine gsol(x,iexp)
+  //      IF((IEXP.LT.10).OR.(IEXP.GT.30)) IEXP=20
+  if (iexp < 10 || iexp > 30)
+    iexp = 20;
+  FullMisfit F;
+  GridSearch<6, 7, 50, FullMisfit> Search(F);
+  if (WARMSTART) {
+    double c[6 + 1], r[6 + 1];
     for (int i = 1; i <= 6; i++) {
-      xhi[i] = xlo[i] + (ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + (ix[i] - 3) * xstep[i];
+      c[i] = WARMX[i][1];
+      r[i] = WARMR[i][1];
     }
+    Search.Run(x, iexp, 0, c, r);
   }
-  //    8 CONTINUE
-  //      return
-  //      end
+  else
+    Search.Run(x, iexp, 0);
+  return Search.Rounds();
 }
 
 //-----------------------------------------------------------------------------
@@ -2780,640 +3063,443 @@ void Taquart::UsmtCore::f1(double X[], double &fff) {
 }
 
 //-----------------------------------------------------------------------------
-void Taquart::UsmtCore::GSOL5(double x[], int &IEXP) {
-  //      subroutine gsol5(x,IEXP)
-  //      dimension x(5),ix(5)
-  //      double precision xlo(5),xhi(5),xstep(5),six,size,xtry(5),VAL,TRY
-  //      DATA SIX,METH/6.D+0,2/
-  double xlo[8], xhi[8], xstep[8], six = 6.0, xtry[8], VAL = 0.0, TRY = 0.0;
-  //int METH = 2;
-  int ix[7];
+//! Partial sums of A*x for the grid searches: G[i] = P[i] + A[i][K]*XK,
+//! or G[i] = A[i][K]*XK when P is null. Each loop level of GSOL, GSOL5 and
+//! GSOLA keeps its own G, so an inner candidate costs one column of A
+//! instead of the whole product.
+void Taquart::UsmtCore::PREFIX(double G[], const double P[], int K,
+    double XK) {
+  if (P)
+    for (int i = 1; i <= N; i++)
+      G[i] = P[i] + A[i][K] * XK;
+  else
+    for (int i = 1; i <= N; i++)
+      G[i] = A[i][K] * XK;
+}
+
+//-----------------------------------------------------------------------------
+//! Same as f1, with the sum of the first five columns taken from G
+//! (see PREFIX). The summation order of f1 is preserved.
+void Taquart::UsmtCore::F1INC(const double G[], double X6, double &fff) {
+  fff = 0.0;
+  for (int i = 1; i <= N; i++)
+    fff = fff + fabs(G[i] + A[i][6] * X6 - U[i]);
+  if (fabs(fff) > 1e+30)
+    fff = 1e+30;
+}
 
+//-----------------------------------------------------------------------------
+int Taquart::UsmtCore::GSOL5(double x[], int &IEXP) {
+  //      subroutine gsol5(x,IEXP)
   //      IF((IEXP.LT.10).OR.(IEXP.GT.30)) IEXP=20
-  //      iter=0
-  //      jter=1
-  //      val=1.d+30
   if (IEXP < 10 || IEXP > 30)
     IEXP = 20;
-  int iter = 0;
-  //int jter = 1;
-  VAL = 1.0e+30;
-
-  //      do 1 i=1,5
-  for (int i = 1; i <= 5; i++) {
-    //      xlo(i)=DBLE(-1.*10.**IEXP)
-    //      xhi(i)=DBLE(10.**IEXP)
-    xlo[i] = -1.0 * pow(10.0, double(IEXP));
-    xhi[i] = pow(10.0, double(IEXP));
-    ix[i] = 0;
-  }
-  //    1 ix(i)=0
-
-  //      DO 8 L=1,50
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 50, 350);
-
-    //      do 2 i=1,5
-    //    2 xstep(i)=(xhi(i)-xlo(i))/six
-    for (int i = 1; i <= 5; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / six;
-
-    //      size=xhi(1)-xlo(1)
-    //      iter=iter+1
-    //      do 3 j1=1,7
-    //size = xhi[1] - xlo[1];
-    iter = iter + 1;
-    for (int j1 = 1; j1 <= 7; j1++) {
-      //      xtry(1)=xlo(1)+DBLE(j1-1)*xstep(1)
-      //      CALL POSTEP(METH,JTER,J1)
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      //POSTEP(METH,jter,j1);
-
-      //      do 3 j2=1,7
-      for (int j2 = 1; j2 <= 7; j2++) {
-        //      xtry(2)=xlo(2)+DBLE(j2-1)*xstep(2)
-        //      do 3 j3=1,7
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          //      xtry(3)=xlo(3)+DBLE(j3-1)*xstep(3)
-          //      do 3 j4=1,7
-          xtry[3] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            //      xtry(4)=xlo(4)+DBLE(j4-1)*xstep(4)
-            //      do 3 j5=1,7
-            xtry[4] = xlo[4] + double(j4 - 1) * xstep[4];
-            for (int j5 = 1; j5 <= 7; j5++) {
-              //      xtry(5)=xlo(5)+DBLE(j5-1)*xstep(5)
-              //      call f2(xtry,try)
-              xtry[5] = xlo[5] + double(j5 - 1) * xstep[5];
-              f2(xtry, TRY);
-
-              //      if(try.gt.val) go to 3
-              if (TRY > VAL)
-                continue;
-
-              //      val=try
-              //      ix(1)=j1
-              //      ix(2)=j2
-              //      ix(3)=j3
-              //      ix(4)=j4
-              //      ix(5)=j5
-              //      do 12 i=1,5
-              //   12 x(i)=SNGL(Xtry(i))
-              VAL = TRY;
-              ix[1] = j1;
-              ix[2] = j2;
-              ix[3] = j3;
-              ix[4] = j4;
-              ix[5] = j5;
-              for (int i = 1; i <= 5; i++) {
-                x[i] = xtry[i];
-              }
-            }
-          }
-        }
-      }
-    }
-    //    3 CONTINUE
-    //      DO 4 I=1,5
-    //      xhi(i)=xlo(i)+DBLE(ix(i)+1)*xstep(i)
-    //    4 xlo(i)=xlo(i)+DBLE(ix(i)-3)*xstep(i)
+  TraceNullMisfit F;
+  GridSearch<5, 7, 50, TraceNullMisfit> Search(F);
+  if (WARMSTART) {
+    double c[5 + 1], r[5 + 1];
     for (int i = 1; i <= 5; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
+      c[i] = WARMX[i][2];
+      r[i] = WARMR[i][2];
     }
+    Search.Run(x, IEXP, 50, c, r);
   }
-  //    8 CONTINUE
-  //      return
-  //      end
+  else
+    Search.Run(x, IEXP, 50);
+  return Search.Rounds();
 }
 
 //-----------------------------------------------------------------------------
-void Taquart::UsmtCore::GSOLA(double x[], int &IEXP) {
+int Taquart::UsmtCore::GSOLA(double x[], int &IEXP) {
   //      subroutine gsola(x,IEXP)
-  //      double precision xlo(4),xhi(4),xstep(4),xtry(5),FOUR,SIZE,SIX,val,try,help,y(5),del,two,ZERO
-  //      dimension x(5),ix(4),xmem(5,5),vmem(5)
-  //      DATA TWO,FOUR,METH,SIX/2.D+0,4.D+0,3,6.D+0/
-
-  double xlo[4 + 1];
-  Zero(xlo, 5);
-  double xhi[4 + 1];
-  Zero(xhi, 5);
-  double xstep[4 + 1];
-  Zero(xstep, 5);
-  double xtry[5 + 1];
-  Zero(xtry, 6);
-  double FOUR = 4.0, SIX = 6.0, val = 0.0, tryy = 0.0;
-  double help, y[5 + 1], DEL = 0.0, TWO = 2.0;
-  int ix[4 + 1];
   double xmem[5 + 1][5 + 1], vmem[5 + 1];
   Zero(&xmem[0][0], 36);
   Zero(vmem, 6);
 
   if (IEXP < 10 || IEXP > 30)
     IEXP = 20;
-  double ZERO = 0.0;
-  int iter = 0;
-  for (int i = 1; i <= 5; i++) {
+  for (int i = 1; i <= 5; i++)
     vmem[i] = 1.0e+30;
-    for (int j = 1; j <= 5; j++)
-      xmem[i][j] = 0.0;
+
+  // Five passes, each with a different parameter calculated from the
+  // remaining four. A pass that finds no candidate is not stored.
+  DoubleCoupleMisfit F;
+  GridSearch<4, 7, 50, DoubleCoupleMisfit> Search(F);
+  int rounds = 0;
+  for (int pass = 1; pass <= 5; pass++) {
+    F.SetPass(pass);
+    bool found = Search.Run(x, IEXP, 50 + 50 * pass);
+    rounds += Search.Rounds();
+    if (!found)
+      continue;
+    for (int i = 1; i <= 5; i++)
+      xmem[pass][i] = x[i];
+    vmem[pass] = Search.Value();
   }
 
-  //C     Search for X1,X2,X3,X4; X5 is calculated:
-  val = 1e+30;
   for (int i = 1; i <= 4; i++) {
-    xlo[i] = -1.0 * pow(10.0, IEXP);
-    xhi[i] = pow(10.0, IEXP);
-    ix[i] = 0;
-  }
-
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 100, 350);
-    for (int i = 1; i <= 4; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / SIX;
-
-    iter++;
-    xtry[5] = 0.0;
-
-    for (int j1 = 1; j1 <= 7; j1++) {
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      for (int j2 = 1; j2 <= 7; j2++) {
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          xtry[3] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            xtry[4] = xlo[4] + double(j4 - 1) * xstep[4];
-            if (fabs(xtry[1]) < 1.0e-6)
-              goto p23;
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-            DEL = pow(TWO * y[2] * y[3], 2.0)
-                + FOUR * y[1]
-                    * (y[4]
-                        * (-pow(y[1], 2.0) - y[1] * y[4] - pow(y[3], 2.0)
-                            + pow(y[2], 2.0)) + pow(y[2], 2.0) * y[1]);
-            if (DEL < ZERO)
-              continue;
-            DEL = sqrt(DEL);
-            y[5] = (TWO * y[2] * y[3] + DEL) / TWO / y[1];
-            xtry[5] = y[5] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              goto p22;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-            for (int i = 1; i <= 5; i++)
-              x[i] = double(xtry[i]);
-            p22: y[5] = (TWO * y[2] * y[3] - DEL) / TWO / y[1];
-            xtry[5] = y[5] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-            for (int i = 1; i <= 5; i++)
-              x[i] = double(xtry[i]);
-            continue;
-            p23: if (fabs(xtry[2]) < 1.0e-6 || fabs(xtry[3]) < 1.0e-6)
-              continue;
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-            DEL = y[4]
-                * (-pow(y[1], 2.0) - y[1] * y[4] - pow(y[3], 2.0)
-                    + pow(y[2], 2.0)) + pow(y[2], 2.0) * y[1];
-            y[5] = -DEL / TWO / y[3] / y[2];
-            xtry[5] = y[5] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-            for (int i = 1; i <= 5; i++)
-              x[i] = double(xtry[i]);
-          }
-        }
-      }
-    }
-
-    if (val == 1e+30)
-      goto p30;
-    for (int i = 1; i <= 4; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
-    }
+    if (vmem[i] > vmem[5])
+      break;
+    vmem[5] = vmem[i];
+    for (int j = 1; j <= 5; j++)
+      x[j] = xmem[i][j];
   }
-  for (int i = 1; i <= 5; i++)
-    xmem[1][i] = x[i];
-  vmem[1] = val;
+  return rounds;
+}
 
-  //C     Search for X1,X2,X3,X5; X4 is calculated:
-  p30: val = 1.0e+30;
-  for (int i = 1; i <= 4; i++) {
-    xlo[i] = -1.0 * pow(10, IEXP);
-    xhi[i] = pow(10, IEXP);
-    ix[i] = 0;
-  }
-
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 150, 350);
-    for (int i = 1; i <= 4; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / SIX;
-
-    iter++;
-    xtry[4] = 0.0;
-
-    for (int j1 = 1; j1 <= 7; j1++) {
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      for (int j2 = 1; j2 <= 7; j2++) {
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          xtry[3] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            xtry[5] = xlo[4] + double(j4 - 1) * xstep[4];
-            if (fabs(xtry[1]) < 1.0e-06)
-              goto p123;
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-            DEL = pow(-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0), 2.0)
-                + FOUR * y[1]
-                    * (TWO * y[2] * y[3] * y[5] - y[1] * pow(y[5], 2.0)
-                        + y[1] * pow(y[2], 2.0));
-            if (DEL < ZERO)
-              continue;
-
-            DEL = sqrt(DEL);
-            y[4] = (-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0) + DEL)
-                / TWO / y[1];
-            xtry[4] = y[4] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-
-            y[4] = (-pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0) - DEL)
-                / TWO / y[1];
-
-            xtry[4] = y[4] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-
-            //      DO 125 i=1,5
-            //  125 x(i)=SNGL(xtry(i))
-            //      go to 103
-            for (int i = 1; i <= 5; i++)
-              x[i] = xtry[i];
-
-            continue; // TODO: It's not clear what is the side effects of this line, test!
-
-            p123: for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            help = -pow(y[1], 2.0) - pow(y[3], 2.0) + pow(y[2], 2.0);
-            if (fabs(help) < 1.0e-20)
-              continue;
-            DEL = TWO * y[2] * y[3] * y[5] - y[5] * y[5] * y[1]
-                + y[2] * y[2] * y[1];
-
-            y[4] = -DEL / help;
-            xtry[4] = y[4] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-          }
-        }
-      }
-    }
+//-----------------------------------------------------------------------------
+void Taquart::UsmtCore::f2(double x[], double &ffg) {
+  ffg = 0.0;
+  double SUM = 0.0;
+  for (int i = 1; i <= N; i++) {
+    SUM = 0.0;
+    for (int j = 1; j <= 5; j++)
+      SUM += (A[i][j] * x[j]);
+    SUM -= (A[i][6] * (x[1] + x[4]));
+    ffg += fabs(SUM - U[i]);
+  }
+  if (fabs(ffg) > 1.0e+30)
+    ffg = 1.0e+30;
+}
 
-    if (val == 1.0e+30)
-      goto p130;
-    for (int i = 1; i <= 4; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
-    }
+//-----------------------------------------------------------------------------
+//! Same as f2, with the sum of columns 1..K-1 taken from G (see PREFIX),
+//! or no partial sum when G is null. Columns K..5 are added in the order
+//! used by f2, so the result is identical.
+void Taquart::UsmtCore::F2INC(const double G[], int K, double x[],
+    double &ffg) {
+  ffg = 0.0;
+  double SUM = 0.0;
+  double S14 = x[1] + x[4];
+  for (int i = 1; i <= N; i++) {
+    SUM = G ? G[i] : 0.0;
+    for (int j = K; j <= 5; j++)
+      SUM += (A[i][j] * x[j]);
+    SUM -= (A[i][6] * S14);
+    ffg += fabs(SUM - U[i]);
   }
-  for (int i = 1; i <= 5; i++)
-    xmem[2][i] = x[i];
-  vmem[2] = val;
+  if (fabs(ffg) > 1.0e+30)
+    ffg = 1.0e+30;
+}
 
-  //C     Search for X1,X2,X4,X5; X3 is calculated:
-  p130: val = 1.0e+30;
+//-----------------------------------------------------------------------------
+//! Unit double-couple tensor for the given strike, dip and rake (degrees)
+//! in the A/GA frame (1 - north, 2 - east, 3 - down), see Aki & Richards
+//! (1980), Box 4.4. Only the five independent components d[1..5]
+//! (M11, M12, M13, M22, M23) are returned, M33 = -M11 - M22.
+void Taquart::UsmtCore::DCTENSOR(double Strike, double Dip, double Rake,
+    double d[]) {
+  const double DETOPI = 4.0 * atan(1.0) / 180.0;
+  const double sf = sin(Strike * DETOPI), cf = cos(Strike * DETOPI);
+  const double s2f = 2.0 * sf * cf, c2f = cf * cf - sf * sf;
+  const double sd = sin(Dip * DETOPI), cd = cos(Dip * DETOPI);
+  const double s2d = 2.0 * sd * cd, c2d = cd * cd - sd * sd;
+  const double sr = sin(Rake * DETOPI), cr = cos(Rake * DETOPI);
+  d[1] = -(sd * cr * s2f + s2d * sr * sf * sf);
+  d[2] = sd * cr * c2f + 0.5 * s2d * sr * s2f;
+  d[3] = -(cd * cr * cf + c2d * sr * sf);
+  d[4] = sd * cr * s2f - s2d * sr * cf * cf;
+  d[5] = -(cd * cr * sf - c2d * sr * cf);
+}
 
-  for (int i = 1; i <= 4; i++) {
-    xlo[i] = -1.0 * pow(10, IEXP);
-    xhi[i] = pow(10, IEXP);
-    ix[i] = 0;
-  }
-
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 200, 350);
-    for (int i = 1; i <= 4; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / SIX;
-
-    iter++;
-    xtry[3] = 0.0;
-    //POSTEP(METH,jter,j7);
-
-    for (int j1 = 1; j1 <= 7; j1++) {
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      for (int j2 = 1; j2 <= 7; j2++) {
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          xtry[4] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            xtry[5] = xlo[4] + double(j4 - 1) * xstep[4];
-            if (fabs(xtry[4]) < 1.0e-06)
-              goto p223;
-
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            DEL = pow(TWO * y[2] * y[5], 2.0)
-                + FOUR * y[4]
-                    * (-y[1] * y[1] * y[4] - y[1] * y[4] * y[4]
-                        - y[5] * y[5] * y[1] + y[2] * y[2] * y[1]
-                        + y[2] * y[2] * y[4]);
-
-            if (DEL < ZERO)
-              continue;
-
-            DEL = sqrt(DEL);
-            y[3] = (TWO * y[2] * y[5] + DEL) / TWO / y[4];
-            xtry[3] = y[3] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-
-            y[3] = (TWO * y[2] * y[5] - DEL) / TWO / y[4];
-
-            xtry[3] = y[3] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-
-            for (int i = 1; i <= 5; i++)
-              x[i] = xtry[i];
-            continue; // TODO: It's not clear what is the purpose of this line.
-
-            p223: if (fabs(xtry[2]) < 1.0e-6 || fabs(xtry[5]) < 1.0e-06)
-              continue;
-
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            DEL = -y[1] * y[1] * y[4] - y[1] * y[4] * y[4] - y[5] * y[5] * y[1]
-                + y[2] * y[2] * (y[1] + y[4]);
-
-            y[3] = -DEL / TWO / y[2] / y[5];
-            xtry[3] = y[3] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = double(xtry[i]);
-            }
-          }
-        }
-      }
+//-----------------------------------------------------------------------------
+//! L1 misfit of the double-couple with unit tensor d[1..5] (see DCTENSOR),
+//! from its radiation r = A*d (see DCFIT).
+double Taquart::UsmtCore::DCMISFIT(const double d[], double &M0) {
+  double * r = WR;
+  for (int i = 1; i <= N; i++)
+    r[i] = A[i][1] * d[1] + A[i][2] * d[2] + A[i][3] * d[3] + A[i][4] * d[4]
+        + A[i][5] * d[5] - A[i][6] * (d[1] + d[4]);
+  return DCFIT(r, M0);
+}
+
+//-----------------------------------------------------------------------------
+//! L1 misfit of a double-couple with radiation r[1..N] per unit moment.
+//! For a fixed orientation the amplitudes are linear in the scalar moment,
+//! so the best M0 (of either sign) is the weighted median of U[i]/r[i]
+//! with weights |r[i]|. Returns the misfit as in f2.
+double Taquart::UsmtCore::DCFIT(const double r[], double &M0) {
+  std::pair<double, double> * t = WT;
+  int n = 0;
+  double wsum = 0.0;
+  for (int i = 1; i <= N; i++) {
+    if (r[i] != 0.0) {
+      t[n] = std::make_pair(U[i] / r[i], fabs(r[i]));
+      wsum += t[n].second;
+      n++;
     }
+  }
 
-    if (val == 1.0e+30)
-      goto p230;
-    for (int i = 1; i <= 4; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
+  M0 = 0.0;
+  if (n > 0) {
+    std::sort(t, t + n);
+    double w = 0.0;
+    for (int k = 0; k < n; k++) {
+      w += t[k].second;
+      if (w >= 0.5 * wsum) {
+        M0 = t[k].first;
+        break;
+      }
     }
   }
 
-  for (int i = 1; i <= 5; i++)
-    xmem[3][i] = x[i];
-  vmem[3] = val;
+  double ffg = 0.0;
+  for (int i = 1; i <= N; i++)
+    ffg += fabs(M0 * r[i] - U[i]);
+  if (fabs(ffg) > 1.0e+30)
+    ffg = 1.0e+30;
+  return ffg;
+}
 
-  //C     Search for X1,X3,X4,X5; X2 is calculated:
+//-----------------------------------------------------------------------------
+//! Pattern search for GSOLDC. Starting from sdr[] (strike, dip, rake) with
+//! misfit f, tries the 26 neighbours of the 3x3x3 pattern rotated by R,
+//! moving to any improvement and halving the step when there is none.
+//! Returns the final misfit, sdr[] is updated.
+double Taquart::UsmtCore::DCSEARCH(double sdr[], double f, double step,
+    const double R[3][3]) {
+  double d[5 + 1], M0 = 0.0;
+  while (step > 1.0e-4) {
+    bool moved = false;
+    for (int c = 0; c < 27; c++) {
+      if (c == 13)
+        continue;
+      const double e[3] = { double(c / 9 - 1), double(c / 3 % 3 - 1),
+          double(c % 3 - 1) };
+      double t[3];
+      for (int j = 0; j < 3; j++)
+        t[j] = sdr[j] + step * (R[j][0] * e[0] + R[j][1] * e[1]
+            + R[j][2] * e[2]);
+      DCTENSOR(t[0], t[1], t[2], d);
+      double ft = DCMISFIT(d, M0);
+      if (ft < f) {
+        f = ft;
+        sdr[0] = t[0];
+        sdr[1] = t[1];
+        sdr[2] = t[2];
+        moved = true;
+      }
+    }
+    if (!moved)
+      step *= 0.5;
+  }
+  return f;
+}
 
-  p230: val = 1.0e+30;
-  for (int i = 1; i <= 4; i++) {
-    xlo[i] = -1.0 * pow(10, IEXP);
-    xhi[i] = pow(10, IEXP);
-    ix[i] = 0;
-  }
-
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 250, 350);
-    for (int i = 1; i <= 4; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / SIX;
-
-    iter++;
-    xtry[2] = 0.0;
-    //POSTEP(METH,jter,j7);
-
-    for (int j1 = 1; j1 <= 7; j1++) {
-      xtry[1] = xlo[1] + double(j1 - 1) * xstep[1];
-      for (int j2 = 1; j2 <= 7; j2++) {
-        xtry[3] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          xtry[4] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            xtry[5] = xlo[4] + double(j4 - 1) * xstep[4];
-            if (fabs(xtry[4] + xtry[1]) < 1.0e-06)
-              goto p323;
-
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            DEL = pow(TWO * y[3] * y[5], 2.0)
-                - FOUR * (y[1] + y[4])
-                    * (-y[1] * y[1] * y[4] - y[1] * y[4] * y[4]
-                        - y[5] * y[5] * y[1] - y[3] * y[3] * y[4]);
-
-            if (DEL < ZERO)
-              continue;
-
-            DEL = sqrt(DEL);
-            y[2] = (-TWO * y[3] * y[5] - DEL) / TWO / (y[1] + y[4]);
-            xtry[2] = y[2] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-
-            y[2] = (-TWO * y[3] * y[5] + DEL) / TWO / (y[1] + y[4]);
-            xtry[2] = y[2] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-
-            for (int i = 1; i <= 5; i++)
-              x[i] = xtry[i];
-            continue;
-
-            p323: if (fabs(xtry[3]) < 1.0e-06 || fabs(xtry[5]) < 1.0e-06)
-              continue;
-
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            DEL = -y[1] * y[1] * y[4] - y[1] * y[4] * y[4] - y[5] * y[5] * y[1]
-                - y[3] * y[3] * y[4];
-
-            y[2] = -DEL / TWO / y[3] / y[5];
-            xtry[2] = y[2] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-          }
+//-----------------------------------------------------------------------------
+//! Local refinement of the double couple sdr[] (strike, dip, rake) for
+//! GSOLDC. The amplitudes M0 * A*d are linearised in the three angles and
+//! in the relative change of M0; the L1 fit of this linear model is convex,
+//! unlike the misfit in the angles, and is found by iteratively reweighted
+//! least squares. The step (at most MAXSTEP degrees in each angle) is
+//! halved until the misfit decreases. Returns the misfit at the updated
+//! sdr[].
+double Taquart::UsmtCore::DCREFINE(double sdr[]) {
+  const int NOUTER = 30, NINNER = 60;
+  const double H = 1.0e-4, MAXSTEP = 2.0;
+  double d[5 + 1], dd[3][5 + 1], M0 = 0.0;
+  double * J = WRAD;
+  double * e = WR;
+  DCTENSOR(sdr[0], sdr[1], sdr[2], d);
+  double f = DCMISFIT(d, M0);
+  for (int outer = 0; outer < NOUTER && M0 != 0.0; outer++) {
+    for (int j = 0; j < 3; j++) {
+      double t[3] = { sdr[0], sdr[1], sdr[2] };
+      t[j] += H;
+      DCTENSOR(t[0], t[1], t[2], dd[j]);
+      for (int k = 1; k <= 5; k++)
+        dd[j][k] = (dd[j][k] - d[k]) / H;
+    }
+    double mean = 0.0;
+    for (int i = 1; i <= N; i++) {
+      const double a[5 + 1] = { 0.0, A[i][1] - A[i][6], A[i][2], A[i][3],
+          A[i][4] - A[i][6], A[i][5] };
+      double r = 0.0;
+      for (int k = 1; k <= 5; k++)
+        r += a[k] * d[k];
+      for (int j = 0; j < 3; j++) {
+        double s = 0.0;
+        for (int k = 1; k <= 5; k++)
+          s += a[k] * dd[j][k];
+        J[4 * i + j] = M0 * s;
+      }
+      J[4 * i + 3] = M0 * r;
+      e[i] = U[i] - M0 * r;
+      mean += fabs(e[i]) / N;
+    }
+
+    // L1 fit of the residuals e by J*dx.
+    double dx[4 + 1] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    const double eps = 1.0e-6 * mean;
+    for (int inner = 0; inner < NINNER; inner++) {
+      double NM[4 + 1][4 + 1], B[4 + 1];
+      Zero(&NM[0][0], 25);
+      Zero(B, 5);
+      for (int i = 1; i <= N; i++) {
+        const double * Ji = J + 4 * i - 1;
+        double res = e[i];
+        for (int p = 1; p <= 4; p++)
+          res -= Ji[p] * dx[p];
+        const double w = 1.0 / std::max(fabs(res), eps);
+        for (int p = 1; p <= 4; p++) {
+          B[p] += w * Ji[p] * e[i];
+          for (int q = 1; q <= p; q++)
+            NM[p][q] += w * Ji[p] * Ji[q];
         }
       }
+      SymmetricSolver<4> S;
+      if (!S.Factor(NM))
+        break;
+      S.Solve(B, dx);
     }
-    if (val == 1.0e+30)
-      goto p330;
-    for (int i = 1; i <= 4; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
+    double scale = 1.0;
+    for (int j = 1; j <= 3; j++)
+      if (fabs(dx[j]) * scale > MAXSTEP)
+        scale = MAXSTEP / fabs(dx[j]);
+
+    bool moved = false;
+    for (double s = scale; s > 1.0e-4 * scale; s *= 0.5) {
+      double t[3], dt[5 + 1], M0t = 0.0;
+      for (int j = 0; j < 3; j++)
+        t[j] = sdr[j] + s * dx[j + 1];
+      DCTENSOR(t[0], t[1], t[2], dt);
+      double ft = DCMISFIT(dt, M0t);
+      if (ft < f) {
+        moved = f - ft > 1.0e-12 * f;
+        f = ft;
+        M0 = M0t;
+        for (int j = 0; j < 3; j++)
+          sdr[j] = t[j];
+        for (int k = 1; k <= 5; k++)
+          d[k] = dt[k];
+        break;
+      }
     }
+    if (!moved)
+      break;
   }
-  for (int i = 1; i <= 5; i++)
-    xmem[4][i] = x[i];
-  vmem[4] = val;
+  return f;
+}
 
-  p330: val = 1.0e+30;
-  for (int i = 1; i <= 4; i++) {
-    xlo[i] = -1.0 * pow(10, IEXP);
-    xhi[i] = pow(10, IEXP);
-    ix[i] = 0;
-  }
-
-  for (int l = 1; l <= 50; l++) {
-    PROGRESS(l + 300, 350);
-    for (int i = 1; i <= 4; i++)
-      xstep[i] = (xhi[i] - xlo[i]) / SIX;
-
-    iter++;
-    xtry[1] = 0.0; /* Corrected 2006.10.05 */
-
-    for (int j1 = 1; j1 <= 7; j1++) {
-      xtry[2] = xlo[1] + double(j1 - 1) * xstep[1];
-      for (int j2 = 1; j2 <= 7; j2++) {
-        xtry[2] = xlo[2] + double(j2 - 1) * xstep[2];
-        for (int j3 = 1; j3 <= 7; j3++) {
-          xtry[3] = xlo[3] + double(j3 - 1) * xstep[3];
-          for (int j4 = 1; j4 <= 7; j4++) {
-            xtry[5] = xlo[4] + double(j4 - 1) * xstep[4];
-
-            if (fabs(xtry[4]) < 1.0e-06)
-              goto p423;
-
-            for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            DEL = pow(-y[4] * y[4] - y[5] * y[5] + y[2] * y[2], 2.0)
-                + FOUR * y[4]
-                    * (TWO * y[2] * y[3] * y[5] - y[4] * y[3] * y[3]
-                        + y[4] * y[2] * y[2]);
-
-            if (DEL < ZERO)
-              continue;
-
-            DEL = sqrt(DEL);
-            y[1] = (-y[4] * y[4] - y[5] * y[5] + y[2] * y[2] + DEL) / TWO
-                / y[4];
-            xtry[1] = y[1] * 1.0e+10;
-            f2(xtry, tryy);
-
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-
-            y[1] = (-y[4] * y[4] - y[5] * y[5] + y[2] * y[2] - DEL) / TWO
-                / y[4];
-
-            xtry[1] = y[1] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy > val)
-              continue;
-            RENUM(tryy, val, ix, j1, j2, j3, j4);
-
-            for (int i = 1; i <= 5; i++)
-              x[i] = xtry[i];
-            continue;
-            p423: for (int i = 1; i <= 5; i++)
-              y[i] = xtry[i] * 1.0e-10;
-
-            help = -pow(y[4], 2.0) - pow(y[5], 2.0) + pow(y[2], 2.0);
-            if (fabs(help) < 1.0e-20)
-              continue;
-            DEL = TWO * y[2] * y[3] * y[5] - y[3] * y[3] * y[4]
-                + y[2] * y[2] * y[4];
-
-            y[1] = -DEL / help;
-            xtry[1] = y[1] * 1.0e+10;
-            f2(xtry, tryy);
-            if (tryy <= val) {
-              RENUM(tryy, val, ix, j1, j2, j3, j4);
-              for (int i = 1; i <= 5; i++)
-                x[i] = xtry[i];
-            }
-          }
+//-----------------------------------------------------------------------------
+namespace {
+  //! Unit double couples on the coarse grid of GSOLDC (strike, dip and rake
+  //! in steps of STEP degrees; rake in [-90, 90) since the sign of M0 is
+  //! free).
+  struct DCGrid {
+      static const int NSTRIKE = 36, NDIP = 10, NRAKE = 18;
+      static const int NODES = NSTRIKE * NDIP * NRAKE;
+      double SDR[NODES][3];
+      double D[NODES][5 + 1];
+
+      DCGrid(void) {
+        const double STEP = 10.0;
+        for (int k = 0; k < NODES; k++) {
+          SDR[k][0] = (k / (NDIP * NRAKE)) * STEP;
+          SDR[k][1] = (k / NRAKE % NDIP) * STEP;
+          SDR[k][2] = -90.0 + (k % NRAKE) * STEP;
+          Taquart::UsmtCore::DCTENSOR(SDR[k][0], SDR[k][1], SDR[k][2], D[k]);
         }
       }
-    }
+  };
 
-    if (val == 1.0e+30)
-      goto p430;
-    for (int i = 1; i <= 4; i++) {
-      xhi[i] = xlo[i] + double(ix[i] + 1) * xstep[i];
-      xlo[i] = xlo[i] + double(ix[i] - 3) * xstep[i];
-    }
-  }
-  for (int i = 1; i <= 5; i++)
-    xmem[5][i] = x[i];
-  vmem[5] = val;
+  //! The grid, built during static initialization so that concurrent
+  //! inversions only read it.
+  const DCGrid Grid;
+}
 
-  p430: for (int i = 1; i <= 4; i++) {
-    if (vmem[i] > vmem[5])
-      break;
-    vmem[5] = vmem[i];
-    for (int j = 1; j <= 5; j++)
-      x[j] = xmem[i][j];
+//-----------------------------------------------------------------------------
+//! Misfits of the double couples D[0..Nodes-1] (unit tensors, orientations
+//! SDR) for GSOLDC. The radiation table r = A*D of all channels is computed
+//! as a blocked matrix product, DCBLOCK nodes at a time. The NBEST best
+//! nodes are kept in Best[] (ascending) and BestSDR[].
+void Taquart::UsmtCore::DCSCAN(const double SDR[][3], const double D[][5 + 1],
+    int Nodes, double Best[], double BestSDR[][3], int NBEST) {
+  const size_t n = NCAP + 1;
+  double M0 = 0.0;
+  for (int k0 = 0; k0 < Nodes; k0 += DCBLOCK) {
+    const int nb = std::min(DCBLOCK, Nodes - k0);
+    for (int i = 1; i <= N; i++) {
+      // M33 = -M11 - M22.
+      const double a1 = A[i][1] - A[i][6], a2 = A[i][2], a3 = A[i][3], a4 =
+          A[i][4] - A[i][6], a5 = A[i][5];
+      for (int b = 0; b < nb; b++) {
+        const double * p = D[k0 + b];
+        WRAD[b * n + i] = a1 * p[1] + a2 * p[2] + a3 * p[3] + a4 * p[4]
+            + a5 * p[5];
+      }
+    }
+    for (int b = 0; b < nb; b++) {
+      double f = DCFIT(WRAD + b * n, M0);
+      if (f >= Best[NBEST - 1])
+        continue;
+      int m = NBEST - 1;
+      for (; m > 0 && Best[m - 1] > f; m--) {
+        Best[m] = Best[m - 1];
+        for (int j = 0; j < 3; j++)
+          BestSDR[m][j] = BestSDR[m - 1][j];
+      }
+      Best[m] = f;
+      for (int j = 0; j < 3; j++)
+        BestSDR[m][j] = SDR[k0 + b][j];
+    }
   }
 }
 
 //-----------------------------------------------------------------------------
-void Taquart::UsmtCore::f2(double x[], double &ffg) {
-  ffg = 0.0;
-  double SUM = 0.0;
-  for (int i = 1; i <= N; i++) {
-    SUM = 0.0;
-    for (int j = 1; j <= 5; j++)
-      SUM += (A[i][j] * x[j]);
-    SUM -= (A[i][6] * (x[1] + x[4]));
-    ffg += fabs(SUM - U[i]);
+//! Double-couple L1 solution searched in strike, dip and rake (DCSDR, -gd),
+//! with the misfit and output layout x[1..5] of GSOLA.
+//! The coarse global grid (DCGrid) is evaluated through its radiation table
+//! (DCSCAN). Each of the NSTART best nodes is refined by DCREFINE twice,
+//! from the node itself and from the minimum of a pattern search
+//! (DCSEARCH) started there, as the misfit has many shallow local minima
+//! and the two paths often end in different ones. The lowest misfit found
+//! is returned in x[]. Returns the number of refinements.
+int Taquart::UsmtCore::GSOLDC(double x[], int &IEXP) {
+  const int NSTART = 8;
+  const double STEP = 10.0;
+
+  if (IEXP < 10 || IEXP > 30)
+    IEXP = 20;
+  PROGRESS(101, 350);
+
+  // Coarse grid, keeping the NSTART best nodes.
+  double best[NSTART], bestsdr[NSTART][3];
+  for (int k = 0; k < NSTART; k++)
+    best[k] = 2.0e+30;
+  DCSCAN(Grid.SDR, Grid.D, DCGrid::NODES, best, bestsdr, NSTART);
+  PROGRESS(200, 350);
+
+  // Local refinement of every starting node.
+  const double I[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0,
+      1.0 } };
+  double val = 1.0e+30, sdr[3] = { 0.0, 0.0, 0.0 };
+  int refined = 0;
+  for (int k = 0; k < NSTART && best[k] < 2.0e+30; k++) {
+    double t[2][3];
+    for (int p = 0; p < 2; p++)
+      for (int j = 0; j < 3; j++)
+        t[p][j] = bestsdr[k][j];
+    DCSEARCH(t[1], best[k], 0.5 * STEP, I);
+    for (int p = 0; p < 2; p++, refined++) {
+      double f = DCREFINE(t[p]);
+      if (f < val) {
+        val = f;
+        sdr[0] = t[p][0];
+        sdr[1] = t[p][1];
+        sdr[2] = t[p][2];
+      }
+    }
+    PROGRESS(200 + 150 * (k + 1) / NSTART, 350);
   }
-  if (fabs(ffg) > 1.0e+30)
-    ffg = 1.0e+30;
+
+  double d[5 + 1], M0 = 0.0;
+  DCTENSOR(sdr[0], sdr[1], sdr[2], d);
+  DCMISFIT(d, M0);
+  for (int i = 1; i <= 5; i++)
+    x[i] = M0 * d[i];
+  PROGRESS(350, 350);
+  return refined;
 }
 
 //-----------------------------------------------------------------------------
@@ -3492,9 +3578,180 @@ void Taquart::UsmtCore::RENUM(double &TRY, double &VAL, int ix[], int &j1,
   ix[4] = j4;
 }
 
+//-----------------------------------------------------------------------------
+//! Makes room for NMAX channels in the channel arrays. The workspace is
+//! kept between events and only reallocated (to at least twice its size)
+//! when an event has more channels than any before it.
+void Taquart::UsmtCore::CHANNELS(int NMAX) {
+  if (NMAX <= NCAP && Workspace.size() > 0)
+    return;
+  int Cap = NCAP > 0 ? NCAP : 32;
+  while (Cap < NMAX)
+    Cap *= 2;
+  std::vector<char>().swap(Workspace);
+  Workspace.resize(Layout(0, Cap) + CacheLine);
+  size_t Skew = size_t(&Workspace[0]) % CacheLine;
+  Layout(&Workspace[0] + (Skew ? CacheLine - Skew : 0), Cap);
+  Station.resize(Cap + 1);
+  NCAP = Cap;
+}
+
+//-----------------------------------------------------------------------------
+//! Leverage LEV (diagonal of the hat matrix) and Cook's distance COOK of
+//! each channel in the three solutions of MOM2, from the kernel rows A.
+//! The double-couple solution is constrained by det(M) = 0, so its hat
+//! matrix is that of the trace-null equations restricted to the tangent of
+//! the constraint at RM(.,3) (approximate, as BETTER is a linearised fit).
+//! Cook's distance is the shift of the solution when the channel is left
+//! out, in units of its covariance; exact for the full and trace-null
+//! solutions.
+void Taquart::UsmtCore::INFLUENCE(void) {
+  if (!RESIDUALS)
+    return;
+  const int NP[3 + 1] = { 0, 6, 5, 4 };
+  double ATA[6 + 1][6 + 1];
+  double X[6 + 1];
+  double HR[5 + 1];
+
+  // Normal equations of the full and trace-null solutions.
+  SymmetricSolver<6> NE6;
+  SymmetricSolver<5> NE5;
+  Zero(&ATA[0][0], 49);
+  for (int k = 1; k <= N; k++)
+    for (int i = 1; i <= 6; i++)
+      for (int j = 1; j <= 6; j++)
+        ATA[i][j] = ATA[i][j] + A[k][i] * A[k][j];
+  bool FULL = NE6.Factor(ATA);
+  Zero(&ATA[0][0], 49);
+  for (int k = 1; k <= N; k++) {
+    HR[1] = A[k][1] - A[k][6];
+    HR[2] = A[k][2];
+    HR[3] = A[k][3];
+    HR[4] = A[k][4] - A[k][6];
+    HR[5] = A[k][5];
+    for (int i = 1; i <= 5; i++)
+      for (int j = 1; j <= 5; j++)
+        ATA[i][j] = ATA[i][j] + HR[i] * HR[j];
+  }
+  bool DEV = NE5.Factor(ATA);
+
+  // Gradient G of det(M) of the double-couple solution in the trace-null
+  // parameters M11, M12, M13, M22, M23 (cofactors of M).
+  double Q[6 + 1], G[5 + 1], GNG = 0.0;
+  for (int i = 1; i <= 6; i++)
+    Q[i] = RM[i][3];
+  const double C11 = Q[4] * Q[6] - Q[5] * Q[5];
+  const double C22 = Q[1] * Q[6] - Q[3] * Q[3];
+  const double C33 = Q[1] * Q[4] - Q[2] * Q[2];
+  G[1] = C11 - C33;
+  G[2] = 2.0 * (Q[3] * Q[5] - Q[2] * Q[6]);
+  G[3] = 2.0 * (Q[2] * Q[5] - Q[3] * Q[4]);
+  G[4] = C22 - C33;
+  G[5] = 2.0 * (Q[2] * Q[3] - Q[1] * Q[5]);
+  if (DEV) {
+    NE5.Solve(G, X);
+    for (int i = 1; i <= 5; i++)
+      GNG = GNG + G[i] * X[i];
+  }
+
+  for (int k = 1; k <= N; k++) {
+    LEV[k][1] = LEV[k][2] = LEV[k][3] = 0.0;
+    if (FULL) {
+      NE6.Solve(A[k], X);
+      for (int i = 1; i <= 6; i++)
+        LEV[k][1] = LEV[k][1] + A[k][i] * X[i];
+    }
+    if (DEV) {
+      HR[1] = A[k][1] - A[k][6];
+      HR[2] = A[k][2];
+      HR[3] = A[k][3];
+      HR[4] = A[k][4] - A[k][6];
+      HR[5] = A[k][5];
+      NE5.Solve(HR, X);
+      double GX = 0.0;
+      for (int i = 1; i <= 5; i++) {
+        LEV[k][2] = LEV[k][2] + HR[i] * X[i];
+        GX = GX + G[i] * X[i];
+      }
+      LEV[k][3] = LEV[k][2];
+      if (GNG > 0.0)
+        LEV[k][3] = LEV[k][3] - GX * GX / GNG;
+    }
+  }
+
+  // Cook's distance from the residuals and the leverage.
+  for (int q = 1; q <= 3; q++) {
+    double S2 = 0.0;
+    for (int k = 1; k <= N; k++)
+      S2 = S2 + (U[k] - UTH[k][q]) * (U[k] - UTH[k][q]);
+    if (N > NP[q])
+      S2 = S2 / double(N - NP[q]);
+    for (int k = 1; k <= N; k++) {
+      const double EPS = U[k] - UTH[k][q];
+      const double H = LEV[k][q];
+      COOK[k][q] = 0.0;
+      if (S2 > 0.0 && H < 1.0)
+        COOK[k][q] = EPS * EPS * H / (NP[q] * S2 * (1.0 - H) * (1.0 - H));
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+//! Stores the measured and theoretical amplitudes (with the leverage and
+//! Cook's distance of INFLUENCE if Influence is set) in the three solutions,
+//! if RESIDUALS is set. Station names are taken from NAMES when all keys of
+//! the channels point to their names there, otherwise a table of the
+//! current channels is made.
+void Taquart::UsmtCore::CHANNELOUT(bool Influence) {
+  for (int q = 1; q <= 3; q++) {
+    Solution[q].Amplitudes.reset();
+    Solution[q].Column = q - 1;
+    Solution[q].U_n = RESIDUALS ? N : 0;
+  }
+  if (!RESIDUALS)
+    return;
+
+  std::shared_ptr<Taquart::ChannelAmplitudes> c =
+      std::make_shared<Taquart::ChannelAmplitudes>();
+  c->Station.resize(N);
+  c->Measured.resize(N);
+  for (int q = 0; q < 3; q++) {
+    c->Theoretical[q].resize(N);
+    if (Influence) {
+      c->Leverage[q].resize(N);
+      c->Cook[q].resize(N);
+    }
+  }
+  bool Shared = NAMES.get() != 0;
+  for (int i = 1; i <= N; i++) {
+    c->Station[i - 1] = KEY[i];
+    c->Measured[i - 1] = U[i];
+    for (int q = 0; q < 3; q++) {
+      c->Theoretical[q][i - 1] = UTH[i][q + 1];
+      if (Influence) {
+        c->Leverage[q][i - 1] = LEV[i][q + 1];
+        c->Cook[q][i - 1] = COOK[i][q + 1];
+      }
+    }
+    Shared = Shared && KEY[i] >= 0 && KEY[i] < int(NAMES->size())
+        && (*NAMES)[KEY[i]] == Station[i];
+  }
+  if (Shared)
+    c->Names = NAMES;
+  else {
+    c->Names = std::make_shared<std::vector<Taquart::String> >(
+        Station.begin() + 1, Station.begin() + N + 1);
+    for (int i = 0; i < N; i++)
+      c->Station[i] = i;
+  }
+  for (int q = 1; q <= 3; q++)
+    Solution[q].Amplitudes = c;
+}
+
 //-----------------------------------------------------------------------------
 void Taquart::UsmtCore::RDINP(Taquart::SMTInputData &InputData) {
   N = InputData.Count();
+  CHANNELS(N);
   TROZ = InputData.GetRuptureTime();
   Taquart::SMTInputLine InputLine;
   for (int i = 1; i <= N; i++) {
@@ -3511,6 +3768,7 @@ void Taquart::UsmtCore::RDINP(Taquart::SMTInputData &InputData) {
     VEL[i] = InputLine.Velocity;
     R[i] = InputLine.Distance;
     Station[i] = InputLine.Name;
+    KEY[i] = InputLine.Key;
     //ACTIV[i] = 1;
   }
 }
@@ -3526,4 +3784,29 @@ void Taquart::UsmtCore::SIZEMM(int &IEXP) {
 }
 
 //-----------------------------------------------------------------------------
+//! Sets the warm start of the L1 searches from the reference solutions
+//! Start (or switches it off if Start is null or WSRADIUS is 0). The radius
+//! of the box is WSRADIUS times the error of the reference solution (ERR,
+//! derived from its covariance), but not less than 0.1% of the largest
+//! tensor element.
+void Taquart::UsmtCore::WARMSET(const Taquart::FaultSolutions * Start) {
+  WARMSTART = Start != 0 && WSRADIUS > 0.0;
+  if (!WARMSTART)
+    return;
+  const Taquart::FaultSolution * s[3 + 1] = { 0, &Start->FullSolution,
+      &Start->TraceNullSolution, &Start->DoubleCoupleSolution };
+  const int m[6 + 1] = { 0, 1, 1, 1, 2, 2, 3 };
+  const int n[6 + 1] = { 0, 1, 2, 3, 2, 3, 3 };
+  for (int q = 1; q <= 3; q++) {
+    double X = 0.0;
+    for (int i = 1; i <= 6; i++) {
+      WARMX[i][q] = s[q]->M[m[i]][n[i]];
+      X = amax1(X, fabs(WARMX[i][q]));
+    }
+    for (int i = 1; i <= 6; i++)
+      WARMR[i][q] = amax1(WSRADIUS * s[q]->ERR, 1.0e-3 * X);
+  }
+}
+
+//-----------------------------------------------------------------------------
 
@@ -51,6 +51,10 @@
 //   1.1.0 Initial release for version 2.1.8 of Foci.
 //---------------------------------------------------------------------------
 
+// Scaling of the amplitudes in the normal equations.
+#define USMT_UPSCALE (1.0e+12)
+#define USMT_DOWNSCALE (1.0e-12)
+
 // Additional debug information to standard output (switched off).
 #undef USMTCORE_DEBUG
 
@@ -60,7 +64,8 @@
 #endif
 
 void USMTCore(Taquart::NormType ANormType, int QualityType,
-    Taquart::SMTInputData &InputData);
+    Taquart::SMTInputData &InputData,
+    const Taquart::FaultSolutions * Start = 0);
 
 void TransferSolution(Taquart::SolutionType AType,
     std::list<Taquart::FaultSolution> &ASolution);
@@ -73,20 +78,30 @@ Taquart::FaultSolution TransferSolution(Taquart::SolutionType AType);
 namespace Taquart {
   namespace UsmtCore {
     extern int NDAE[10];
+    // Channel arrays (indexed 1..N) live in a single workspace sized by
+    // CHANNELS, which keeps it between events and grows it when needed.
+    extern int NCAP; //!< Channel capacity of the workspace.
     //extern char PS[FOCIMT_MAXCHANNEL+1];
-    extern double U[FOCIMT_MAXCHANNEL + 1];
+    extern double * U;
     //extern double ARR[FOCIMT_MAXCHANNEL+1];
-    extern double AZM[FOCIMT_MAXCHANNEL + 1];
-    extern double TKF[FOCIMT_MAXCHANNEL + 1];
-    extern double GA[FOCIMT_MAXCHANNEL + 1][3 + 1];
-    extern double A[FOCIMT_MAXCHANNEL + 1][6 + 1];
-    extern double FIJ[3 + 1][3 + 1][FOCIMT_MAXCHANNEL + 1];
+    extern double * AZM;
+    extern double * TKF;
+    extern double (*GA)[3 + 1];
+    extern double (*A)[6 + 1];
+    extern double * FIJ[3 + 1][3 + 1];
     extern double RM[6 + 1][3 + 1];
     extern double COV[6 + 1][6 + 1][3 + 1];
-    extern int RO[FOCIMT_MAXCHANNEL + 1];
-    extern int VEL[FOCIMT_MAXCHANNEL + 1];
-    extern int R[FOCIMT_MAXCHANNEL + 1];
-    extern double UTH[FOCIMT_MAXCHANNEL + 1][3 + 1];
+    extern int * RO;
+    extern int * VEL;
+    extern int * R;
+    extern double (*UTH)[3 + 1];
+    extern double (*LEV)[3 + 1]; //!< Leverage of channels (see INFLUENCE).
+    extern double (*COOK)[3 + 1]; //!< Cook's distance of channels.
+    extern double * GSPREFIX[6 + 1]; //!< Prefix sums of the grid searches.
+    extern int * KEY; //!< Input line keys (SMTInputLine::Key) of channels.
+    extern bool RESIDUALS; //!< Solutions keep their channel amplitudes.
+    //! Station names of the event indexed by KEY (optional, see CHANNELOUT).
+    extern std::shared_ptr<const std::vector<Taquart::String> > NAMES;
     extern int N;
     extern double TROZ;
     extern double QSD;
@@ -99,30 +114,65 @@ namespace Taquart {
     //extern int ACTIV[FOCIMT_MAXCHANNEL+1];
     //extern char RPSTCP[FOCIMT_MAXCHANNEL+1];
     extern int ISTA;
+    extern double GSTOLX; //!< Relative box size at which grid searches stop.
+    extern double GSTOLF; //!< Relative misfit improvement below which they stop.
+    extern int GSCOARSE; //!< Number of initial rounds on the coarse grid.
+    extern bool DCSDR; //!< L1 double-couple from GSOLDC instead of GSOLA.
+    extern double WSRADIUS; //!< Warm start radius, in reference errors (0 - off).
+    extern bool WARMSTART; //!< L1 searches start around WARMX.
+    extern double WARMX[6 + 1][3 + 1]; //!< Warm start tensors (as RM).
+    extern double WARMR[6 + 1][3 + 1]; //!< Warm start radii (as RM).
+    extern bool GIVENL2; //!< MOM2 takes the L2 solutions from GIVENRM.
+    extern double GIVENRM[6 + 1][2 + 1]; //!< Full and trace-null L2 tensors (as RM).
     //extern int * ThreadProgress;
 
     void PROGRESS(double Progress, double Max);
     bool ANGGA(void);
+    //! Direction cosines G[1..3] of a ray leaving at Azimuth and TakeOff [deg].
+    void RAYGA(double Azimuth, double TakeOff, double G[]);
     bool JEZ(void);
     void MOM1(int &IEXP, int QualityType);
-    void GSOL(double x[], int &iexp);
+    int GSOL(double x[], int &iexp);
     void f1(double X[], double &fff);
+    void PREFIX(double G[], const double P[], int K, double XK);
+    void F1INC(const double G[], double X6, double &fff);
     void EIG3(double RM[], int ISTER, double E[]);
     void EIGGEN(double &E1, double &E2, double &E3, double &ALFA, double &BETA,
         double &GAMA, double &iso_vav, double &clvd_vav, double &dbcp_vav);
     void EIGGEN_NEW(double e1, double e2, double e3, double &iso, double &clvd,
         double &dbcp, double &iso_vav, double &clvd_vav, double &dbcp_vav);
-    void GSOL5(double x[], int &IEXP);
-    void GSOLA(double x[], int &IEXP);
+    int GSOL5(double x[], int &IEXP);
+    int GSOLA(double x[], int &IEXP);
     void XTRINF(int &ICOND, int LNORM, double Moment0[], double MomentErr[]);
     void f2(double x[], double &ffg);
+    void F2INC(const double G[], int K, double x[], double &ffg);
+    void DCTENSOR(double Strike, double Dip, double Rake, double d[]);
+    double DCMISFIT(const double d[], double &M0);
+    double DCFIT(const double r[], double &M0);
+    double DCSEARCH(double sdr[], double f, double step, const double R[3][3]);
+    double DCREFINE(double sdr[]);
+    void DCSCAN(const double SDR[][3], const double D[][5 + 1], int Nodes,
+        double Best[], double BestSDR[][3], int NBEST);
+    int GSOLDC(double x[], int &IEXP);
     void POSTEP(int &METH, int &ITER, int &IND1);
     double DETR(double T[], double X);
     void RENUM(double &TRY, double &VAL, int ix[], int &j1, int &j2, int &j3,
         int &j4);
+    void CHANNELS(int NMAX);
+    void CHANNELOUT(bool Influence);
+    //! Leverage and Cook's distance of the channels in the L2 solutions.
+    void INFLUENCE(void);
     void RDINP(Taquart::SMTInputData &InputData);
     void SIZEMM(int &IEXP);
+    void WARMSET(const Taquart::FaultSolutions * Start);
     void MOM2(bool REALLY, int QualityType);
+    //! Rows A of the L2 kernel of the P-wave amplitudes of all channels.
+    void KERNEL(void);
+    //! P-wave kernel row A[1..6] of a channel with the ray G[1..3] (as in RDINP,
+    //! density, velocity and distance are integers).
+    void KERNELROW(const double G[], int RO, int VEL, int R, double A[]);
+    //! Scalar (RM0) and total (RMT) seismic moment from eigenvalues E[1..3].
+    void SCALARMOMENT(const double E[], double &RM0, double &RMT);
     void INVMAT(double A[][10], double B[][10], int NP);
     void FIJGEN(void);
     void BETTER(double &RMY, double &RMZ, double &RM0, double &RMT, int &ICOND);
@@ -0,0 +1,198 @@
+//-----------------------------------------------------------------------------
+// Source: variants.cpp
+// Module: focimt
+// Inversion of input data variants in worker processes.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "variants.h"
+#include "solutioncache.h"
+
+//-----------------------------------------------------------------------------
+namespace {
+  //! Writes Size bytes, retrying interrupted and partial writes.
+  bool WriteAll(int fd, const void *Data, size_t Size) {
+    const char *p = (const char *) Data;
+    while (Size > 0) {
+      ssize_t n = write(fd, p, Size);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      p += n;
+      Size -= n;
+    }
+    return true;
+  }
+
+  //! Inverts the variants of one worker and sends their solutions to fd
+  //! as records [index][size][SolutionCache entry] (size 0 - failed).
+  void Work(const std::vector<Taquart::SMTInputData> &Variants,
+      const Taquart::InversionOptions &Options, int First, int Step, int fd) {
+    std::vector<char> Buffer;
+    for (int i = First; i < int(Variants.size()); i += Step) {
+      std::vector<Taquart::FaultSolutions> FSList;
+      Buffer.clear();
+      if (!Taquart::Invert(Variants[i], Options, FSList)
+          || !Taquart::SolutionCache::Encode(FSList, Buffer))
+        Buffer.clear();
+      unsigned long long Size = Buffer.size();
+      if (!WriteAll(fd, &i, sizeof(i)) || !WriteAll(fd, &Size, sizeof(Size))
+          || (Size > 0 && !WriteAll(fd, &Buffer[0], Buffer.size())))
+        return;
+    }
+  }
+
+  //! Decodes the complete records at the start of Data and removes them.
+  void Collect(std::vector<char> &Data,
+      std::vector<std::vector<Taquart::FaultSolutions> > &Results) {
+    const size_t Head = sizeof(int) + sizeof(unsigned long long);
+    size_t p = 0;
+    while (Data.size() - p >= Head) {
+      int i;
+      unsigned long long Size;
+      memcpy(&i, &Data[p], sizeof(i));
+      memcpy(&Size, &Data[p + sizeof(i)], sizeof(Size));
+      if (Data.size() - p - Head < Size)
+        break;
+      if (i >= 0 && i < int(Results.size()) && Size > 0)
+        Taquart::SolutionCache::Decode(&Data[p + Head], Size, Results[i]);
+      p += Head + Size;
+    }
+    Data.erase(Data.begin(), Data.begin() + p);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool Taquart::InvertVariants(
+    const std::vector<Taquart::SMTInputData> &Variants,
+    const Taquart::InversionOptions &Options, int Workers,
+    std::vector<std::vector<Taquart::FaultSolutions> > &Results) {
+  Results.clear();
+  Results.resize(Variants.size());
+  if (Workers <= 0)
+    Workers = sysconf(_SC_NPROCESSORS_ONLN);
+  if (Workers > int(Variants.size()))
+    Workers = Variants.size();
+
+  if (Workers <= 1) {
+    for (unsigned int i = 0; i < Variants.size(); i++)
+      if (!Taquart::Invert(Variants[i], Options, Results[i]))
+        Results[i].clear();
+    return true;
+  }
+
+  // Buffered output would be written again by every worker.
+  fflush(NULL);
+  std::cout.flush();
+
+  bool ok = true;
+  std::vector<pid_t> Pool;
+  std::vector<struct pollfd> Pipes;
+  for (int j = 0; j < Workers; j++) {
+    int fd[2];
+    if (pipe(fd) != 0) {
+      ok = false;
+      break;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fd[0]);
+      for (unsigned int k = 0; k < Pipes.size(); k++)
+        close(Pipes[k].fd);
+      Work(Variants, Options, j, Workers, fd[1]);
+      close(fd[1]);
+      _exit(0);
+    }
+    close(fd[1]);
+    if (pid < 0) {
+      close(fd[0]);
+      ok = false;
+      break;
+    }
+    Pool.push_back(pid);
+    struct pollfd p;
+    p.fd = fd[0];
+    p.events = POLLIN;
+    p.revents = 0;
+    Pipes.push_back(p);
+  }
+
+  // Workers are drained together, so none of them blocks on a full pipe.
+  std::vector<std::vector<char> > Data(Pipes.size());
+  unsigned int Open = Pipes.size();
+  char Chunk[65536];
+  while (Open > 0) {
+    if (poll(&Pipes[0], Pipes.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = false;
+      break;
+    }
+    for (unsigned int k = 0; k < Pipes.size(); k++) {
+      if (Pipes[k].fd < 0 || Pipes[k].revents == 0)
+        continue;
+      ssize_t n = read(Pipes[k].fd, Chunk, sizeof(Chunk));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n > 0) {
+        Data[k].insert(Data[k].end(), Chunk, Chunk + n);
+        Collect(Data[k], Results);
+      }
+      else {
+        close(Pipes[k].fd);
+        Pipes[k].fd = -1;
+        Open--;
+      }
+    }
+  }
+  for (unsigned int k = 0; k < Pipes.size(); k++)
+    if (Pipes[k].fd >= 0)
+      close(Pipes[k].fd);
+
+  for (unsigned int k = 0; k < Pool.size(); k++) {
+    int status;
+    if (waitpid(Pool[k], &status, 0) != Pool[k] || !WIFEXITED(status)
+        || WEXITSTATUS(status) != 0)
+      ok = false;
+  }
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+void Taquart::WriteVariant(std::ostream &Out, const Taquart::FaultSolution &s) {
+  char line[256];
+  sprintf(line, "%.6f\t%.4e\t%.2f\t%.2f\t%.2f\t%.2f\t"
+      "%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f", s.UERR, s.M0, s.MAGN, s.EXPL,
+      s.CLVD, s.DBCP, s.FIA, s.DLA, s.RAKEA, s.FIB, s.DLB, s.RAKEB);
+  Out << line;
+}
@@ -0,0 +1,63 @@
+//-----------------------------------------------------------------------------
+// Source: variants.h
+// Module: focimt
+// Inversion of input data variants in worker processes.
+//
+// Copyright (c) 2013-2017, Grzegorz Kwiatek.
+//
+// Permission is hereby granted, free of charge, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, reproduce, display, distribute,
+// execute, and transmit the Software, and to prepare derivative works of the
+// Software, and to permit third-parties to whom the Software is furnished to
+// do so, all subject to the following:
+//
+// The copyright notices in the Software and this entire statement, including
+// the above license grant, this restriction and the following disclaimer,
+// must be included in all copies of the Software, in whole or in part, and
+// all derivative works of the Software, unless such copies or derivative
+// works are solely in the form of machine-executable object code generated by
+// a source language processor.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+#ifndef VARIANTS_H_
+#define VARIANTS_H_
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include <vector>
+#include "focimtlib.h"
+
+namespace Taquart {
+
+  //! Inverts several variants of the input data of an event.
+  /*! The inversion keeps its state in UsmtCore, so the variants are split
+   *  between forked worker processes (variant i goes to worker i % Workers),
+   *  which return their solutions in the format of SolutionCache.
+   *  \param Variants Station data of the variants.
+   *  \param Options Inversion options, common to all variants.
+   *  \param Workers Number of processes (0 - one per processor, 1 - invert
+   *    in this process).
+   *  \param Results Solutions of each variant (empty if its inversion
+   *    failed).
+   *  \return \p false if a worker could not be started or died.
+   */
+  bool InvertVariants(const std::vector<Taquart::SMTInputData> &Variants,
+      const Taquart::InversionOptions &Options, int Workers,
+      std::vector<std::vector<Taquart::FaultSolutions> > &Results);
+
+  //! Writes the misfit and the source parameters of a solution.
+  /*! Columns (tab-separated): UERR, M0, MW, EXPL, CLVD, DBCP and strike,
+   *  dip and rake of both nodal planes.
+   */
+  void WriteVariant(std::ostream &Out, const Taquart::FaultSolution &s);
+}
+
+//-----------------------------------------------------------------------------
+#endif /* VARIANTS_H_ */